@@ -26,6 +26,15 @@
 
 #include "array2d.hpp"
 #include "logreg.hpp"
+#include "logreg_mp.hpp"
+#include "bagging.hpp"
+#include "dedup.hpp"
+#include "gbdt.hpp"
+#include "model.hpp"
+#include "incremental.hpp"
+#include "ingest.hpp"
+#include "scorer.hpp"
+#include "rank.hpp"
 #include "num.hpp"
 
 #include <vector>
@@ -35,17 +44,445 @@
 #include <cstdlib>
 #include <iterator>
 #include <map>
+#include <numeric>
+#include <utility>
 #include <tuple>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
 
 typedef double real_type;
 
-std::map<real_type, real_type>
-map_event_density(
+/*
+ * Columns of the trip records, training data has all of them, test data
+ * stops at TRAF4.
+ */
+struct trip
+{
+    enum col : num::size_type
+    {
+        ID,
+        SOURCE,
+        DIST,
+        CYCLES,
+        COMPLEXITY,
+        CARGO,
+        STOPS,
+        START_DAY,
+        START_MONTH,
+        START_DAY_OF_MONTH,
+        START_DAY_OF_WEEK,
+        START_TIME,
+        DAYS,
+        PILOT,
+        PILOT2,
+        PILOT_EXP,
+        PILOT_VISITS_PREV,
+        PILOT_HOURS_PREV,
+        PILOT_DUTY_HOURS_PREV,
+        PILOT_DIST_PREV,
+        ROUTE_RISK_1,
+        ROUTE_RISK_2,
+        WEATHER,
+        VISIBILITY,
+        TRAF0,
+        TRAF1,
+        TRAF2,
+        TRAF3,
+        TRAF4,
+        /////////////
+        ACCEL_CNT,
+        DECEL_CNT,
+        SPEED_CNT,
+        STABILITY_CNT,
+        EVT_CNT
+    };
+
+    static const char * const * names(void)
+    {
+        static const char * const NAMES[] =
+        {
+            "ID",
+            "SOURCE",
+            "DIST",
+            "CYCLES",
+            "COMPLEXITY",
+            "CARGO",
+            "STOPS",
+            "START_DAY",
+            "START_MONTH",
+            "START_DAY_OF_MONTH",
+            "START_DAY_OF_WEEK",
+            "START_TIME",
+            "DAYS",
+            "PILOT",
+            "PILOT2",
+            "PILOT_EXP",
+            "PILOT_VISITS_PREV",
+            "PILOT_HOURS_PREV",
+            "PILOT_DUTY_HOURS_PREV",
+            "PILOT_DIST_PREV",
+            "ROUTE_RISK_1",
+            "ROUTE_RISK_2",
+            "WEATHER",
+            "VISIBILITY",
+            "TRAF0",
+            "TRAF1",
+            "TRAF2",
+            "TRAF3",
+            "TRAF4",
+            "ACCEL_CNT",
+            "DECEL_CNT",
+            "SPEED_CNT",
+            "STABILITY_CNT",
+            "EVT_CNT",
+        };
+        static_assert(sizeof (NAMES) / sizeof (NAMES[0]) == EVT_CNT + 1, "a name for each column");
+
+        return NAMES;
+    }
+
+    static const char * name(col c)
+    {
+        assert(c <= EVT_CNT);
+        return names()[c];
+    }
+
+    /// column index by its name, e.g. "PILOT_EXP"; throws for unknown names
+    static col column(const std::string & name)
+    {
+        const char * const * NAMES = names();
+
+        const auto it = std::find(NAMES, NAMES + EVT_CNT + 1, name);
+        if (it == NAMES + EVT_CNT + 1)
+        {
+            throw std::invalid_argument("unknown column " + name);
+        }
+
+        return static_cast<col>(it - NAMES);
+    }
+};
+
+/*
+ * Model fitted by TripSafetyFactors and settings of the models other than
+ * logistic regression, which is set up with LogRegCfg.
+ */
+struct ModelCfg
+{
+    enum class Model
+    {
+        LogisticRegression, // do_log_reg
+        GBDT                // do_gbdt
+    };
+
+    ModelCfg()
+    :
+        m_model{Model::LogisticRegression},
+        m_gbdt{}
+    {}
+
+    Model model(void) const
+    {
+        return m_model;
+    }
+
+    ModelCfg & model(Model _model)
+    {
+        m_model = _model;
+        return *this;
+    }
+
+    const num::GbdtCfg<real_type> & gbdt(void) const
+    {
+        return m_gbdt;
+    }
+
+    ModelCfg & gbdt(const num::GbdtCfg<real_type> & _gbdt)
+    {
+        m_gbdt = _gbdt;
+        return *this;
+    }
+
+    Model m_model;
+    num::GbdtCfg<real_type> m_gbdt;
+};
+
+struct LogRegCfg
+{
+    /// way of fitting theta, parameters of the other ones are not used
+    enum class Fit
+    {
+        CG,                 // fmincg, full passes
+        Sharded,            // fmincg, cost/gradient in worker processes
+        MiniBatch,          // Adam over shuffled mini-batches
+        CoordinateDescent,  // L1 / elastic-net, sparse theta
+        Interactions,       // fmincg with products of feature pairs
+        OneHot,             // fmincg with one-hot encoded categories
+        Bagging,            // fmincg on bags of training rows
+        Downsampled,        // fmincg on all positives and some negatives
+        UniqueRows,         // fmincg on unique rows with label counts
+        Compact,            // fmincg on a dictionary/float encoded matrix
+        CollapsedRepeats    // fmincg on identical records as weighted rows
+    };
+
+    LogRegCfg()
+    :
+        m_C{0.02},
+        m_max_iter{200},
+        m_fit{Fit::CG},
+        m_workers{1},
+        m_minibatch{},
+        m_elastic_net{},
+        m_bagging{},
+        m_negative_rate{1.0},
+        m_downsample_seed{1},
+        m_model_path{},
+        m_density_columns{trip::SOURCE, trip::PILOT, trip::START_MONTH, trip::CYCLES, trip::PILOT_EXP},
+        m_theta0{},
+        m_interactions{},
+        m_one_hot_columns{},
+        m_rank_top_k{0},
+        m_rank_threads{1},
+        m_verbose{true}
+    {}
+
+    real_type C(void) const
+    {
+        return m_C;
+    }
+
+    LogRegCfg & C(real_type _c)
+    {
+        m_C = _c;
+        return *this;
+    }
+
+    num::size_type max_iter(void) const
+    {
+        return m_max_iter;
+    }
+
+    LogRegCfg & max_iter(num::size_type _max_iter)
+    {
+        m_max_iter = _max_iter;
+        return *this;
+    }
+
+    Fit fit(void) const
+    {
+        return m_fit;
+    }
+
+    LogRegCfg & fit(Fit _fit)
+    {
+        m_fit = _fit;
+        return *this;
+    }
+
+    num::size_type workers(void) const
+    {
+        return m_workers;
+    }
+
+    /// number of processes evaluating cost/gradient of Fit::Sharded
+    LogRegCfg & workers(num::size_type _workers)
+    {
+        m_workers = _workers;
+        return *this;
+    }
+
+    const num::MiniBatchCfg<real_type> & minibatch(void) const
+    {
+        return m_minibatch;
+    }
+
+    LogRegCfg & minibatch(const num::MiniBatchCfg<real_type> & _minibatch)
+    {
+        m_minibatch = _minibatch;
+        return *this;
+    }
+
+    const num::ElasticNetCfg<real_type> & elastic_net(void) const
+    {
+        return m_elastic_net;
+    }
+
+    /// penalty and stopping of Fit::CoordinateDescent, C is not used by it
+    LogRegCfg & elastic_net(const num::ElasticNetCfg<real_type> & _elastic_net)
+    {
+        m_elastic_net = _elastic_net;
+        return *this;
+    }
+
+    const num::BaggingCfg<real_type> & bagging(void) const
+    {
+        return m_bagging;
+    }
+
+    /// ensemble of models of Fit::Bagging, at least one bag
+    LogRegCfg & bagging(const num::BaggingCfg<real_type> & _bagging)
+    {
+        m_bagging = _bagging;
+        return *this;
+    }
+
+    real_type negative_rate(void) const
+    {
+        return m_negative_rate;
+    }
+
+    /// fraction of negative rows kept for training by Fit::Downsampled, kept
+    /// ones get weight 1 / rate; in (0, 1], std::invalid_argument otherwise
+    LogRegCfg & negative_rate(real_type _negative_rate)
+    {
+        if (!(_negative_rate > 0.0 && _negative_rate <= 1.0))
+        {
+            throw std::invalid_argument("negative rate not in (0, 1]: " + std::to_string(_negative_rate));
+        }
+        m_negative_rate = _negative_rate;
+        return *this;
+    }
+
+    unsigned int downsample_seed(void) const
+    {
+        return m_downsample_seed;
+    }
+
+    LogRegCfg & downsample_seed(unsigned int _downsample_seed)
+    {
+        m_downsample_seed = _downsample_seed;
+        return *this;
+    }
+
+    const std::string & model_path(void) const
+    {
+        return m_model_path;
+    }
+
+    /// where to save the fitted model, nothing is saved if empty
+    LogRegCfg & model_path(const std::string & _model_path)
+    {
+        m_model_path = _model_path;
+        return *this;
+    }
+
+    const std::vector<num::size_type> & density_columns(void) const
+    {
+        return m_density_columns;
+    }
+
+    /// features (trip::col) remapped to event density before fitting
+    LogRegCfg & density_columns(const std::vector<num::size_type> & _density_columns)
+    {
+        m_density_columns = _density_columns;
+        return *this;
+    }
+
+    const std::valarray<real_type> & theta0(void) const
+    {
+        return m_theta0;
+    }
+
+    /// starting point of the solver, e.g. theta fitted for a neighbouring C;
+    /// ignored unless it matches the number of features plus intercept
+    LogRegCfg & theta0(const std::valarray<real_type> & _theta0)
+    {
+        m_theta0 = _theta0;
+        return *this;
+    }
+
+    const num::interactions_type & interactions(void) const
+    {
+        return m_interactions;
+    }
+
+    /// products of feature pairs (trip::col) added to the model by
+    /// Fit::Interactions, computed on the fly from standardized features
+    LogRegCfg & interactions(const num::interactions_type & _interactions)
+    {
+        m_interactions = _interactions;
+        return *this;
+    }
+
+    const std::vector<num::size_type> & one_hot_columns(void) const
+    {
+        return m_one_hot_columns;
+    }
+
+    /// categorical features (trip::col) additionally one-hot encoded by
+    /// Fit::OneHot into a sparse block of indicators, one coefficient per
+    /// category seen in training
+    LogRegCfg & one_hot_columns(const std::vector<num::size_type> & _one_hot_columns)
+    {
+        m_one_hot_columns = _one_hot_columns;
+        return *this;
+    }
+
+    num::size_type rank_top_k(void) const
+    {
+        return m_rank_top_k;
+    }
+
+    /// rank only this many best scores exactly, 0 ranks everything
+    LogRegCfg & rank_top_k(num::size_type _rank_top_k)
+    {
+        m_rank_top_k = _rank_top_k;
+        return *this;
+    }
+
+    num::size_type rank_threads(void) const
+    {
+        return m_rank_threads;
+    }
+
+    LogRegCfg & rank_threads(num::size_type _rank_threads)
+    {
+        m_rank_threads = _rank_threads;
+        return *this;
+    }
+
+    bool verbose(void) const
+    {
+        return m_verbose;
+    }
+
+    /// diagnostics to std::cerr
+    LogRegCfg & verbose(bool _verbose)
+    {
+        m_verbose = _verbose;
+        return *this;
+    }
+
+    real_type m_C;
+    num::size_type m_max_iter;
+    Fit m_fit;
+    num::size_type m_workers;
+    num::MiniBatchCfg<real_type> m_minibatch;
+    num::ElasticNetCfg<real_type> m_elastic_net;
+    num::BaggingCfg<real_type> m_bagging;
+    real_type m_negative_rate;
+    unsigned int m_downsample_seed;
+    std::string m_model_path;
+    std::vector<num::size_type> m_density_columns;
+    std::valarray<real_type> m_theta0;
+    num::interactions_type m_interactions;
+    std::vector<num::size_type> m_one_hot_columns;
+    num::size_type m_rank_top_k;
+    num::size_type m_rank_threads;
+    bool m_verbose;
+};
+
+/*
+ * Occurrences and sums of events of every distinct value of feat. Counts
+ * of new rows can be added to existing ones, see IncrementalModel.
+ */
+num::event_counts_type
+count_events(
     const std::valarray<real_type> & feat,
     const std::valarray<real_type> & y
 )
 {
-    std::map<real_type, std::pair<num::size_type, num::size_type>> event_count;
+    num::event_counts_type event_count;
 
     assert(feat.size() == y.size());
 
@@ -55,20 +492,149 @@ map_event_density(
         event_count[feat[r]].second += y[r];
     }
 
+    return event_count;
+}
+
+std::map<real_type, real_type>
+map_event_density(const num::event_counts_type & event_count)
+{
     std::map<real_type, real_type> result;
 
     for (auto count : event_count)
     {
-        result[count.first] = (real_type)count.second.second / count.second.first;
+        result[count.first] = count.second.second / count.second.first;
+    }
+
+    return result;
+}
+
+/*
+ * Turns scores into 1-based ranks, highest score gets rank 1.
+ */
+std::vector<int> rank_predictions(const std::valarray<real_type> & pred, const LogRegCfg & cfg)
+{
+    const std::vector<int> result = cfg.rank_top_k() ?
+        num::ranks_descending_top_k(std::begin(pred), pred.size(), cfg.rank_top_k()) :
+        num::ranks_descending(std::begin(pred), pred.size(), cfg.rank_threads());
+
+    if (cfg.verbose() && result.size() >= 10)
+    {
+        std::copy(result.cbegin(), result.cbegin() + 10, std::ostream_iterator<int>(std::cerr, " "));
+        std::cerr << std::endl;
+        std::copy(result.cend() - 10, result.cend(), std::ostream_iterator<int>(std::cerr, " "));
+        std::cerr << std::endl;
     }
 
     return result;
 }
 
+/*
+ * Fits of do_log_reg that need more than a single call, over standardized
+ * X with the intercept column; rows visited are added to rows_visited.
+ */
+std::vector<std::valarray<real_type>> fit_bags(
+    const num::array2d<real_type> & X,
+    const std::valarray<real_type> & y,
+    const std::valarray<real_type> & theta,
+    const LogRegCfg & cfg,
+    num::size_type & rows_visited
+)
+{
+    if (cfg.bagging().bags() == 0)
+    {
+        throw std::invalid_argument("bagging without bags");
+    }
+
+    // bagged models share X, each fits its own row index view of it
+    return num::fit_bagged<real_type>(X, y, theta, cfg.C(), cfg.max_iter(), cfg.bagging(), &rows_visited);
+}
+
+std::valarray<real_type> fit_downsampled_rows(
+    const num::array2d<real_type> & X,
+    const std::valarray<real_type> & y,
+    const std::valarray<real_type> & theta,
+    const LogRegCfg & cfg,
+    num::size_type & rows_visited
+)
+{
+    // all positives and a sample of negatives, importance weighted
+    const std::pair<std::vector<num::size_type>, std::valarray<real_type>> sample =
+        num::downsample_negatives(y, cfg.negative_rate(), cfg.downsample_seed());
+
+    if (cfg.verbose())
+    {
+        std::cerr << "downsampled training rows: " << sample.first.size() << " of " << y.size() << std::endl;
+    }
+
+    return num::fit_rows<real_type>(X, y, sample.first, sample.second, theta, cfg.C(), cfg.max_iter(), &rows_visited);
+}
+
+std::valarray<real_type> fit_unique_rows(
+    const num::array2d<real_type> & X,
+    const std::valarray<real_type> & y,
+    const std::valarray<real_type> & theta,
+    const LogRegCfg & cfg,
+    num::size_type & rows_visited
+)
+{
+    const num::UniqueRows<real_type> unique = num::dedup_rows(X, y);
+
+    if (cfg.verbose())
+    {
+        std::cerr << "unique training rows: " << unique.X.shape().first << " of " << y.size() << std::endl;
+    }
+
+    return num::fit_counts(unique.X, unique.pos, unique.neg, theta, cfg.C(), cfg.max_iter(), &rows_visited);
+}
+
+std::valarray<real_type> fit_compact_rows(
+    const num::array2d<real_type> & X,
+    const std::valarray<real_type> & y,
+    const std::valarray<real_type> & theta,
+    const LogRegCfg & cfg,
+    num::size_type & rows_visited
+)
+{
+    const num::CompactMatrix<real_type> compact(X);
+
+    if (cfg.verbose())
+    {
+        std::cerr << "compact training matrix [bytes]: " << compact.nbytes()
+            << ", dense: " << X.shape().first * X.shape().second * sizeof (real_type) << std::endl;
+    }
+
+    return num::fit_compact(compact, y, theta, cfg.C(), cfg.max_iter(), &rows_visited);
+}
+
+std::valarray<real_type> fit_collapsed_rows(
+    const num::array2d<real_type> & X,
+    const std::valarray<real_type> & y,
+    const std::valarray<real_type> & theta,
+    const LogRegCfg & cfg,
+    num::size_type & rows_visited
+)
+{
+    auto collapsed = num::collapse_repeats(X, y);
+
+    if (cfg.verbose())
+    {
+        std::cerr << "collapsed training rows: " << std::get<1>(collapsed).size() << " of " << y.size()
+            << ", weight runs: " << std::get<2>(collapsed).nruns() << std::endl;
+    }
+
+    const num::LogisticRegression<real_type> collapsedClassifier(
+        std::move(std::get<0>(collapsed)), std::move(std::get<1>(collapsed)),
+        std::valarray<real_type>{theta}, cfg.C(), cfg.max_iter());
+
+    return collapsedClassifier.fit_weighted(std::get<2>(collapsed), &rows_visited);
+}
+
 std::vector<int> do_log_reg(
     num::array2d<real_type> && i_X_train,
     std::valarray<real_type> && i_y_train,
-    num::array2d<real_type> && i_X_test
+    num::array2d<real_type> && i_X_test,
+    const LogRegCfg & cfg = LogRegCfg(),
+    std::valarray<real_type> * o_theta = nullptr
 )
 {
     typedef num::array2d<real_type> array_type;
@@ -132,19 +698,44 @@ std::vector<int> do_log_reg(
     // a number of occurences and a sum of events,
     // then we remap the original values to event density
 
-    for (auto COLUMN :
-        std::initializer_list<int>
+    typedef LogRegCfg::Fit Fit;
+
+    // extra terms of the model, only their own fit knows them
+    const std::vector<num::size_type> one_hot_columns =
+        cfg.fit() == Fit::OneHot ? cfg.one_hot_columns() : std::vector<num::size_type>{};
+    const num::interactions_type interactions =
+        cfg.fit() == Fit::Interactions ? cfg.interactions() : num::interactions_type{};
+
+    for (auto COLUMN : one_hot_columns)
+    {
+        if (COLUMN <= col::INTERCEPT || COLUMN >= NUM_FEAT)
         {
-            col::SOURCE,
-            col::PILOT,
-            col::START_MONTH,
-            col::CYCLES,
-            col::PILOT_EXP,
+            throw std::invalid_argument("one-hot encoding of a non-feature column");
         }
-    )
+    }
+
+    // categories of raw values, before density mapping
+    const num::OneHotEncoder<real_type> one_hot(X_train, one_hot_columns);
+    const num::csr_matrix<real_type> S_train = one_hot.encode(X_train);
+    const num::csr_matrix<real_type> S_test = one_hot.encode(X_test);
+
+    if (cfg.verbose() && one_hot.ncols())
     {
-        auto event_density = map_event_density(X_train[X_train.column(COLUMN)], i_y_train);
-        std::cerr << "event density size: " << event_density.size() << std::endl;
+        std::cerr << "one-hot columns: " << one_hot.ncols() << ", nonzeros: " << S_train.nnz() << std::endl;
+    }
+
+    num::density_counts_type density_counts;
+
+    for (auto COLUMN : cfg.density_columns())
+    {
+        assert(COLUMN > col::INTERCEPT && COLUMN < NUM_FEAT);
+
+        num::event_counts_type event_count = count_events(X_train[X_train.column(COLUMN)], i_y_train);
+        auto event_density = map_event_density(event_count);
+        if (cfg.verbose())
+        {
+            std::cerr << "event density size: " << event_density.size() << std::endl;
+        }
 
         vector_type mapped_train_col = X_train[X_train.column(COLUMN)];
         std::transform(std::begin(mapped_train_col), std::end(mapped_train_col), std::begin(mapped_train_col),
@@ -155,14 +746,7 @@ std::vector<int> do_log_reg(
         );
         X_train[X_train.column(COLUMN)] = mapped_train_col;
 
-        vector_type mapped_test_col = X_test[X_test.column(COLUMN)];
-        std::transform(std::begin(mapped_test_col), std::end(mapped_test_col), std::begin(mapped_test_col),
-            [&event_density](const real_type & x) -> real_type
-            {
-                return event_density[x];
-            }
-        );
-        X_test[X_test.column(COLUMN)] = mapped_test_col;
+        density_counts.emplace_back(COLUMN, std::move(event_count));
     }
 
 
@@ -173,177 +757,429 @@ std::vector<int> do_log_reg(
         }
     );
 
-    vector_type theta(0.0, X_train.shape().second);
+    for (const auto & ab : interactions)
+    {
+        if (ab.first <= col::INTERCEPT || ab.first >= NUM_FEAT || ab.second <= col::INTERCEPT || ab.second >= NUM_FEAT)
+        {
+            throw std::invalid_argument("interaction of a non-feature column");
+        }
+    }
+
+    const num::size_type NCOLS = X_train.shape().second;
+    const num::size_type NTHETA = NCOLS + interactions.size() + one_hot.ncols();
+    const bool extended = NTHETA != NCOLS;
+
+    vector_type theta =
+        cfg.theta0().size() == NTHETA ?
+            cfg.theta0() :
+            vector_type(0.0, NTHETA);
 
     // standardization
+    vector_type mu(0.0, X_train.shape().second);
+    vector_type dev(1.0, X_train.shape().second);
+
     for (num::size_type c{1}; c < X_train.shape().second; ++c)
     {
         const vector_type & col = X_train[X_train.column(c)];
-        const vector_type & colt = X_test[X_test.column(c)];
 
-        const real_type mu = num::mean<real_type>(col);
-        const real_type dev = num::std<real_type>(col);
+        mu[c] = num::mean<real_type>(col);
+        dev[c] = num::std<real_type>(col);
 
-        X_train[X_train.column(c)] = col - mu;
-        X_train[X_train.column(c)] = col / dev;
-
-        X_test[X_test.column(c)] = colt - mu;
-        X_test[X_test.column(c)] = colt / dev;
+        X_train[X_train.column(c)] = (col - mu[c]) / dev[c];
     }
 
     num::LogisticRegression<real_type> logRegClassifier(
         num::LogisticRegression<real_type>::array_type{X_train},
         num::LogisticRegression<real_type>::vector_type{y_train},
         num::LogisticRegression<real_type>::vector_type{theta},
-        0.02,
-        200
+        cfg.C(),
+        cfg.max_iter(),
+        interactions
     );
 
-    auto fit_theta = logRegClassifier.fit();
+    num::size_type rows_visited{0};
+
+    // bags are represented by their mean theta, whose margin is the mean
+    // margin of the bags
+    std::vector<vector_type> bag_thetas;
+    vector_type fit_theta;
+
+    switch (cfg.fit())
+    {
+    case Fit::CG:
+        fit_theta = logRegClassifier.fit(&rows_visited);
+        break;
+    case Fit::Sharded:
+        fit_theta = num::fit_sharded<real_type>(X_train, y_train, theta, cfg.C(), cfg.max_iter(), cfg.workers(), &rows_visited);
+        break;
+    case Fit::MiniBatch:
+        fit_theta = logRegClassifier.fit(cfg.minibatch(), &rows_visited);
+        break;
+    case Fit::CoordinateDescent:
+        fit_theta = logRegClassifier.fit(cfg.elastic_net(), &rows_visited);
+        break;
+    case Fit::Interactions:
+        fit_theta = logRegClassifier.fit(&rows_visited);
+        break;
+    case Fit::OneHot:
+        fit_theta = num::fit_hybrid<real_type>(X_train, S_train, y_train, theta, cfg.C(), cfg.max_iter(), &rows_visited);
+        break;
+    case Fit::Bagging:
+        bag_thetas = fit_bags(X_train, y_train, theta, cfg, rows_visited);
+        fit_theta = std::accumulate(bag_thetas.cbegin() + 1, bag_thetas.cend(), bag_thetas.front()) / (real_type)bag_thetas.size();
+        break;
+    case Fit::Downsampled:
+        fit_theta = fit_downsampled_rows(X_train, y_train, theta, cfg, rows_visited);
+        break;
+    case Fit::UniqueRows:
+        fit_theta = fit_unique_rows(X_train, y_train, theta, cfg, rows_visited);
+        break;
+    case Fit::Compact:
+        fit_theta = fit_compact_rows(X_train, y_train, theta, cfg, rows_visited);
+        break;
+    case Fit::CollapsedRepeats:
+        fit_theta = fit_collapsed_rows(X_train, y_train, theta, cfg, rows_visited);
+        break;
+    }
+
+    if (cfg.verbose())
+    {
+        std::cerr << "passes over training data: " << (real_type)rows_visited / X_train.shape().first << std::endl;
+        std::cerr << "nonzero coefficients: "
+            << std::count_if(std::begin(fit_theta), std::end(fit_theta), [](real_type v) { return v != 0.0; })
+            << " of " << fit_theta.size() << std::endl;
+    }
 
 //    std::copy(std::begin(fit_theta), std::end(fit_theta), std::ostream_iterator<real_type>(std::cerr, "\n"));
 
-    auto pred = logRegClassifier.predict(X_test, fit_theta, false);
-//    std::copy(std::begin(pred), std::end(pred), std::ostream_iterator<real_type>(std::cerr, "\n"));
-    std::cerr << "pred.max() " << pred.max() << std::endl;
+    // everything needed to score new data, test features are encoded
+    // through it, so that a persisted model behaves exactly the same
+    // interaction and one-hot terms are not part of the model format,
+    // encoding needs the base coefficients only
+    const std::vector<std::uint64_t> model_words =
+        num::serialize_model(vector_type(fit_theta[std::slice(0, NCOLS, 1)]), mu, dev, density_counts, X_train.shape().first);
+    const num::ModelView model(model_words.data(), model_words.size() * sizeof (std::uint64_t));
+
+    if (o_theta)
+    {
+        *o_theta = fit_theta;
+    }
 
-    std::vector<int> result(i_X_test.shape().first);
+    typedef num::BaggingCfg<real_type>::Combine Combine;
 
-    std::vector<std::tuple<num::size_type, num::size_type, real_type>> zipped;
-    zipped.reserve(pred.size());
+    // a single model stands for the bags only if they are combined by margin
+    const bool mean_of_bags = !bag_thetas.empty() && cfg.bagging().combine() != Combine::Margin;
 
-    for (num::size_type idx = 0; idx < pred.size(); ++idx)
+    if (!cfg.model_path().empty() && extended)
     {
-        zipped.emplace_back(idx + 1, 0, pred[idx]);
+        std::cerr << "model with interactions or one-hot columns not saved to " << cfg.model_path() << std::endl;
     }
-    std::sort(zipped.begin(), zipped.end(),
-        [](const std::tuple<num::size_type, num::size_type, real_type> & p, const std::tuple<num::size_type, num::size_type, real_type> & q)
+    else if (!cfg.model_path().empty() && mean_of_bags)
+    {
+        std::cerr << "bags combined by score or rank not saved to " << cfg.model_path() << std::endl;
+    }
+    else if (!cfg.model_path().empty())
+    {
+        num::save_model(cfg.model_path(), model_words);
+        std::cerr << "model saved to " << cfg.model_path() << std::endl;
+    }
+
+    model.encode(X_test);
+
+    vector_type pred = one_hot.ncols() ?
+        logRegClassifier.predict(X_test, S_test, fit_theta, false) :
+        logRegClassifier.predict(X_test, fit_theta, false);
+
+    if (mean_of_bags && cfg.bagging().combine() == Combine::Score)
+    {
+        // mean probability, unlike the mean margin not a single model's
+        pred = 0.0;
+        for (const auto & bag_theta : bag_thetas)
         {
-            return std::get<2>(p) > std::get<2>(q);
+            pred += logRegClassifier.predict(X_test, bag_theta, false) / (real_type)bag_thetas.size();
         }
-    );
-    for (num::size_type idx = 0; idx < pred.size(); ++idx)
-    {
-        std::get<1>(zipped[idx]) = idx + 1;
     }
-    std::sort(zipped.begin(), zipped.end(),
-        [](const std::tuple<num::size_type, num::size_type, real_type> & p, const std::tuple<num::size_type, num::size_type, real_type> & q)
+    else if (mean_of_bags && cfg.bagging().combine() == Combine::Rank)
+    {
+        // lower mean rank has to score higher
+        pred = 0.0;
+        for (const auto & bag_theta : bag_thetas)
         {
-            return std::get<0>(p) < std::get<0>(q);
+            const vector_type bag_pred = logRegClassifier.predict(X_test, bag_theta, false);
+            const std::vector<int> ranks = num::ranks_descending(std::begin(bag_pred), bag_pred.size(), cfg.rank_threads());
+
+            for (num::size_type r{0}; r < pred.size(); ++r)
+            {
+                pred[r] -= (real_type)ranks[r] / bag_thetas.size();
+            }
         }
-    );
-    std::transform(zipped.cbegin(), zipped.cend(), result.begin(),
-        [](const std::tuple<num::size_type, num::size_type, real_type> & p)
+    }
+//    std::copy(std::begin(pred), std::end(pred), std::ostream_iterator<real_type>(std::cerr, "\n"));
+    if (cfg.verbose())
+    {
+        std::cerr << "pred.max() " << pred.max() << std::endl;
+    }
+
+    return rank_predictions(pred, cfg);
+}
+
+/*
+ * Alternative to do_log_reg: gradient boosted trees on raw features. Trees
+ * split non-monotonic columns (SOURCE, PILOT, ...) on their own, so there
+ * is neither event density encoding nor standardization. Of cfg only the
+ * ranking, diagnostics and model path settings apply.
+ */
+std::vector<int> do_gbdt(
+    num::array2d<real_type> && i_X_train,
+    std::valarray<real_type> && i_y_train,
+    num::array2d<real_type> && i_X_test,
+    const num::GbdtCfg<real_type> & gbdt_cfg,
+    const LogRegCfg & cfg = LogRegCfg()
+)
+{
+    const std::valarray<real_type> y_train = i_y_train.apply(
+        [](real_type v)
         {
-            return (int)std::get<1>(p);
+            return v > 1.0 ? 1.0 : v;
         }
     );
 
-    std::copy(result.cbegin(), result.cbegin() + 10, std::ostream_iterator<int>(std::cerr, " "));
-    std::cerr << std::endl;
-    std::copy(result.cend() - 10, result.cend(), std::ostream_iterator<int>(std::cerr, " "));
-    std::cerr << std::endl;
+    if (!cfg.model_path().empty())
+    {
+        std::cerr << "model persistence is supported for logistic regression only, not saving" << std::endl;
+    }
 
-    return result;
+    num::GradientBoostedTrees<real_type> gbdt(gbdt_cfg);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    gbdt.fit(i_X_train, y_train);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    if (cfg.verbose())
+    {
+        std::cerr << "gbdt: " << gbdt.ntrees() << " trees, fit time [s]: "
+            << std::chrono::duration<double>(t1 - t0).count() << std::endl;
+    }
+
+    // ranking needs margins only
+    return rank_predictions(gbdt.margins(i_X_test), cfg);
 }
 
 struct TripSafetyFactors
 {
+    typedef trip::col col;
+
+    TripSafetyFactors(const LogRegCfg & cfg = LogRegCfg(), const ModelCfg & model_cfg = ModelCfg())
+    :
+        m_cfg(cfg),
+        m_model_cfg(model_cfg)
+    {}
+
+    typedef std::vector<num::size_type> rows_type;
+
     std::vector<int> predict(
         std::vector<std::string> i_train_data,
         std::vector<std::string> i_test_data) const;
-};
 
-std::vector<int>
-TripSafetyFactors::predict(
-    std::vector<std::string> i_train_data,
-    std::vector<std::string> i_test_data) const
-{
-    enum col : num::size_type
-    {
-        ID,
-        SOURCE,
-        DIST,
-        CYCLES,
-        COMPLEXITY,
-        CARGO,
-        STOPS,
-        START_DAY,
-        START_MONTH,
-        START_DAY_OF_MONTH,
-        START_DAY_OF_WEEK,
-        START_TIME,
-        DAYS,
-        PILOT,
-        PILOT2,
-        PILOT_EXP,
-        PILOT_VISITS_PREV,
-        PILOT_HOURS_PREV,
-        PILOT_DUTY_HOURS_PREV,
-        PILOT_DIST_PREV,
-        ROUTE_RISK_1,
-        ROUTE_RISK_2,
-        WEATHER,
-        VISIBILITY,
-        TRAF0,
-        TRAF1,
-        TRAF2,
-        TRAF3,
-        TRAF4,
-        /////////////
-        ACCEL_CNT,
-        DECEL_CNT,
-        SPEED_CNT,
-        STABILITY_CNT,
-        EVT_CNT
-    };
+    /*
+     * Same as above, parsed in place from lines held by the caller,
+     * e.g. views into one buffer (see num::split_lines)
+     */
+    std::vector<int> predict(
+        const std::vector<num::string_ref> & train_lines,
+        const std::vector<num::string_ref> & test_lines) const;
 
-    typedef num::array2d<real_type> array_type;
-    typedef std::valarray<real_type> vector_type;
+    /*
+     * Same as above, with train and test rows selected by index from one
+     * parsed data set (all columns, EVT_CNT included). Rows are gathered
+     * into the model's matrices only, the data set is not modified.
+     */
+    std::vector<int> predict(
+        const num::array2d<real_type> & data,
+        const rows_type & train_rows,
+        const rows_type & test_rows) const;
 
-    const num::size_type TRAIN_ROWS{i_train_data.size()};
-    constexpr num::size_type TRAIN_COLS{34};
+    /// predict-only, scores test data with a previously fitted model
+    std::vector<int> predict(
+        const num::ModelView & model,
+        std::vector<std::string> i_test_data) const;
 
-    const num::size_type TEST_ROWS{i_test_data.size()};
-    constexpr num::size_type TEST_COLS{29};
+    std::vector<int> predict(
+        const num::ModelView & model,
+        const std::vector<num::string_ref> & test_lines) const;
 
-    const num::shape_type TRAIN_SHAPE{TRAIN_ROWS, TRAIN_COLS};
-    const num::shape_type TEST_SHAPE{TEST_ROWS, TEST_COLS};
+    /// model updated with new training rows only, serialized
+    std::vector<std::uint64_t> update(
+        const num::ModelView & model,
+        std::vector<std::string> i_train_data) const;
 
-    ////////////////////////////////////////////////////////////////////////////
+    /*
+     * Coefficients of model refitted with the mini-batch solver over the
+     * training rows of is, streamed through a shuffle buffer of
+     * shuffle_capacity rows instead of being loaded; density tables and
+     * standardization of model are kept. Serialized.
+     */
+    std::vector<std::uint64_t> refine(
+        const num::ModelView & model,
+        std::istream & is,
+        num::size_type shuffle_capacity) const;
+
+    static real_type time_xlt(const char * str);
+
+    static num::array2d<real_type> load(std::vector<std::string> && lines);
+
+    static num::array2d<real_type> load(const std::vector<num::string_ref> & lines);
+
+    /// same as load over all lines of is, read, parsed and assembled concurrently
+    static num::array2d<real_type> ingest(
+        std::istream & is,
+        num::size_type parsers = std::max(1u, std::thread::hardware_concurrency()),
+        num::IngestStats * o_stats = nullptr);
+
+    /// features (SOURCE ... TRAF4) of selected rows of a parsed data set
+    static num::array2d<real_type> gather_features(const num::array2d<real_type> & data, const rows_type & rows);
+
+    /// EVT_CNT of selected rows of a parsed data set
+    static std::valarray<real_type> gather_labels(const num::array2d<real_type> & data, const rows_type & rows);
+
+    const LogRegCfg m_cfg;
+    const ModelCfg m_model_cfg;
+
+private:
+    /// train data with all columns, test data with features at least
+    std::vector<int> predict(
+        num::array2d<real_type> && train_data,
+        num::array2d<real_type> && test_data) const;
+
+    std::vector<int> predict(
+        const num::ModelView & model,
+        num::array2d<real_type> && test_data) const;
+};
 
-    auto time_xlt = [](const char * str) -> real_type
+real_type
+TripSafetyFactors::time_xlt(const char * str)
+{
+    char * next;
+    long int result = std::strtol(str, &next, 10) * 60;
+    if (*next == ':')
     {
-        char * next;
-        long int result = std::strtol(str, &next, 10) * 60;
-        if (*next == ':')
-        {
-//            result += std::strtol(next + 1, nullptr, 10);
-        }
-        return result;
-    };
-    array_type train_data =
+//        result += std::strtol(next + 1, nullptr, 10);
+    }
+    return result;
+}
+
+num::array2d<real_type>
+TripSafetyFactors::load(std::vector<std::string> && lines)
+{
+    return
         num::loadtxt(
-            std::move(i_train_data),
+            std::move(lines),
             std::move(
                 num::loadtxtCfg<real_type>()
                 .delimiter(',')
                 .converters({{col::START_TIME, time_xlt}})
             )
         );
-    std::cerr << train_data.shape() << std::endl;
+}
 
-    array_type test_data =
+num::array2d<real_type>
+TripSafetyFactors::load(const std::vector<num::string_ref> & lines)
+{
+    return
         num::loadtxt(
-            std::move(i_test_data),
-            std::move(
-                num::loadtxtCfg<real_type>()
-                .delimiter(',')
-                .converters({{col::START_TIME, time_xlt}})
-            )
+            lines,
+            num::loadtxtCfg<real_type>()
+            .delimiter(',')
+            .converters({{col::START_TIME, time_xlt}})
+        );
+}
+
+num::array2d<real_type>
+TripSafetyFactors::ingest(std::istream & is, num::size_type parsers, num::IngestStats * o_stats)
+{
+    return
+        num::ingest_matrix(
+            is,
+            num::IngestCfg<real_type>()
+            .delimiter(',')
+            .converters({{col::START_TIME, time_xlt}})
+            .parsers(parsers),
+            o_stats
         );
+}
+
+num::array2d<real_type>
+TripSafetyFactors::gather_features(const num::array2d<real_type> & data, const rows_type & rows)
+{
+    const num::size_type NCOLS = data.shape().second;
+    const num::size_type NFEAT = col::TRAF4 - col::SOURCE + 1;
+
+    assert(NCOLS > col::TRAF4);
+
+    num::array2d<real_type> X({rows.size(), NFEAT}, 0.0);
+    for (num::size_type r{0}; r < rows.size(); ++r)
+    {
+        X[X.row(r)] = data[std::slice(rows[r] * NCOLS + col::SOURCE, NFEAT, 1)];
+    }
+    return X;
+}
+
+std::valarray<real_type>
+TripSafetyFactors::gather_labels(const num::array2d<real_type> & data, const rows_type & rows)
+{
+    const num::size_type NCOLS = data.shape().second;
+
+    assert(NCOLS > col::EVT_CNT);
+
+    std::valarray<real_type> y(rows.size());
+    for (num::size_type r{0}; r < rows.size(); ++r)
+    {
+        y[r] = data.data()[rows[r] * NCOLS + col::EVT_CNT];
+    }
+    return y;
+}
+
+std::vector<int>
+TripSafetyFactors::predict(
+    const num::array2d<real_type> & data,
+    const rows_type & train_rows,
+    const rows_type & test_rows) const
+{
+    return m_model_cfg.model() == ModelCfg::Model::GBDT ?
+        do_gbdt(gather_features(data, train_rows), gather_labels(data, train_rows), gather_features(data, test_rows), m_model_cfg.gbdt(), m_cfg) :
+        do_log_reg(gather_features(data, train_rows), gather_labels(data, train_rows), gather_features(data, test_rows), m_cfg);
+}
+
+std::vector<int>
+TripSafetyFactors::predict(
+    std::vector<std::string> i_train_data,
+    std::vector<std::string> i_test_data) const
+{
+    return predict(load(std::move(i_train_data)), load(std::move(i_test_data)));
+}
+
+std::vector<int>
+TripSafetyFactors::predict(
+    const std::vector<num::string_ref> & train_lines,
+    const std::vector<num::string_ref> & test_lines) const
+{
+    return predict(load(train_lines), load(test_lines));
+}
+
+std::vector<int>
+TripSafetyFactors::predict(
+    num::array2d<real_type> && train_data,
+    num::array2d<real_type> && test_data) const
+{
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+
+    std::cerr << train_data.shape() << std::endl;
     std::cerr << test_data.shape() << std::endl;
 
+    assert(train_data.shape().second > col::EVT_CNT);
+    assert(test_data.shape().second > col::TRAF4);
+
     ////////////////////////////////////////////////////////////////////////////
 
     array_type X_train_data({train_data.shape().first, col::TRAF4 - col::SOURCE + 1}, 0.0);
@@ -352,17 +1188,146 @@ TripSafetyFactors::predict(
 
     vector_type y_train_data = train_data[train_data.column(col::EVT_CNT)];
 
-    array_type X_test_data({test_data.shape().first, test_data.shape().second - 1}, 0.0);
+    array_type X_test_data({test_data.shape().first, col::TRAF4 - col::SOURCE + 1}, 0.0);
 
     X_test_data[X_test_data.columns(0, -1)] = test_data[test_data.columns(col::SOURCE, col::TRAF4)];
 
     ////////////////////////////////////////////////////////////////////////////
 
-    std::vector<int> result(TEST_ROWS);
+    return m_model_cfg.model() == ModelCfg::Model::GBDT ?
+        do_gbdt(std::move(X_train_data), std::move(y_train_data), std::move(X_test_data), m_model_cfg.gbdt(), m_cfg) :
+        do_log_reg(std::move(X_train_data), std::move(y_train_data), std::move(X_test_data), m_cfg);
+}
 
-    result = do_log_reg(std::move(X_train_data), std::move(y_train_data), std::move(X_test_data));
+std::vector<int>
+TripSafetyFactors::predict(
+    const num::ModelView & model,
+    std::vector<std::string> i_test_data) const
+{
+    return predict(model, load(std::move(i_test_data)));
+}
 
-    return result;
+std::vector<int>
+TripSafetyFactors::predict(
+    const num::ModelView & model,
+    const std::vector<num::string_ref> & test_lines) const
+{
+    return predict(model, load(test_lines));
+}
+
+std::vector<int>
+TripSafetyFactors::predict(
+    const num::ModelView & model,
+    num::array2d<real_type> && test_data) const
+{
+    typedef num::array2d<real_type> array_type;
+
+    std::cerr << test_data.shape() << std::endl;
+
+    const num::BatchScorer scorer(model);
+
+    array_type X_test({test_data.shape().first, col::TRAF4 - col::SOURCE + 1}, 0.0);
+
+    assert(X_test.shape().second == scorer.nfeatures());
+    assert(test_data.shape().second > col::TRAF4);
+
+    X_test[X_test.columns(0, -1)] = test_data[test_data.columns(col::SOURCE, col::TRAF4)];
+
+    // ranking needs margins only
+    std::valarray<real_type> margins(X_test.shape().first);
+    if (margins.size())
+    {
+        scorer.margins(X_test.data(), X_test.shape().first, &margins[0]);
+    }
+
+    return rank_predictions(margins, m_cfg);
+}
+
+std::vector<std::uint64_t>
+TripSafetyFactors::update(
+    const num::ModelView & model,
+    std::vector<std::string> i_train_data) const
+{
+    typedef num::array2d<real_type> array_type;
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    num::IncrementalModel incremental(model);
+
+    const array_type train_data = load(std::move(i_train_data));
+
+    assert(train_data.shape().second > col::EVT_CNT);
+
+    // intercept in column 0, as encoded by the model
+    array_type X_train = num::ones<real_type>({train_data.shape().first, col::TRAF4 - col::SOURCE + 2});
+    X_train[X_train.columns(1, -1)] = train_data[train_data.columns(col::SOURCE, col::TRAF4)];
+
+    const std::valarray<real_type> y_train = train_data[train_data.column(col::EVT_CNT)];
+
+    num::size_type rows_visited{0};
+    incremental.update(X_train, y_train, m_cfg.C(), m_cfg.max_iter(), &rows_visited);
+
+    const auto t1 = std::chrono::steady_clock::now();
+
+    if (m_cfg.verbose())
+    {
+        std::cerr << "updated with " << train_data.shape().first << " rows, now " << incremental.nrows()
+            << ", passes over new rows: " << (real_type)rows_visited / std::max<num::size_type>(1, train_data.shape().first)
+            << ", update time [ms]: " << std::chrono::duration<double, std::milli>(t1 - t0).count() << std::endl;
+    }
+
+    return incremental.serialize();
+}
+
+std::vector<std::uint64_t>
+TripSafetyFactors::refine(
+    const num::ModelView & model,
+    std::istream & is,
+    num::size_type shuffle_capacity) const
+{
+    const auto t0 = std::chrono::steady_clock::now();
+
+    assert(model.ncols() == col::TRAF4 - col::SOURCE + 2);
+
+    num::StreamRowSource<real_type> source(is, model.ncols(),
+        [&model](const std::string & line, real_type * row, real_type & label) -> bool
+        {
+            if (line.empty())
+            {
+                return false;
+            }
+
+            const num::array2d<real_type> record = load(std::vector<num::string_ref>{num::string_ref(line)});
+
+            if (record.shape().second <= col::EVT_CNT)
+            {
+                throw std::invalid_argument("training row without EVT_CNT: " + line);
+            }
+
+            // intercept in column 0, as encoded by the model
+            row[0] = 1.0;
+            std::copy(record.data() + col::SOURCE, record.data() + col::TRAF4 + 1, row + 1);
+            model.encode_row(row);
+
+            label = std::min<real_type>(record.data()[col::EVT_CNT], 1.0);
+
+            return true;
+        },
+        shuffle_capacity);
+
+    num::size_type rows_visited{0};
+    const std::valarray<real_type> theta = num::minibatch_fit(source,
+        std::valarray<real_type>(model.theta(), model.ncols()), m_cfg.C(), m_cfg.minibatch(), &rows_visited);
+
+    const auto t1 = std::chrono::steady_clock::now();
+
+    if (m_cfg.verbose())
+    {
+        std::cerr << "refined over " << rows_visited << " streamed rows, shuffle buffer: " << shuffle_capacity
+            << " rows, fit time [s]: " << std::chrono::duration<double>(t1 - t0).count() << std::endl;
+    }
+
+    return model.with_theta(theta);
 }
 
 //#include <functional>
@@ -36,6 +36,8 @@
 #include <sstream>
 #include <type_traits>
 #include <unordered_set>
+#include <vector>
+#include <stdexcept>
 
 namespace num
 {
@@ -63,10 +65,15 @@ public:
 
     std::slice row(size_type n) const;
     std::slice column(size_type n) const;
+    std::slice column(size_type n, size_type rbegin, size_type rend) const;
     std::slice stripe(size_type n, enum Axis axis) const;
 
     std::gslice columns(int p, int q) const;
 
+    /// contiguous, row-major storage
+    const value_type * data(void) const;
+    value_type * data(void);
+
     std::valarray<value_type> operator[](std::slice slicearr) const;
     std::slice_array<value_type> operator[](std::slice slicearr);
     std::valarray<value_type> operator[](const std::gslice & gslicearr) const;
@@ -111,6 +118,15 @@ array2d<_Type>::column(size_type n) const
     return std::slice(n, m_shape.first, m_shape.second);
 }
 
+template<typename _Type>
+inline
+std::slice
+array2d<_Type>::column(size_type n, size_type rbegin, size_type rend) const
+{
+    assert(rbegin <= rend && rend <= m_shape.first);
+    return std::slice(rbegin * m_shape.second + n, rend - rbegin, m_shape.second);
+}
+
 template<typename _Type>
 inline
 std::gslice
@@ -134,6 +150,22 @@ array2d<_Type>::columns(int p, int q) const
     );
 }
 
+template<typename _Type>
+inline
+const _Type *
+array2d<_Type>::data(void) const
+{
+    return m_varray.size() ? &m_varray[0] : nullptr;
+}
+
+template<typename _Type>
+inline
+_Type *
+array2d<_Type>::data(void)
+{
+    return m_varray.size() ? &m_varray[0] : nullptr;
+}
+
 template<typename _Type>
 inline
 std::slice
@@ -338,6 +370,144 @@ loadtxt(
     return result;
 }
 
+/*
+ * Non-owning reference to characters of a buffer held by the caller,
+ * e.g. one line of a larger text. Not NUL terminated.
+ */
+struct string_ref
+{
+    string_ref()
+    :
+        m_data{nullptr},
+        m_size{0}
+    {}
+
+    string_ref(const char * data, size_type size)
+    :
+        m_data{data},
+        m_size{size}
+    {}
+
+    string_ref(const std::string & str)
+    :
+        m_data{str.data()},
+        m_size{str.size()}
+    {}
+
+    const char * data(void) const
+    {
+        return m_data;
+    }
+
+    size_type size(void) const
+    {
+        return m_size;
+    }
+
+    bool empty(void) const
+    {
+        return m_size == 0;
+    }
+
+    const char * begin(void) const
+    {
+        return m_data;
+    }
+
+    const char * end(void) const
+    {
+        return m_data + m_size;
+    }
+
+    const char * m_data;
+    size_type m_size;
+};
+
+/// lines of a text buffer, without line terminators
+inline
+std::vector<string_ref>
+split_lines(const char * buffer, size_type size)
+{
+    std::vector<string_ref> lines;
+
+    const char * p = buffer;
+    const char * const end = buffer + size;
+
+    while (p < end)
+    {
+        const char * eol = std::find(p, end, '\n');
+        const char * line_end = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+
+        lines.emplace_back(p, line_end - p);
+        p = eol + 1;
+    }
+
+    return lines;
+}
+
+/*
+ * Like loadtxt above, but parsing in place from lines held by the caller.
+ * Every field is copied to a stack buffer only, to terminate it for
+ * the converter; longer fields than that are std::invalid_argument.
+ */
+template<typename _Type>
+array2d<_Type>
+loadtxt(
+    const std::vector<string_ref> & txt,
+    const loadtxtCfg<_Type> & cfg
+)
+{
+    typedef _Type value_type;
+
+    assert(txt.size() >= (cfg.skip_header() + cfg.skip_footer()));
+    const size_type NROWS = txt.size() - cfg.skip_header() - cfg.skip_footer();
+    if (NROWS == 0)
+    {
+        return zeros<value_type>(shape_type(0, 0));
+    }
+
+    const string_ref & first = txt[cfg.skip_header()];
+    const size_type NCOLS = 1 + std::count(first.begin(), first.end(), cfg.delimiter());
+
+    std::vector<value_type(*)(const char *)> converters(NCOLS, nullptr);
+    for (const auto & converter : cfg.converters())
+    {
+        if (converter.first < NCOLS)
+        {
+            converters[converter.first] = converter.second;
+        }
+    }
+
+    array2d<_Type> result = zeros<value_type>(shape_type(NROWS, NCOLS));
+    value_type * values = result.data();
+
+    for (size_type ridx{0}; ridx < NROWS; ++ridx)
+    {
+        const string_ref & line = txt[ridx + cfg.skip_header()];
+        const char * field = line.begin();
+
+        for (size_type cidx{0}; cidx < NCOLS && field <= line.end(); ++cidx)
+        {
+            const char * field_end = std::find(field, line.end(), cfg.delimiter());
+
+            char item[64];
+            const size_type length = field_end - field;
+            if (length >= sizeof (item))
+            {
+                throw std::invalid_argument("field too long in row " + std::to_string(ridx) + ", column " + std::to_string(cidx));
+            }
+            std::copy(field, field_end, item);
+            item[length] = '\0';
+
+            values[ridx * NCOLS + cidx] = converters[cidx] ? converters[cidx](item) : std::strtod(item, nullptr);
+
+            field = field_end + 1;
+        }
+    }
+
+    return result;
+}
+
 } // namespace num
 
 namespace std
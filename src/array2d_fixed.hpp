@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: array2d_fixed.hpp
+ *
+ * Description:
+ *      Row-major matrix with the number of columns known at compile time
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef ARRAY2D_FIXED_HPP_
+#define ARRAY2D_FIXED_HPP_
+
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <array>
+#include <vector>
+#include <valarray>
+#include <algorithm>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Read-only copy of an array2d with _NCols columns, rows padded with
+ * zeros to STRIDE, a multiple of LANES. Row kernels below loop over
+ * STRIDE, a constant, in steps of LANES independent accumulators, which
+ * the compiler unrolls and vectorizes without remainder loops.
+ */
+template<typename _ValueType, size_type _NCols>
+class array2d_fixed
+{
+public:
+    typedef _ValueType value_type;
+
+    static constexpr size_type NCOLS = _NCols;
+    static constexpr size_type LANES = 4;
+    static constexpr size_type STRIDE = (NCOLS + LANES - 1) / LANES * LANES;
+
+    /// a vector of NCOLS values, padded like the rows
+    typedef std::array<value_type, STRIDE> row_type;
+
+    explicit array2d_fixed(const array2d<value_type> & X)
+    :
+        m_nrows{X.shape().first},
+        m_data(X.shape().first * STRIDE, 0.0)
+    {
+        assert(X.shape().second == NCOLS);
+
+        for (size_type r{0}; r < m_nrows; ++r)
+        {
+            std::copy(X.data() + r * NCOLS, X.data() + (r + 1) * NCOLS, m_data.begin() + r * STRIDE);
+        }
+    }
+
+    shape_type shape(void) const
+    {
+        return {m_nrows, NCOLS};
+    }
+
+    const value_type * row(size_type r) const
+    {
+        assert(r < m_nrows);
+
+        return m_data.data() + r * STRIDE;
+    }
+
+    static row_type pad(const std::valarray<value_type> & v)
+    {
+        assert(v.size() == NCOLS);
+
+        row_type result;
+        result.fill(0.0);
+        std::copy(std::begin(v), std::end(v), result.begin());
+        return result;
+    }
+
+private:
+    size_type m_nrows;
+    std::vector<value_type> m_data;
+};
+
+template<typename _ValueType, size_type _NCols>
+constexpr size_type array2d_fixed<_ValueType, _NCols>::NCOLS;
+
+template<typename _ValueType, size_type _NCols>
+constexpr size_type array2d_fixed<_ValueType, _NCols>::LANES;
+
+template<typename _ValueType, size_type _NCols>
+constexpr size_type array2d_fixed<_ValueType, _NCols>::STRIDE;
+
+namespace detail
+{
+
+/// dot product of _Width values, for any _Width, no loop is left at run time
+template<size_type _Width, typename _ValueType>
+inline
+_ValueType
+fixed_dot(const _ValueType * x, const _ValueType * y)
+{
+    constexpr size_type BODY = _Width / 4 * 4;
+
+    _ValueType a0{0.0};
+    _ValueType a1{0.0};
+    _ValueType a2{0.0};
+    _ValueType a3{0.0};
+
+    for (size_type c{0}; c < BODY; c += 4)
+    {
+        a0 += x[c] * y[c];
+        a1 += x[c + 1] * y[c + 1];
+        a2 += x[c + 2] * y[c + 2];
+        a3 += x[c + 3] * y[c + 3];
+    }
+    for (size_type c{BODY}; c < _Width; ++c)
+    {
+        a0 += x[c] * y[c];
+    }
+
+    return (a0 + a1) + (a2 + a3);
+}
+
+/// y += a * x
+template<size_type _Width, typename _ValueType>
+inline
+void
+fixed_axpy(const _ValueType a, const _ValueType * x, _ValueType * y)
+{
+    for (size_type c{0}; c < _Width; ++c)
+    {
+        y[c] += a * x[c];
+    }
+}
+
+}  // namespace detail
+
+}  // namespace num
+
+#endif /* ARRAY2D_FIXED_HPP_ */
@@ -0,0 +1,273 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: bagging.hpp
+ *
+ * Description:
+ *      Row sampling: bagged logistic regression fitted concurrently over
+ *      row index views, negative downsampling
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef BAGGING_HPP_
+#define BAGGING_HPP_
+
+#include "array2d.hpp"
+#include "logreg.hpp"
+#include "thread_pool.hpp"
+
+#include <valarray>
+#include <vector>
+#include <future>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <cassert>
+
+namespace num
+{
+
+template<typename _ValueType = double>
+struct BaggingCfg
+{
+    enum class Combine
+    {
+        Score,  // mean predicted probability
+        Margin, // mean margin, i.e. the single model with mean theta
+        Rank    // mean rank
+    };
+
+    BaggingCfg()
+    :
+        m_bags{0},
+        m_fraction{1.0},
+        m_bootstrap{true},
+        m_combine{Combine::Score},
+        m_seed{1},
+        m_threads{std::max(1u, std::thread::hardware_concurrency())}
+    {}
+
+    size_type bags(void) const
+    {
+        return m_bags;
+    }
+
+    /// number of models, 0 disables bagging
+    BaggingCfg & bags(size_type _bags)
+    {
+        m_bags = _bags;
+        return *this;
+    }
+
+    _ValueType fraction(void) const
+    {
+        return m_fraction;
+    }
+
+    /// rows per bag, as a fraction of the training rows
+    BaggingCfg & fraction(_ValueType _fraction)
+    {
+        m_fraction = _fraction;
+        return *this;
+    }
+
+    bool bootstrap(void) const
+    {
+        return m_bootstrap;
+    }
+
+    /// draw rows with replacement (bootstrap), otherwise subsample without
+    BaggingCfg & bootstrap(bool _bootstrap)
+    {
+        m_bootstrap = _bootstrap;
+        return *this;
+    }
+
+    Combine combine(void) const
+    {
+        return m_combine;
+    }
+
+    BaggingCfg & combine(Combine _combine)
+    {
+        m_combine = _combine;
+        return *this;
+    }
+
+    unsigned int seed(void) const
+    {
+        return m_seed;
+    }
+
+    BaggingCfg & seed(unsigned int _seed)
+    {
+        m_seed = _seed;
+        return *this;
+    }
+
+    size_type threads(void) const
+    {
+        return m_threads;
+    }
+
+    BaggingCfg & threads(size_type _threads)
+    {
+        m_threads = _threads;
+        return *this;
+    }
+
+    size_type m_bags;
+    _ValueType m_fraction;
+    bool m_bootstrap;
+    Combine m_combine;
+    unsigned int m_seed;
+    size_type m_threads;
+};
+
+/*
+ * Row indices of one bag out of m rows, sorted so that the fit walks the
+ * shared matrix forward. Bags depend on the seed and the bag number only.
+ */
+template<typename _ValueType>
+std::vector<size_type>
+bag_rows(size_type m, const BaggingCfg<_ValueType> & cfg, size_type bag)
+{
+    const size_type N = std::max<size_type>(1,
+        cfg.bootstrap() ? m * cfg.fraction() : std::min<_ValueType>(m, m * cfg.fraction()));
+
+    std::mt19937 gen(cfg.seed() + bag);
+    std::vector<size_type> rows;
+
+    if (cfg.bootstrap())
+    {
+        std::uniform_int_distribution<size_type> row(0, m - 1);
+
+        rows.resize(N);
+        std::generate(rows.begin(), rows.end(), [&]() { return row(gen); });
+    }
+    else
+    {
+        rows.resize(m);
+        std::iota(rows.begin(), rows.end(), 0);
+
+        // partial Fisher-Yates, first N positions end up a uniform sample
+        for (size_type i{0}; i < N; ++i)
+        {
+            std::uniform_int_distribution<size_type> pick(i, m - 1);
+            std::swap(rows[i], rows[pick(gen)]);
+        }
+        rows.resize(N);
+    }
+
+    std::sort(rows.begin(), rows.end());
+
+    return rows;
+}
+
+/*
+ * Keeps every row with a positive label and a Bernoulli(rate) sample of
+ * the negative ones. Returns the row index view and importance weights:
+ * 1 for positives, 1 / rate for the kept negatives, so that weighted sums
+ * over the sample are unbiased estimates of sums over all rows.
+ */
+template<typename _ValueType>
+std::pair<std::vector<size_type>, std::valarray<_ValueType>>
+downsample_negatives(const std::valarray<_ValueType> & y, _ValueType rate, unsigned int seed)
+{
+    assert(rate > 0.0 && rate <= 1.0);
+
+    std::mt19937 gen(seed);
+    std::bernoulli_distribution keep(rate);
+
+    std::vector<size_type> rows;
+    std::vector<_ValueType> weights;
+
+    for (size_type r{0}; r < y.size(); ++r)
+    {
+        if (y[r] > 0.0)
+        {
+            rows.push_back(r);
+            weights.push_back(1.0);
+        }
+        else if (keep(gen))
+        {
+            rows.push_back(r);
+            weights.push_back(1.0 / rate);
+        }
+    }
+
+    return std::make_pair(std::move(rows), std::valarray<_ValueType>(weights.data(), weights.size()));
+}
+
+/*
+ * Fits cfg.bags() models, each with fit_rows over its own bag of rows
+ * of the shared, read-only X, concurrently on cfg.threads() threads.
+ * Returns theta of every bag, in bag order.
+ */
+template<typename _ValueType>
+std::vector<std::valarray<_ValueType>>
+fit_bagged(
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    const BaggingCfg<_ValueType> & cfg,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef std::valarray<_ValueType> vector_type;
+
+    assert(cfg.bags() > 0);
+    assert(X.shape().first > 0);
+
+    std::vector<std::future<vector_type>> futures;
+    std::vector<size_type> rows_visited(cfg.bags(), 0);
+    {
+        ThreadPool pool(std::min(cfg.threads(), cfg.bags()));
+
+        for (size_type bag{0}; bag < cfg.bags(); ++bag)
+        {
+            futures.push_back(pool.submit(
+                [&, bag]() -> vector_type
+                {
+                    const std::vector<size_type> rows = bag_rows(X.shape().first, cfg, bag);
+
+                    return fit_rows(X, y, rows, theta0, C, max_iter, &rows_visited[bag]);
+                }
+            ));
+        }
+    }
+
+    std::vector<vector_type> thetas;
+    for (auto & future : futures)
+    {
+        thetas.push_back(future.get());
+    }
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = std::accumulate(rows_visited.cbegin(), rows_visited.cend(), size_type{0});
+    }
+
+    return thetas;
+}
+
+}  // namespace num
+
+#endif /* BAGGING_HPP_ */
@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: bench_codegen.cpp
+ *
+ * Description:
+ *      Generated scorer against BatchScorer and LogisticRegression::predict
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "model.hpp"
+#include "scorer.hpp"
+#include "logreg.hpp"
+#include "codegen.hpp"
+
+// written by codegen at build time, see CMakeLists.txt
+#include "generated_scorer.hpp"
+
+#include <vector>
+#include <valarray>
+#include <string>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cmath>
+
+int main(int argc, char **argv)
+{
+    // bench_codegen [--model=PATH] [--rows=N] [--repeats=R]
+    // the model has to be the one the scorer was generated from, which
+    // is also the default
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+
+        if (arg.compare(0, 2, "--") == 0 && eq != std::string::npos)
+        {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    const num::size_type NROWS = std::stoul(option("rows", "100000"));
+    const num::size_type REPEATS = std::stoul(option("repeats", "5"));
+
+    std::mt19937 gen(1);
+
+    const std::string MODEL_PATH = option("model", generated_scorer::MODEL_PATH);
+    if (MODEL_PATH.empty())
+    {
+        std::cerr << "no model, give one with --model=PATH" << std::endl;
+        return 1;
+    }
+
+    const num::MappedModel mapped(MODEL_PATH);
+    const num::ModelView & model = mapped.view();
+
+    if (num::model_fingerprint(model) != generated_scorer::FINGERPRINT)
+    {
+        std::cerr << "the scorer was generated from another model, rerun cmake with -DSCORER_MODEL=PATH" << std::endl;
+        return 1;
+    }
+
+    const num::size_type NFEAT = generated_scorer::NFEATURES;
+    const num::size_type NCOLS = model.ncols();
+
+    // integer valued features so that density lookups hit their tables
+    std::vector<double> rows(NROWS * NFEAT);
+    {
+        std::uniform_int_distribution<int> feature(0, 39);
+        std::generate(rows.begin(), rows.end(), [&]() { return (double)feature(gen); });
+    }
+
+    // LogisticRegression::predict needs rows encoded and standardized
+    // the way do_log_reg prepares them, which is part of its cost
+    typedef num::LogisticRegression<double> logreg_type;
+
+    const std::valarray<double> theta(model.theta(), NCOLS);
+    const logreg_type logreg(num::array2d<double>({0, NCOLS}, 0.0), std::valarray<double>(), std::valarray<double>(theta), 0.0, 0);
+
+    const num::BatchScorer scorer(model);
+
+    std::valarray<double> expected;
+    std::vector<double> out(NROWS);
+
+    auto logreg_predict = [&]()
+    {
+        num::array2d<double> X = num::ones<double>({NROWS, NCOLS});
+        for (num::size_type r{0}; r < NROWS; ++r)
+        {
+            X[std::slice(r * NCOLS + 1, NFEAT, 1)] = std::valarray<double>(rows.data() + r * NFEAT, NFEAT);
+        }
+        model.encode(X);
+        expected = logreg.predict(X, theta, false);
+    };
+
+    const std::vector<std::pair<std::string, std::function<void(void)>>> scorers =
+    {
+        {"LogisticRegression::predict", logreg_predict},
+        {"BatchScorer", [&]() { scorer.probabilities(rows.data(), NROWS, out.data()); }},
+        {"generated", [&]() { generated_scorer::probabilities(rows.data(), NROWS, out.data()); }},
+    };
+
+    std::cout << std::setw(30) << "scorer" << std::setw(14) << "best [ms]" << std::setw(16) << "rows/s"
+        << std::setw(10) << "speedup" << std::setw(14) << "max |diff|" << std::endl;
+
+    double baseline{0.0};
+
+    for (const auto & item : scorers)
+    {
+        double best{1e300};
+        for (num::size_type rep{0}; rep < REPEATS; ++rep)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            item.second();
+            const auto t1 = std::chrono::steady_clock::now();
+
+            best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+
+        double max_diff{0.0};
+        if (&item != &scorers.front())
+        {
+            for (num::size_type r{0}; r < NROWS; ++r)
+            {
+                max_diff = std::max(max_diff, std::fabs(out[r] - expected[r]));
+            }
+        }
+        baseline = baseline > 0.0 ? baseline : best;
+
+        std::cout << std::setw(30) << item.first
+            << std::setw(14) << std::fixed << std::setprecision(3) << best
+            << std::setw(16) << std::setprecision(0) << NROWS / (best * 1e-3)
+            << std::setw(10) << std::setprecision(2) << baseline / best
+            << std::setw(14) << std::scientific << std::setprecision(1) << max_diff << std::endl;
+    }
+
+    return 0;
+}
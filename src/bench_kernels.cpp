@@ -0,0 +1,334 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: bench_kernels.cpp
+ *
+ * Description:
+ *      Microbenchmarks of num:: kernels in isolation, results as JSON
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "TripSafetyFactors.hpp"
+
+#include <vector>
+#include <valarray>
+#include <string>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+namespace
+{
+
+struct Result
+{
+    std::string kernel;
+    /// rows processed by one run
+    num::size_type rows;
+    double min_ms;
+    double median_ms;
+};
+
+/// fixed width cost / gradient, when the width has a specialized kernel
+struct FixedCostGrad
+{
+    template<num::size_type _NCols>
+    void operator()(std::integral_constant<num::size_type, _NCols>)
+    {
+        const num::array2d_fixed<real_type, _NCols> X_fixed(X);
+        std::valarray<real_type> grad(X.shape().second);
+        std::valarray<real_type> tcol;
+        real_type cost{0.0};
+
+        run = [=]() mutable
+        {
+            num::logreg_cost_grad(cost, grad, tcol, theta, X_fixed, y, (real_type)1.0);
+        };
+    }
+
+    const num::array2d<real_type> & X;
+    const std::valarray<real_type> & y;
+    const std::valarray<real_type> & theta;
+    std::function<void(void)> run;
+};
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    // bench_kernels [--rows=N] [--features=F] [--repeats=R] [--seed=S]
+    //      [--label=TEXT] [--out=JSON]
+    // every kernel is run once to warm up, then R times; JSON goes to
+    // stdout unless written to a file
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+
+        if (arg.compare(0, 2, "--") == 0 && eq != std::string::npos)
+        {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+
+    const num::size_type NROWS = std::stoul(option("rows", "20000"));
+    const num::size_type NFEAT = std::stoul(option("features", "28"));
+    const num::size_type REPEATS = std::max<num::size_type>(1, std::stoul(option("repeats", "10")));
+
+    // intercept in column 0, like the matrices do_log_reg fits
+    const num::size_type NCOLS = NFEAT + 1;
+
+    std::mt19937 gen(std::stoul(option("seed", "1")));
+
+    // standardized features, categorical-like integer keys for density
+    // mapping, rare events
+    array_type X = num::ones<real_type>({NROWS, NCOLS});
+    {
+        std::normal_distribution<real_type> normal;
+        vector_type values(NROWS * NFEAT);
+        std::generate(std::begin(values), std::end(values), [&]() { return normal(gen); });
+        X[X.columns(1, -1)] = values;
+    }
+
+    vector_type keys(NROWS);
+    {
+        std::uniform_int_distribution<int> key(0, 799);
+        std::generate(std::begin(keys), std::end(keys), [&]() { return (real_type)key(gen); });
+    }
+
+    vector_type y(NROWS);
+    {
+        std::bernoulli_distribution event(0.05);
+        std::generate(std::begin(y), std::end(y), [&]() { return (real_type)event(gen); });
+    }
+
+    vector_type theta(NCOLS);
+    {
+        std::normal_distribution<real_type> normal(0.0, 0.1);
+        std::generate(std::begin(theta), std::end(theta), [&]() { return normal(gen); });
+    }
+
+    std::vector<std::string> lines(NROWS);
+    std::string buffer;
+    {
+        std::uniform_int_distribution<int> value(0, 9999);
+        for (auto & line : lines)
+        {
+            for (num::size_type c{0}; c < NCOLS; ++c)
+            {
+                line += (c ? "," : "") + std::to_string(value(gen) / 100.0);
+            }
+            buffer += line + "\n";
+        }
+    }
+    const std::vector<num::string_ref> line_refs = num::split_lines(buffer.data(), buffer.size());
+
+    std::vector<Result> results;
+
+    auto measure = [&](const std::string & kernel, num::size_type rows, std::function<void(void)> fn)
+    {
+        fn();
+
+        std::vector<double> ms;
+        for (num::size_type rep{0}; rep < REPEATS; ++rep)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            const auto t1 = std::chrono::steady_clock::now();
+
+            ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+        std::sort(ms.begin(), ms.end());
+
+        results.push_back({kernel, rows, ms.front(), ms[ms.size() / 2]});
+        std::cerr << kernel << ": " << ms[ms.size() / 2] << " ms" << std::endl;
+    };
+
+    // results have to be used, or the work may be optimized away
+    volatile real_type sink{0.0};
+
+    measure("loadtxt", NROWS, [&]()
+    {
+        const array_type parsed = num::loadtxt(std::vector<std::string>(lines), std::move(num::loadtxtCfg<real_type>().delimiter(',')));
+        sink = parsed.data()[0];
+    });
+
+    measure("loadtxt_string_ref", NROWS, [&]()
+    {
+        const array_type parsed = num::loadtxt(line_refs, num::loadtxtCfg<real_type>().delimiter(','));
+        sink = parsed.data()[0];
+    });
+
+    measure("array2d_rows", NROWS, [&]()
+    {
+        real_type sum{0.0};
+        for (num::size_type r{0}; r < NROWS; ++r)
+        {
+            const vector_type row = X[X.row(r)];
+            sum += row[NCOLS - 1];
+        }
+        sink = sum;
+    });
+
+    measure("array2d_columns", NROWS, [&]()
+    {
+        real_type sum{0.0};
+        for (num::size_type c{0}; c < NCOLS; ++c)
+        {
+            const vector_type column = X[X.column(c)];
+            sum += column[NROWS - 1];
+        }
+        sink = sum;
+    });
+
+    measure("array2d_feature_block", NROWS, [&]()
+    {
+        const vector_type block = X[X.columns(1, -1)];
+        sink = block[0];
+    });
+
+    measure("mean_std", NROWS, [&]()
+    {
+        real_type sum{0.0};
+        for (num::size_type c{1}; c < NCOLS; ++c)
+        {
+            const vector_type column = X[X.column(c)];
+            sum += num::mean(column) + num::std(column);
+        }
+        sink = sum;
+    });
+
+    measure("sigmoid", NROWS, [&]()
+    {
+        const vector_type h = num::sigmoid(vector_type(keys / (real_type)800.0));
+        sink = h[0];
+    });
+
+    measure("logreg_cost_grad", NROWS, [&]()
+    {
+        vector_type tcol(NROWS);
+        vector_type grad(NCOLS);
+        real_type cost;
+        num::logreg_cost_grad(cost, grad, tcol, theta, X, y, (real_type)1.0);
+        sink = cost;
+    });
+
+    FixedCostGrad fixed_cost_grad{X, y, theta, nullptr};
+    if (num::detail::FixedWidthDispatch<NUM_LOGREG_FIXED_WIDTHS>::apply(NCOLS, fixed_cost_grad))
+    {
+        measure("logreg_cost_grad_fixed", NROWS, fixed_cost_grad.run);
+    }
+
+    measure("fmincg_iteration", NROWS, [&]()
+    {
+        vector_type tcol(NROWS);
+        std::function<std::pair<real_type, vector_type> (const vector_type)> cost_fn =
+            [&](const vector_type theta) -> std::pair<real_type, vector_type>
+            {
+                real_type cost;
+                vector_type grad(theta.size());
+                num::logreg_cost_grad(cost, grad, tcol, theta, X, y, (real_type)1.0);
+                return std::make_pair(cost, grad);
+            };
+
+        const vector_type fitted = num::fmincg(cost_fn, vector_type(0.0, NCOLS), 1, false);
+        sink = fitted[0];
+    });
+
+    measure("map_event_density", NROWS, [&]()
+    {
+        // same steps as do_log_reg for one density encoded column
+        const num::event_counts_type event_count = count_events(keys, y);
+        auto event_density = map_event_density(event_count);
+
+        vector_type mapped(keys);
+        for (auto & x : mapped)
+        {
+            x = event_density[x];
+        }
+        sink = mapped[0];
+    });
+
+    measure("rank_predictions", NROWS, [&]()
+    {
+        const vector_type pred = num::sigmoid(vector_type(X[X.column(NCOLS - 1)]));
+        const std::vector<int> ranks = rank_predictions(pred, LogRegCfg().verbose(false));
+        sink = ranks[0];
+    });
+
+    measure("rank_predictions_top_k", NROWS, [&]()
+    {
+        const vector_type pred = num::sigmoid(vector_type(X[X.column(NCOLS - 1)]));
+        const std::vector<int> ranks = rank_predictions(pred, LogRegCfg().verbose(false).rank_top_k(NROWS / 10));
+        sink = ranks[0];
+    });
+
+    std::ofstream fout;
+    if (options.count("out"))
+    {
+        fout.open(options.at("out"));
+    }
+    std::ostream & os = options.count("out") ? fout : std::cout;
+
+    auto quoted = [](const std::string & text) -> std::string
+    {
+        std::string result("\"");
+        for (const char ch : text)
+        {
+            result += (ch == '"' || ch == '\\') ? std::string("\\") + ch : std::string(1, ch);
+        }
+        return result + "\"";
+    };
+
+    os << "{\n"
+        << "  \"label\": " << quoted(option("label", "")) << ",\n"
+        << "  \"rows\": " << NROWS << ",\n"
+        << "  \"features\": " << NFEAT << ",\n"
+        << "  \"repeats\": " << REPEATS << ",\n"
+        << "  \"results\": [\n";
+    for (num::size_type i{0}; i < results.size(); ++i)
+    {
+        const Result & result = results[i];
+
+        os << "    {\"kernel\": " << quoted(result.kernel)
+            << ", \"rows\": " << result.rows
+            << std::setprecision(6)
+            << ", \"min_ms\": " << result.min_ms
+            << ", \"median_ms\": " << result.median_ms
+            << ", \"rows_per_s\": " << std::fixed << std::setprecision(0) << result.rows / std::max(result.median_ms * 1e-3, 1e-9)
+            << std::defaultfloat << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+
+    return os ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: bench_model.hpp
+ *
+ * Description:
+ *      Synthetic model for scoring benchmarks
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef BENCH_MODEL_HPP_
+#define BENCH_MODEL_HPP_
+
+#include "model.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <map>
+#include <random>
+#include <cstdint>
+
+namespace num
+{
+
+/*
+ * Model of the same shape as the one fitted by do_log_reg: intercept and
+ * 28 features, density tables on SOURCE, CYCLES, START_MONTH, PILOT and
+ * PILOT_EXP with realistic cardinalities.
+ */
+inline
+std::vector<std::uint64_t>
+synthetic_model(std::mt19937 & gen)
+{
+    constexpr size_type NCOLS{29};
+    const std::map<size_type, size_type> CARDINALITY{{1, 40}, {3, 20}, {8, 12}, {13, 800}, {15, 31}};
+
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> uniform(0.0, 0.1);
+
+    std::valarray<double> theta(NCOLS);
+    std::valarray<double> mu(0.0, NCOLS);
+    std::valarray<double> dev(1.0, NCOLS);
+
+    for (size_type c{0}; c < NCOLS; ++c)
+    {
+        theta[c] = normal(gen);
+        mu[c] = c ? normal(gen) : 0.0;
+        dev[c] = c ? 1.0 + uniform(gen) : 1.0;
+    }
+
+    density_counts_type tables;
+    for (const auto & card : CARDINALITY)
+    {
+        event_counts_type table;
+        for (size_type k{0}; k < card.second; ++k)
+        {
+            table[k] = std::make_pair(100.0, 100.0 * uniform(gen));
+        }
+        tables.emplace_back(card.first, std::move(table));
+    }
+
+    return serialize_model(theta, mu, dev, tables, 100 * NCOLS);
+}
+
+}  // namespace num
+
+#endif /* BENCH_MODEL_HPP_ */
@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: bench_scorer.cpp
+ *
+ * Description:
+ *      Per-batch latency of BatchScorer for batch sizes from 1 to 1M rows
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "model.hpp"
+#include "scorer.hpp"
+#include "bench_model.hpp"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+int main(int argc, char **argv)
+{
+    // bench_scorer [--model=PATH] [--max-batch=ROWS] [--budget=ROWS]
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+
+        if (arg.compare(0, 2, "--") == 0 && eq != std::string::npos)
+        {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    const num::size_type MAX_BATCH = std::stoul(option("max-batch", "1000000"));
+    const num::size_type BUDGET = std::stoul(option("budget", "20000000"));
+
+    std::mt19937 gen(1);
+
+    std::vector<std::uint64_t> words;
+    std::unique_ptr<num::MappedModel> mapped;
+    std::unique_ptr<num::ModelView> view;
+
+    if (options.count("model"))
+    {
+        mapped.reset(new num::MappedModel(options.at("model")));
+    }
+    else
+    {
+        words = num::synthetic_model(gen);
+        view.reset(new num::ModelView(words.data(), words.size() * sizeof (std::uint64_t)));
+    }
+
+    const num::ModelView & model = mapped ? mapped->view() : *view;
+    const num::BatchScorer scorer(model);
+    const num::size_type NFEAT = scorer.nfeatures();
+
+    // pool of pre-parsed rows, integer valued features so that density
+    // lookups hit their tables
+    std::vector<double> pool(MAX_BATCH * NFEAT);
+    {
+        std::uniform_int_distribution<int> feature(0, 39);
+        std::generate(pool.begin(), pool.end(), [&]() { return (double)feature(gen); });
+    }
+
+    std::vector<double> out(MAX_BATCH);
+
+    std::cout << std::setw(10) << "batch" << std::setw(10) << "iters"
+        << std::setw(12) << "mode" << std::setw(14) << "p50 [us]" << std::setw(14) << "p99 [us]"
+        << std::setw(16) << "rows/s (p50)" << std::endl;
+
+    for (num::size_type batch{1}; batch <= MAX_BATCH; batch *= 10)
+    {
+        const num::size_type ITERS = std::max<num::size_type>(20, std::min<num::size_type>(100000, BUDGET / batch));
+        std::uniform_int_distribution<num::size_type> offset(0, MAX_BATCH - batch);
+
+        for (const bool probabilities : {false, true})
+        {
+            std::vector<double> latency_us;
+            latency_us.reserve(ITERS);
+
+            for (num::size_type it{0}; it < ITERS; ++it)
+            {
+                const double * rows = pool.data() + offset(gen) * NFEAT;
+
+                const auto t0 = std::chrono::steady_clock::now();
+                if (probabilities)
+                {
+                    scorer.probabilities(rows, batch, out.data());
+                }
+                else
+                {
+                    scorer.margins(rows, batch, out.data());
+                }
+                const auto t1 = std::chrono::steady_clock::now();
+
+                latency_us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+            }
+
+            std::sort(latency_us.begin(), latency_us.end());
+            const double p50 = latency_us[latency_us.size() / 2];
+            const double p99 = latency_us[std::min(latency_us.size() - 1, latency_us.size() * 99 / 100)];
+
+            std::cout << std::setw(10) << batch << std::setw(10) << ITERS
+                << std::setw(12) << (probabilities ? "proba" : "margins")
+                << std::setw(14) << std::fixed << std::setprecision(3) << p50
+                << std::setw(14) << p99
+                << std::setw(16) << std::setprecision(0) << batch / (p50 * 1e-6) << std::endl;
+        }
+    }
+
+    return 0;
+}
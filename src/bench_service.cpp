@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: bench_service.cpp
+ *
+ * Description:
+ *      Load generator for in-process scoring: throughput against the number
+ *      of threads sharing a model snapshot, with snapshots swapped meanwhile
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "model.hpp"
+#include "snapshot.hpp"
+#include "bench_model.hpp"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+int main(int argc, char **argv)
+{
+    // bench_service [--model=PATH] [--max-threads=T] [--batch=ROWS]
+    //      [--seconds=S] [--swap-ms=MS] [--reader=cached|shared]
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+
+        if (arg.compare(0, 2, "--") == 0 && eq != std::string::npos)
+        {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    const num::size_type MAX_THREADS = std::stoul(option("max-threads",
+        std::to_string(2 * std::max(1u, std::thread::hardware_concurrency()))));
+    const num::size_type BATCH = std::stoul(option("batch", "64"));
+    const double SECONDS = std::stod(option("seconds", "1.0"));
+    const std::chrono::milliseconds SWAP_PERIOD(std::stoul(option("swap-ms", "10")));
+    // cached: a SnapshotReader per thread, shared: SnapshotHandle::get()
+    // on every request
+    const bool CACHED_READER = option("reader", "cached") != "shared";
+
+    std::mt19937 gen(1);
+
+    // every published snapshot is built from these words, the way a
+    // service would reload a freshly saved model
+    std::vector<std::uint64_t> words;
+    if (options.count("model"))
+    {
+        const num::MappedFile file(options.at("model"));
+        const std::uint64_t * p = static_cast<const std::uint64_t *>(file.data());
+        words.assign(p, p + file.size() / sizeof (std::uint64_t));
+    }
+    else
+    {
+        words = num::synthetic_model(gen);
+    }
+
+    num::SnapshotHandle handle(std::make_shared<const num::ModelSnapshot>(std::vector<std::uint64_t>(words)));
+    const num::size_type NFEAT = handle.get()->nfeatures();
+
+    // pool of pre-parsed rows, integer valued features so that density
+    // lookups hit their tables
+    constexpr num::size_type POOL_ROWS{1 << 16};
+    std::vector<double> pool(POOL_ROWS * NFEAT);
+    {
+        std::uniform_int_distribution<int> feature(0, 39);
+        std::generate(pool.begin(), pool.end(), [&]() { return (double)feature(gen); });
+    }
+
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "rows/s" << std::setw(10) << "speedup"
+        << std::setw(10) << "swaps" << std::setw(14) << "stale reads" << std::endl;
+
+    double single_thread{0.0};
+    std::uint64_t generation{0};
+
+    for (num::size_type nthreads{1}; nthreads <= MAX_THREADS; nthreads *= 2)
+    {
+        std::atomic<bool> stop{false};
+        std::atomic<std::uint64_t> rows_scored{0};
+        // a reader seeing an older generation than it has already seen
+        std::atomic<std::uint64_t> stale_reads{0};
+        std::uint64_t swaps{0};
+
+        std::vector<std::thread> threads;
+        for (num::size_type t{0}; t < nthreads; ++t)
+        {
+            threads.emplace_back(
+                [&, t]()
+                {
+                    std::vector<double> out(BATCH);
+                    std::uint64_t rows{0};
+                    std::uint64_t last_generation{0};
+                    num::size_type offset = (t * 7919 * BATCH) % (POOL_ROWS - BATCH);
+                    num::SnapshotReader reader(handle);
+
+                    while (!stop.load(std::memory_order_relaxed))
+                    {
+                        const std::shared_ptr<const num::ModelSnapshot> shared =
+                            CACHED_READER ? nullptr : handle.get();
+                        const num::ModelSnapshot * snapshot = CACHED_READER ? reader.get().get() : shared.get();
+
+                        if (snapshot->generation() < last_generation)
+                        {
+                            ++stale_reads;
+                        }
+                        last_generation = snapshot->generation();
+
+                        snapshot->margins(pool.data() + offset * NFEAT, BATCH, out.data());
+
+                        rows += BATCH;
+                        offset = (offset + BATCH) % (POOL_ROWS - BATCH);
+                    }
+
+                    rows_scored += rows;
+                }
+            );
+        }
+
+        // publisher: a new snapshot every SWAP_PERIOD while requests run
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto deadline = t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(SECONDS));
+
+        while (std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(SWAP_PERIOD);
+            handle.publish(std::make_shared<const num::ModelSnapshot>(std::vector<std::uint64_t>(words), ++generation));
+            ++swaps;
+        }
+
+        stop = true;
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        const double throughput = rows_scored / elapsed;
+
+        if (nthreads == 1)
+        {
+            single_thread = throughput;
+        }
+
+        std::cout << std::setw(8) << nthreads
+            << std::setw(16) << std::fixed << std::setprecision(0) << throughput
+            << std::setw(10) << std::setprecision(2) << throughput / single_thread
+            << std::setw(10) << swaps
+            << std::setw(14) << stale_reads << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: codegen.cpp
+ *
+ * Description:
+ *      Writes the specialized scorer header of a fitted model
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "model.hpp"
+#include "codegen.hpp"
+#include "bench_model.hpp"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <cstdint>
+#include <memory>
+#include <cstdio>
+
+int main(int argc, char **argv)
+{
+    // codegen [--model=PATH | --save-model=PATH] [--out=HEADER] [--namespace=NAME]
+    // without a model the synthetic one of the benchmarks is used, saved
+    // with --save-model so that benchmarks can score with the same one
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+
+        if (arg.compare(0, 2, "--") == 0 && eq != std::string::npos)
+        {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    std::vector<std::uint64_t> words;
+    std::unique_ptr<num::MappedModel> mapped;
+    std::unique_ptr<num::ModelView> view;
+
+    if (options.count("model"))
+    {
+        mapped.reset(new num::MappedModel(options.at("model")));
+    }
+    else
+    {
+        std::mt19937 gen(1);
+        words = num::synthetic_model(gen);
+        view.reset(new num::ModelView(words.data(), words.size() * sizeof (std::uint64_t)));
+
+        if (options.count("save-model"))
+        {
+            num::save_model(options.at("save-model"), words);
+        }
+    }
+
+    const std::string model_path = option("model", option("save-model", ""));
+
+    const num::ModelView & model = mapped ? mapped->view() : *view;
+
+    if (options.count("out"))
+    {
+        // written aside and renamed, so that a failed run leaves no half header
+        const std::string path = option("out", "");
+        {
+            std::ofstream os(path + ".tmp");
+            num::emit_scorer(os, model, option("namespace", "generated_scorer"), model_path);
+            if (!os)
+            {
+                std::cerr << "cannot write " << path << std::endl;
+                return 1;
+            }
+        }
+        if (std::rename((path + ".tmp").c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "cannot write " << path << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        num::emit_scorer(std::cout, model, option("namespace", "generated_scorer"), model_path);
+    }
+
+    return 0;
+}
@@ -0,0 +1,417 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: codegen.hpp
+ *
+ * Description:
+ *      Fitted model compiled into a specialized C++ scorer
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef CODEGEN_HPP_
+#define CODEGEN_HPP_
+
+#include "model.hpp"
+#include "num.hpp"
+
+#include <ostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <cctype>
+#include <cassert>
+
+namespace num
+{
+
+/// FNV-1a over coefficients, statistics and density tables of a model
+inline
+std::uint64_t
+model_fingerprint(const ModelView & model)
+{
+    std::uint64_t hash{14695981039346656037ULL};
+
+    auto mix = [&hash](const double * values, size_type count)
+    {
+        for (size_type i{0}; i < count; ++i)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, values + i, sizeof (bits));
+            for (size_type b{0}; b < sizeof (bits); ++b)
+            {
+                hash = (hash ^ ((bits >> (8 * b)) & 0xff)) * 1099511628211ULL;
+            }
+        }
+    };
+
+    mix(model.theta(), model.ncols());
+    mix(model.mu(), model.ncols());
+    mix(model.dev(), model.ncols());
+
+    for (const auto & table : model.tables())
+    {
+        const double shape[] = {(double)table.column, (double)table.size};
+        mix(shape, 2);
+        mix(table.keys, table.size);
+        mix(table.values, table.size);
+    }
+
+    return hash;
+}
+
+namespace detail
+{
+
+/// splitmix64 finalizer, also emitted into generated scorers
+inline
+std::uint64_t
+codegen_mix(std::uint64_t h)
+{
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+inline
+std::uint64_t
+codegen_key_bits(double key)
+{
+    // +0.0 and -0.0 compare equal, they have to hash equal too
+    key = key == 0.0 ? 0.0 : key;
+
+    std::uint64_t bits;
+    std::memcpy(&bits, &key, sizeof (bits));
+    return bits;
+}
+
+/*
+ * Hash and displace perfect hash of distinct keys: a key goes to bucket
+ * h & (nbuckets - 1), h = mix(bits(key)), and to slot
+ * mix(h ^ seeds[bucket]) & (nslots - 1). Seeds are searched bucket by
+ * bucket, largest first, until every key has a slot of its own.
+ * Empty slots hold keys[0], whose own slot is elsewhere, so that a
+ * lookup needs one comparison and no emptiness test.
+ */
+struct PerfectHash
+{
+    std::vector<std::uint64_t> seeds;
+    /// index into the keys for every slot
+    std::vector<size_type> slots;
+};
+
+inline
+PerfectHash
+perfect_hash(const double * keys, size_type nkeys)
+{
+    assert(nkeys > 0);
+
+    auto pow2 = [](size_type n) -> size_type
+    {
+        size_type p{1};
+        while (p < n)
+        {
+            p *= 2;
+        }
+        return p;
+    };
+
+    // load factor of at most 0.8, buckets of 2 keys on average
+    const size_type NSLOTS = pow2(nkeys + nkeys / 4);
+    const size_type NBUCKETS = pow2((nkeys + 1) / 2);
+
+    std::vector<std::vector<size_type>> buckets(NBUCKETS);
+    for (size_type k{0}; k < nkeys; ++k)
+    {
+        buckets[codegen_mix(codegen_key_bits(keys[k])) & (NBUCKETS - 1)].push_back(k);
+    }
+
+    std::vector<size_type> order(NBUCKETS);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [&buckets](size_type lhs, size_type rhs)
+        {
+            return buckets[lhs].size() > buckets[rhs].size();
+        }
+    );
+
+    PerfectHash result{std::vector<std::uint64_t>(NBUCKETS, 0), std::vector<size_type>(NSLOTS, nkeys)};
+
+    std::vector<size_type> taken;
+
+    for (const size_type b : order)
+    {
+        if (buckets[b].empty())
+        {
+            break;
+        }
+
+        constexpr std::uint64_t MAX_SEED{1 << 20};
+
+        std::uint64_t seed{0};
+        for (; seed < MAX_SEED; ++seed)
+        {
+            taken.clear();
+            for (const size_type k : buckets[b])
+            {
+                const size_type slot = codegen_mix(codegen_mix(codegen_key_bits(keys[k])) ^ seed) & (NSLOTS - 1);
+
+                if (result.slots[slot] != nkeys || std::find(taken.cbegin(), taken.cend(), slot) != taken.cend())
+                {
+                    break;
+                }
+                taken.push_back(slot);
+            }
+            if (taken.size() == buckets[b].size())
+            {
+                break;
+            }
+        }
+        if (seed == MAX_SEED)
+        {
+            throw std::runtime_error("no perfect hash found, duplicate keys?");
+        }
+
+        result.seeds[b] = seed;
+        for (size_type i{0}; i < taken.size(); ++i)
+        {
+            result.slots[taken[i]] = buckets[b][i];
+        }
+    }
+
+    for (auto & slot : result.slots)
+    {
+        slot = slot == nkeys ? 0 : slot;
+    }
+
+    return result;
+}
+
+}  // namespace detail
+
+/*
+ * Writes a self-contained C++11 header scoring raw feature rows (model
+ * column order without the intercept, row-major) exactly like
+ * BatchScorer, with everything known about the model baked in:
+ *
+ *  - standardization folded into constexpr coefficients, the same way
+ *    BatchScorer folds it, terms with zero weights left out,
+ *  - density tables of integer keys dense enough are direct arrays,
+ *    others perfect hash tables (see detail::perfect_hash), both holding
+ *    densities already multiplied by their folded weight.
+ *
+ * Everything goes into namespace name, which also names the include
+ * guard. FINGERPRINT is model_fingerprint of the model, MODEL_PATH is
+ * path, where the model can be found, if any.
+ */
+inline
+void
+emit_scorer(std::ostream & os, const ModelView & model, const std::string & name, const std::string & path = "")
+{
+    // same rule as BatchScorer's direct tables
+    constexpr size_type DIRECT_SPARSITY{8};
+
+    const size_type NFEAT = model.ncols() - 1;
+
+    const double * theta = model.theta();
+    const double * mu = model.mu();
+    const double * dev = model.dev();
+
+    double bias{theta[0]};
+    std::vector<double> weights(NFEAT);
+
+    for (size_type c{1}; c < model.ncols(); ++c)
+    {
+        weights[c - 1] = theta[c] / dev[c];
+        bias -= theta[c] * mu[c] / dev[c];
+    }
+
+    // density encoded features enter through their tables only
+    std::vector<double> table_weights;
+    for (const auto & table : model.tables())
+    {
+        assert(table.column > 0);
+
+        table_weights.push_back(weights[table.column - 1]);
+        weights[table.column - 1] = 0.0;
+    }
+
+    std::string guard(name);
+    std::transform(guard.begin(), guard.end(), guard.begin(), [](char ch) { return std::isalnum(ch) ? std::toupper(ch) : '_'; });
+    guard += "_HPP_";
+
+    const std::ios::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+
+    // 17 significant digits read back to the same double
+    os << std::setprecision(17);
+
+    auto array = [&os](const char * type, const std::string & id, const double * values, size_type count)
+    {
+        os << "constexpr " << type << " " << id << "[" << count << "] =\n{";
+        for (size_type i{0}; i < count; ++i)
+        {
+            os << (i % 4 ? " " : "\n    ") << values[i] << (i + 1 < count ? "," : "");
+        }
+        os << "\n};\n\n";
+    };
+
+    os << "/*\n"
+        << " * Generated by codegen, do not edit.\n"
+        << " * Scorer of a model with " << NFEAT << " features and " << model.tables().size() << " density tables.\n"
+        << " */\n\n"
+        << "#ifndef " << guard << "\n#define " << guard << "\n\n"
+        << "#include <cstddef>\n#include <cstdint>\n#include <cstring>\n#include <cmath>\n\n"
+        << "namespace " << name << "\n{\n\n"
+        << "constexpr std::uint64_t FINGERPRINT{" << model_fingerprint(model) << "ULL};\n\n"
+        << "constexpr char MODEL_PATH[] = \"" << path << "\";\n\n"
+        << "constexpr std::size_t NFEATURES{" << NFEAT << "};\n\n"
+        << "constexpr double BIAS{" << bias << "};\n\n";
+
+    array("double", "WEIGHTS", weights.data(), NFEAT);
+
+    os << "namespace detail\n{\n\n"
+        << "inline std::uint64_t mix(std::uint64_t h)\n{\n"
+        << "    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;\n"
+        << "    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;\n"
+        << "    return h ^ (h >> 31);\n}\n\n"
+        << "inline std::uint64_t key_bits(double key)\n{\n"
+        << "    key = key == 0.0 ? 0.0 : key;\n"
+        << "    std::uint64_t bits;\n"
+        << "    std::memcpy(&bits, &key, sizeof (bits));\n"
+        << "    return bits;\n}\n\n";
+
+    std::vector<std::string> lookups;
+
+    for (size_type t{0}; t < model.tables().size(); ++t)
+    {
+        const ModelView::Table & table = model.tables()[t];
+        const size_type feature = table.column - 1;
+        const double weight = table_weights[t];
+
+        if (table.size == 0 || weight == 0.0)
+        {
+            continue;
+        }
+
+        const std::string id = "density_" + std::to_string(feature);
+        lookups.push_back(id);
+
+        std::vector<double> values(table.size);
+        for (size_type k{0}; k < table.size; ++k)
+        {
+            values[k] = weight * table.values[k];
+        }
+
+        const bool integral = std::all_of(table.keys, table.keys + table.size,
+            [](double key)
+            {
+                return key == std::floor(key) && std::fabs(key) < (1L << 30);
+            }
+        );
+        const long lo = table.keys[0];
+        const long hi = table.keys[table.size - 1];
+
+        if (integral && (size_type)(hi - lo) < DIRECT_SPARSITY * table.size)
+        {
+            std::vector<double> direct(hi - lo + 1, 0.0);
+            for (size_type k{0}; k < table.size; ++k)
+            {
+                direct[(long)table.keys[k] - lo] = values[k];
+            }
+
+            os << "// feature " << feature << ", keys " << lo << " ... " << hi << "\n";
+            array("double", id + "_values", direct.data(), direct.size());
+
+            os << "inline double " << id << "(double key)\n{\n"
+                << "    const double offset = key - (" << lo << ".0);\n"
+                << "    return (offset >= 0.0 && offset < " << direct.size() << ".0 && offset == (long)offset) ?\n"
+                << "        " << id << "_values[(std::size_t)offset] : 0.0;\n}\n\n";
+        }
+        else
+        {
+            const detail::PerfectHash hash = detail::perfect_hash(table.keys, table.size);
+
+            std::vector<double> slot_keys(hash.slots.size());
+            std::vector<double> slot_values(hash.slots.size(), 0.0);
+            for (size_type s{0}; s < hash.slots.size(); ++s)
+            {
+                slot_keys[s] = table.keys[hash.slots[s]];
+            }
+            for (size_type k{0}; k < table.size; ++k)
+            {
+                const std::uint64_t h = detail::codegen_mix(detail::codegen_key_bits(table.keys[k]));
+                slot_values[detail::codegen_mix(h ^ hash.seeds[h & (hash.seeds.size() - 1)]) & (hash.slots.size() - 1)] = values[k];
+            }
+
+            os << "// feature " << feature << ", " << table.size << " keys in " << hash.slots.size() << " slots\n"
+                << "constexpr std::uint64_t " << id << "_seeds[" << hash.seeds.size() << "] =\n{";
+            for (size_type b{0}; b < hash.seeds.size(); ++b)
+            {
+                os << (b % 8 ? " " : "\n    ") << hash.seeds[b] << "u" << (b + 1 < hash.seeds.size() ? "," : "");
+            }
+            os << "\n};\n\n";
+
+            array("double", id + "_keys", slot_keys.data(), slot_keys.size());
+            array("double", id + "_values", slot_values.data(), slot_values.size());
+
+            os << "inline double " << id << "(double key)\n{\n"
+                << "    const std::uint64_t h = mix(key_bits(key));\n"
+                << "    const std::size_t slot = mix(h ^ " << id << "_seeds[h & " << hash.seeds.size() - 1 << "u]) & "
+                << hash.slots.size() - 1 << "u;\n"
+                << "    return " << id << "_keys[slot] == key ? " << id << "_values[slot] : 0.0;\n}\n\n";
+        }
+    }
+
+    os << "}  // namespace detail\n\n";
+
+    os << "/// margin of one row of NFEATURES raw features\n"
+        << "inline double margin(const double * x)\n{\n"
+        << "    return BIAS";
+    for (size_type c{0}; c < NFEAT; ++c)
+    {
+        if (weights[c] != 0.0)
+        {
+            os << "\n        + WEIGHTS[" << c << "] * x[" << c << "]";
+        }
+    }
+    for (const auto & id : lookups)
+    {
+        os << "\n        + detail::" << id << "(x[" << id.substr(id.find('_') + 1) << "])";
+    }
+    os << ";\n}\n\n";
+
+    os << "inline void margins(const double * rows, std::size_t nrows, double * out)\n{\n"
+        << "    for (std::size_t r{0}; r < nrows; ++r)\n    {\n"
+        << "        out[r] = margin(rows + r * NFEATURES);\n    }\n}\n\n"
+        << "inline void probabilities(const double * rows, std::size_t nrows, double * out)\n{\n"
+        << "    for (std::size_t r{0}; r < nrows; ++r)\n    {\n"
+        << "        out[r] = 1.0 / (1.0 + std::exp(-margin(rows + r * NFEATURES)));\n    }\n}\n\n"
+        << "}  // namespace " << name << "\n\n"
+        << "#endif /* " << guard << " */\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+}  // namespace num
+
+#endif /* CODEGEN_HPP_ */
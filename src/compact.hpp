@@ -0,0 +1,200 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: compact.hpp
+ *
+ * Description:
+ *      Compact columnar feature store, dictionary or float encoded columns
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef COMPACT_HPP_
+#define COMPACT_HPP_
+
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Read-only matrix stored column by column, every column in one of:
+ *      Dict8   - uint8 codes into a dictionary of up to 256 distinct values
+ *      Dict16  - uint16 codes into a dictionary of up to 65536 values
+ *      Float   - values rounded to float
+ * whichever takes fewer bytes, dictionaries included. Dictionary columns
+ * are exact, float columns keep 24 bits of mantissa.
+ * Trip features are mostly small integers and low-cardinality codes, and
+ * standardization or density mapping does not change their cardinality,
+ * so most of them end up as 1 or 2 bytes per value instead of 8.
+ *
+ * Nothing is decoded upfront, kernels walk codes and look up
+ * dictionaries (or tables derived from them) in their inner loops.
+ */
+template<typename _ValueType>
+class CompactMatrix
+{
+public:
+    typedef _ValueType value_type;
+
+    enum class Encoding
+    {
+        Dict8,
+        Dict16,
+        Float
+    };
+
+    struct Column
+    {
+        Encoding encoding;
+        /// sorted distinct values, for Dict8 and Dict16
+        std::vector<value_type> dict;
+        std::vector<std::uint8_t> codes8;
+        std::vector<std::uint16_t> codes16;
+        std::vector<float> values;
+    };
+
+    explicit CompactMatrix(const array2d<value_type> & X);
+
+    shape_type shape(void) const
+    {
+        return m_shape;
+    }
+
+    const Column & column(size_type c) const
+    {
+        return m_columns[c];
+    }
+
+    value_type at(size_type r, size_type c) const;
+
+    /// bytes taken by codes, values and dictionaries
+    size_type nbytes(void) const;
+
+private:
+    shape_type m_shape;
+    std::vector<Column> m_columns;
+};
+
+template<typename _ValueType>
+CompactMatrix<_ValueType>::CompactMatrix(const array2d<value_type> & X)
+:
+    m_shape{X.shape()},
+    m_columns(X.shape().second)
+{
+    const size_type NROWS = m_shape.first;
+    const size_type NCOLS = m_shape.second;
+
+    for (size_type c{0}; c < NCOLS; ++c)
+    {
+        Column & column = m_columns[c];
+
+        std::vector<value_type> dict(NROWS);
+        for (size_type r{0}; r < NROWS; ++r)
+        {
+            dict[r] = X.data()[r * NCOLS + c];
+        }
+        std::sort(dict.begin(), dict.end());
+        dict.erase(std::unique(dict.begin(), dict.end()), dict.end());
+
+        auto code = [&dict](value_type v) -> size_type
+        {
+            return std::lower_bound(dict.cbegin(), dict.cend(), v) - dict.cbegin();
+        };
+
+        // dictionaries of near-continuous columns cost more than floats
+        const size_type DICT_BYTES = dict.size() * sizeof (value_type);
+
+        if (dict.size() <= (size_type)std::numeric_limits<std::uint8_t>::max() + 1 &&
+            NROWS * sizeof (std::uint8_t) + DICT_BYTES <= NROWS * sizeof (float))
+        {
+            column.encoding = Encoding::Dict8;
+            column.codes8.resize(NROWS);
+            for (size_type r{0}; r < NROWS; ++r)
+            {
+                column.codes8[r] = code(X.data()[r * NCOLS + c]);
+            }
+            column.dict = std::move(dict);
+        }
+        else if (dict.size() <= (size_type)std::numeric_limits<std::uint16_t>::max() + 1 &&
+            NROWS * sizeof (std::uint16_t) + DICT_BYTES <= NROWS * sizeof (float))
+        {
+            column.encoding = Encoding::Dict16;
+            column.codes16.resize(NROWS);
+            for (size_type r{0}; r < NROWS; ++r)
+            {
+                column.codes16[r] = code(X.data()[r * NCOLS + c]);
+            }
+            column.dict = std::move(dict);
+        }
+        else
+        {
+            column.encoding = Encoding::Float;
+            column.values.resize(NROWS);
+            for (size_type r{0}; r < NROWS; ++r)
+            {
+                column.values[r] = X.data()[r * NCOLS + c];
+            }
+        }
+    }
+}
+
+template<typename _ValueType>
+typename CompactMatrix<_ValueType>::value_type
+CompactMatrix<_ValueType>::at(size_type r, size_type c) const
+{
+    const Column & column = m_columns[c];
+
+    switch (column.encoding)
+    {
+    case Encoding::Dict8:
+        return column.dict[column.codes8[r]];
+    case Encoding::Dict16:
+        return column.dict[column.codes16[r]];
+    case Encoding::Float:
+    default:
+        return column.values[r];
+    }
+}
+
+template<typename _ValueType>
+size_type
+CompactMatrix<_ValueType>::nbytes(void) const
+{
+    size_type result{0};
+
+    for (const auto & column : m_columns)
+    {
+        result +=
+            column.dict.size() * sizeof (value_type) +
+            column.codes8.size() * sizeof (std::uint8_t) +
+            column.codes16.size() * sizeof (std::uint16_t) +
+            column.values.size() * sizeof (float);
+    }
+
+    return result;
+}
+
+}  // namespace num
+
+#endif /* COMPACT_HPP_ */
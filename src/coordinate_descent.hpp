@@ -0,0 +1,491 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: coordinate_descent.hpp
+ *
+ * Description:
+ *      L1 / elastic-net logistic regression, coordinate descent
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef COORDINATE_DESCENT_HPP_
+#define COORDINATE_DESCENT_HPP_
+
+#include "array2d.hpp"
+#include "sigmoid.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Minimized objective, column 0 being the unpenalized intercept:
+ *      sum_i logloss_i / m + lambda * (l1_ratio * |theta|_1 + (1 - l1_ratio) / 2 * |theta|_2^2)
+ */
+template<typename _ValueType = double>
+struct ElasticNetCfg
+{
+    ElasticNetCfg()
+    :
+        m_lambda{1e-3},
+        m_l1_ratio{1.0},
+        m_path_length{10},
+        m_max_newton{25},
+        m_max_sweeps{200},
+        m_tol{1e-7},
+        m_strong_rules{true}
+    {}
+
+    _ValueType lambda(void) const
+    {
+        return m_lambda;
+    }
+
+    ElasticNetCfg & lambda(_ValueType _lambda)
+    {
+        m_lambda = _lambda;
+        return *this;
+    }
+
+    _ValueType l1_ratio(void) const
+    {
+        return m_l1_ratio;
+    }
+
+    /// 1 is lasso, 0 is ridge
+    ElasticNetCfg & l1_ratio(_ValueType _l1_ratio)
+    {
+        m_l1_ratio = _l1_ratio;
+        return *this;
+    }
+
+    size_type path_length(void) const
+    {
+        return m_path_length;
+    }
+
+    /// number of warm started lambdas, geometric from the smallest lambda
+    /// giving an all-zero model down to lambda(); 1 solves for lambda() only
+    ElasticNetCfg & path_length(size_type _path_length)
+    {
+        m_path_length = _path_length;
+        return *this;
+    }
+
+    size_type max_newton(void) const
+    {
+        return m_max_newton;
+    }
+
+    /// quadratic approximations of the loss per lambda
+    ElasticNetCfg & max_newton(size_type _max_newton)
+    {
+        m_max_newton = _max_newton;
+        return *this;
+    }
+
+    size_type max_sweeps(void) const
+    {
+        return m_max_sweeps;
+    }
+
+    /// coordinate sweeps per quadratic approximation
+    ElasticNetCfg & max_sweeps(size_type _max_sweeps)
+    {
+        m_max_sweeps = _max_sweeps;
+        return *this;
+    }
+
+    _ValueType tol(void) const
+    {
+        return m_tol;
+    }
+
+    /// largest curvature weighted squared coefficient change to stop at
+    ElasticNetCfg & tol(_ValueType _tol)
+    {
+        m_tol = _tol;
+        return *this;
+    }
+
+    bool strong_rules(void) const
+    {
+        return m_strong_rules;
+    }
+
+    /// discard features by the sequential strong rule, KKT checked afterwards
+    ElasticNetCfg & strong_rules(bool _strong_rules)
+    {
+        m_strong_rules = _strong_rules;
+        return *this;
+    }
+
+    _ValueType m_lambda;
+    _ValueType m_l1_ratio;
+    size_type m_path_length;
+    size_type m_max_newton;
+    size_type m_max_sweeps;
+    _ValueType m_tol;
+    bool m_strong_rules;
+};
+
+namespace detail
+{
+
+template<typename _ValueType>
+inline
+_ValueType
+soft_threshold(_ValueType z, _ValueType gamma)
+{
+    return z > gamma ? z - gamma : z < -gamma ? z + gamma : 0.0;
+}
+
+/*
+ * State of the solver: X copied column by column, so that a coordinate
+ * update streams one contiguous column, and margins eta = X * theta
+ * kept up to date with every coordinate change.
+ */
+template<typename _ValueType>
+struct ElasticNetSolver
+{
+    typedef _ValueType value_type;
+    typedef std::valarray<value_type> vector_type;
+
+    ElasticNetSolver(const array2d<value_type> & X, const vector_type & y, const vector_type & theta)
+    :
+        NROWS{X.shape().first},
+        NCOLS{X.shape().second},
+        columns(NROWS * NCOLS),
+        y(y),
+        theta(theta),
+        eta(0.0, NROWS),
+        w(NROWS),
+        r(NROWS),
+        xwx(NCOLS),
+        column_passes{0}
+    {
+        for (size_type row{0}; row < NROWS; ++row)
+        {
+            for (size_type c{0}; c < NCOLS; ++c)
+            {
+                columns[c * NROWS + row] = X.data()[row * NCOLS + c];
+            }
+        }
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            if (theta[c] != 0.0)
+            {
+                axpy(theta[c], c, eta);
+            }
+        }
+    }
+
+    const value_type * column(size_type c) const
+    {
+        return &columns[c * NROWS];
+    }
+
+    void axpy(value_type a, size_type c, vector_type & v) const
+    {
+        const value_type * x = column(c);
+        for (size_type row{0}; row < NROWS; ++row)
+        {
+            v[row] += a * x[row];
+        }
+    }
+
+    /// |x_c' * (y - p)| / m for every c at the current theta, p = sigmoid(eta)
+    vector_type abs_scores(void)
+    {
+        vector_type residual(NROWS);
+        for (size_type row{0}; row < NROWS; ++row)
+        {
+            residual[row] = y[row] - sigmoid(eta[row]);
+        }
+
+        vector_type result(NCOLS);
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            const value_type * x = column(c);
+            value_type s{0.0};
+            for (size_type row{0}; row < NROWS; ++row)
+            {
+                s += x[row] * residual[row];
+            }
+            result[c] = std::fabs(s) / NROWS;
+        }
+        column_passes += NCOLS;
+
+        return result;
+    }
+
+    /// one coordinate step of the penalized weighted least squares problem,
+    /// returns the curvature weighted squared change
+    value_type update(size_type c, value_type l1, value_type l2)
+    {
+        const value_type * x = column(c);
+
+        value_type g{0.0};
+        for (size_type row{0}; row < NROWS; ++row)
+        {
+            g += w[row] * x[row] * r[row];
+        }
+        g = g / NROWS + xwx[c] * theta[c];
+        ++column_passes;
+
+        const value_type updated = c == 0 ?
+            g / xwx[c] :
+            soft_threshold(g, l1) / (xwx[c] + l2);
+        const value_type delta = updated - theta[c];
+
+        if (delta == 0.0)
+        {
+            return 0.0;
+        }
+
+        for (size_type row{0}; row < NROWS; ++row)
+        {
+            r[row] -= delta * x[row];
+            eta[row] += delta * x[row];
+        }
+        theta[c] = updated;
+
+        return xwx[c] * delta * delta;
+    }
+
+    /// minimizes the objective over coordinates in set, others stay fixed
+    void solve(const std::vector<size_type> & set, value_type l1, value_type l2, const ElasticNetCfg<value_type> & cfg)
+    {
+        for (size_type newton{0}; newton < cfg.max_newton(); ++newton)
+        {
+            // quadratic approximation at eta: IRLS weights and working residuals
+            for (size_type row{0}; row < NROWS; ++row)
+            {
+                const value_type p = sigmoid(eta[row]);
+                w[row] = std::max<value_type>(p * (1.0 - p), 1e-5);
+                r[row] = (y[row] - p) / w[row];
+            }
+            for (const size_type c : set)
+            {
+                const value_type * x = column(c);
+                value_type s{0.0};
+                for (size_type row{0}; row < NROWS; ++row)
+                {
+                    s += w[row] * x[row] * x[row];
+                }
+                xwx[c] = s / NROWS;
+            }
+            column_passes += set.size();
+
+            value_type newton_change{0.0};
+
+            for (size_type sweep{0}; sweep < cfg.max_sweeps(); ++sweep)
+            {
+                // full sweep over the set, then sweeps over its active
+                // (nonzero) part only until those converge
+                value_type change{0.0};
+                std::vector<size_type> active;
+
+                for (const size_type c : set)
+                {
+                    change = std::max(change, update(c, l1, l2));
+                    if (theta[c] != 0.0 || c == 0)
+                    {
+                        active.push_back(c);
+                    }
+                }
+                newton_change = std::max(newton_change, change);
+
+                if (change < cfg.tol())
+                {
+                    break;
+                }
+
+                for (; sweep < cfg.max_sweeps(); ++sweep)
+                {
+                    value_type active_change{0.0};
+                    for (const size_type c : active)
+                    {
+                        active_change = std::max(active_change, update(c, l1, l2));
+                    }
+                    if (active_change < cfg.tol())
+                    {
+                        break;
+                    }
+                }
+            }
+
+            if (newton_change < cfg.tol())
+            {
+                break;
+            }
+        }
+    }
+
+    const size_type NROWS;
+    const size_type NCOLS;
+    std::vector<value_type> columns;
+    const vector_type & y;
+    vector_type theta;
+    vector_type eta;
+    vector_type w;
+    vector_type r;
+    vector_type xwx;
+    size_type column_passes;
+};
+
+}  // namespace detail
+
+/*
+ * Elastic-net logistic regression by coordinate descent over quadratic
+ * approximations of the loss. Column 0 of X is the intercept.
+ *
+ * lambda is reached along a warm started path. At every lambda of the
+ * path coordinates run over a working set only: features the sequential
+ * strong rule keeps,
+ *      |x_c' * (y - p)| / m >= l1_ratio * (2 * lambda_k - lambda_k-1),
+ * and those already nonzero. Within it sweeps go over nonzero coefficients
+ * until they settle. Features outside of the set are checked against the
+ * KKT conditions afterwards and the violators added, so the solution is
+ * that of the full problem. Most zero coefficients are never updated.
+ */
+template<typename _ValueType>
+std::valarray<_ValueType>
+elastic_net_fit(
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::valarray<_ValueType> & theta0,
+    const ElasticNetCfg<_ValueType> & cfg,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef _ValueType value_type;
+    typedef std::valarray<value_type> vector_type;
+
+    const size_type NCOLS = X.shape().second;
+
+    assert(y.size() == X.shape().first);
+    assert(theta0.size() == NCOLS);
+    assert(NCOLS > 0);
+    assert(cfg.lambda() > 0.0);
+    assert(cfg.l1_ratio() >= 0.0 && cfg.l1_ratio() <= 1.0);
+
+    detail::ElasticNetSolver<value_type> solver(X, y, theta0);
+
+    const value_type alpha = cfg.l1_ratio();
+
+    // smallest lambda with all penalized coefficients at 0, given the
+    // intercept alone fitted
+    value_type lambda_max{cfg.lambda()};
+    if (alpha > 0.0 && cfg.path_length() > 1)
+    {
+        vector_type intercept_only(0.0, NCOLS);
+        intercept_only[0] = theta0[0];
+        detail::ElasticNetSolver<value_type> null_model(X, y, intercept_only);
+        null_model.solve({0}, 0.0, 0.0, cfg);
+
+        const vector_type scores = null_model.abs_scores();
+        lambda_max = std::max(cfg.lambda(), vector_type(scores[std::slice(1, NCOLS - 1, 1)]).max() / alpha);
+        solver.column_passes += null_model.column_passes;
+    }
+
+    std::vector<value_type> path{lambda_max};
+    if (lambda_max > cfg.lambda())
+    {
+        const value_type ratio = std::pow(cfg.lambda() / lambda_max, 1.0 / (cfg.path_length() - 1));
+        for (size_type k{1}; k + 1 < cfg.path_length(); ++k)
+        {
+            path.push_back(path.back() * ratio);
+        }
+        path.push_back(cfg.lambda());
+    }
+
+    value_type lambda_prev{lambda_max};
+
+    for (const value_type lambda : path)
+    {
+        const value_type l1 = lambda * alpha;
+        const value_type l2 = lambda * (1.0 - alpha);
+
+        const bool screen = cfg.strong_rules() && alpha > 0.0;
+
+        std::vector<bool> in_set(NCOLS, !screen);
+        in_set[0] = true;
+
+        if (screen)
+        {
+            const vector_type scores = solver.abs_scores();
+            for (size_type c{1}; c < NCOLS; ++c)
+            {
+                in_set[c] = solver.theta[c] != 0.0 || scores[c] >= alpha * (2.0 * lambda - lambda_prev);
+            }
+        }
+
+        while (true)
+        {
+            std::vector<size_type> set;
+            for (size_type c{0}; c < NCOLS; ++c)
+            {
+                if (in_set[c])
+                {
+                    set.push_back(c);
+                }
+            }
+
+            solver.solve(set, l1, l2, cfg);
+
+            if (set.size() == NCOLS)
+            {
+                break;
+            }
+
+            // KKT: a discarded coefficient stays at 0 iff its score is within l1
+            const vector_type scores = solver.abs_scores();
+            bool violated{false};
+            for (size_type c{1}; c < NCOLS; ++c)
+            {
+                if (!in_set[c] && scores[c] > l1 * (1.0 + 1e-6))
+                {
+                    in_set[c] = true;
+                    violated = true;
+                }
+            }
+            if (!violated)
+            {
+                break;
+            }
+        }
+
+        lambda_prev = lambda;
+    }
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = solver.column_passes * X.shape().first / NCOLS;
+    }
+
+    return solver.theta;
+}
+
+}  // namespace num
+
+#endif /* COORDINATE_DESCENT_HPP_ */
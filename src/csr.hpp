@@ -0,0 +1,182 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: csr.hpp
+ *
+ * Description:
+ *      Compressed sparse row matrix, one-hot encoding of categorical columns
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef CSR_HPP_
+#define CSR_HPP_
+
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <vector>
+#include <map>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Sparse matrix in compressed sparse row layout: entries of row r are
+ * col_idx() / values() at [row_ptr()[r], row_ptr()[r + 1]).
+ * Built row by row with push_back and end_row.
+ */
+template<typename _ValueType>
+class csr_matrix
+{
+public:
+    typedef _ValueType value_type;
+
+    explicit csr_matrix(size_type ncols = 0)
+    :
+        m_ncols{ncols},
+        m_row_ptr{0},
+        m_col_idx{},
+        m_values{}
+    {}
+
+    shape_type shape(void) const
+    {
+        return {m_row_ptr.size() - 1, m_ncols};
+    }
+
+    size_type nnz(void) const
+    {
+        return m_values.size();
+    }
+
+    /// entry of the row being built
+    void push_back(size_type col, value_type value)
+    {
+        assert(col < m_ncols);
+
+        m_col_idx.push_back(col);
+        m_values.push_back(value);
+    }
+
+    /// closes the row being built, possibly empty
+    void end_row(void)
+    {
+        m_row_ptr.push_back(m_values.size());
+    }
+
+    const size_type * row_ptr(void) const
+    {
+        return m_row_ptr.data();
+    }
+
+    const size_type * col_idx(void) const
+    {
+        return m_col_idx.data();
+    }
+
+    const value_type * values(void) const
+    {
+        return m_values.data();
+    }
+
+private:
+    size_type m_ncols;
+    std::vector<size_type> m_row_ptr;
+    std::vector<size_type> m_col_idx;
+    std::vector<value_type> m_values;
+};
+
+/*
+ * One-hot encoding of categorical columns of a dense matrix. Categories
+ * are the values seen by the constructor, each column gets its own block
+ * of indicator columns. Values not seen are encoded as all-zero.
+ */
+template<typename _ValueType>
+class OneHotEncoder
+{
+public:
+    typedef _ValueType value_type;
+
+    OneHotEncoder(const array2d<value_type> & X, const std::vector<size_type> & columns);
+
+    /// number of indicator columns
+    size_type ncols(void) const
+    {
+        return m_ncols;
+    }
+
+    csr_matrix<value_type> encode(const array2d<value_type> & X) const;
+
+private:
+    std::vector<size_type> m_columns;
+    /// category -> indicator column, for every encoded column
+    std::vector<std::map<value_type, size_type>> m_categories;
+    size_type m_ncols;
+};
+
+template<typename _ValueType>
+OneHotEncoder<_ValueType>::OneHotEncoder(const array2d<value_type> & X, const std::vector<size_type> & columns)
+:
+    m_columns(columns),
+    m_categories(columns.size()),
+    m_ncols{0}
+{
+    const size_type NCOLS = X.shape().second;
+
+    for (size_type k{0}; k < m_columns.size(); ++k)
+    {
+        assert(m_columns[k] < NCOLS);
+
+        auto & categories = m_categories[k];
+        for (size_type r{0}; r < X.shape().first; ++r)
+        {
+            categories.emplace(X.data()[r * NCOLS + m_columns[k]], 0);
+        }
+        for (auto & category : categories)
+        {
+            category.second = m_ncols++;
+        }
+    }
+}
+
+template<typename _ValueType>
+csr_matrix<_ValueType>
+OneHotEncoder<_ValueType>::encode(const array2d<value_type> & X) const
+{
+    const size_type NCOLS = X.shape().second;
+
+    csr_matrix<value_type> result(m_ncols);
+
+    for (size_type r{0}; r < X.shape().first; ++r)
+    {
+        for (size_type k{0}; k < m_columns.size(); ++k)
+        {
+            const auto found = m_categories[k].find(X.data()[r * NCOLS + m_columns[k]]);
+            if (found != m_categories[k].cend())
+            {
+                result.push_back(found->second, 1.0);
+            }
+        }
+        result.end_row();
+    }
+
+    return result;
+}
+
+}  // namespace num
+
+#endif /* CSR_HPP_ */
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: dedup.hpp
+ *
+ * Description:
+ *      Deduplication of identical feature rows into rows with label counts
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef DEDUP_HPP_
+#define DEDUP_HPP_
+
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Unique feature rows, with the number of positive (y = 1) and negative
+ * (y = 0) records each of them stands for.
+ */
+template<typename _ValueType>
+struct UniqueRows
+{
+    array2d<_ValueType> X;
+    std::valarray<_ValueType> pos;
+    std::valarray<_ValueType> neg;
+};
+
+namespace detail
+{
+
+/*
+ * Hashing and comparison of rows of a matrix, rows are referred to by
+ * their index. -0 and +0 hash the same, so that == equal rows collide.
+ */
+template<typename _ValueType>
+struct RowHash
+{
+    const _ValueType * data;
+    size_type ncols;
+
+    std::size_t operator()(size_type r) const
+    {
+        // FNV-1a over bit patterns
+        std::uint64_t h{14695981039346656037ULL};
+        for (const _ValueType * x = data + r * ncols; x != data + (r + 1) * ncols; ++x)
+        {
+            std::uint64_t bits{0};
+            std::memcpy(&bits, x, sizeof (*x));
+
+            // not (*x == 0) ? 0 : *x, -ffast-math may fold that into *x
+            if (*x == 0)
+            {
+                bits = 0;
+            }
+
+            h = (h ^ bits) * 1099511628211ULL;
+        }
+        return h ^ (h >> 32);
+    }
+};
+
+template<typename _ValueType>
+struct RowEqual
+{
+    const _ValueType * data;
+    size_type ncols;
+
+    bool operator()(size_type p, size_type q) const
+    {
+        return std::equal(data + p * ncols, data + (p + 1) * ncols, data + q * ncols);
+    }
+};
+
+}  // namespace detail
+
+/*
+ * Collapses identical rows of X, labels y have to be 0/1. Unique rows
+ * keep the order of their first occurrence.
+ */
+template<typename _ValueType>
+UniqueRows<_ValueType>
+dedup_rows(const array2d<_ValueType> & X, const std::valarray<_ValueType> & y)
+{
+    typedef _ValueType value_type;
+
+    const size_type NROWS = X.shape().first;
+    const size_type NCOLS = X.shape().second;
+
+    assert(y.size() == NROWS);
+
+    const detail::RowHash<value_type> hash{X.data(), NCOLS};
+    const detail::RowEqual<value_type> equal{X.data(), NCOLS};
+
+    // first occurrence row -> unique row number
+    std::unordered_map<size_type, size_type, detail::RowHash<value_type>, detail::RowEqual<value_type>>
+        index(NROWS, hash, equal);
+
+    std::vector<size_type> firsts;
+    std::vector<value_type> pos;
+    std::vector<value_type> neg;
+
+    for (size_type r{0}; r < NROWS; ++r)
+    {
+        assert(y[r] == 0.0 || y[r] == 1.0);
+
+        const auto found = index.emplace(r, firsts.size());
+        if (found.second)
+        {
+            firsts.push_back(r);
+            pos.push_back(0.0);
+            neg.push_back(0.0);
+        }
+
+        const size_type u = found.first->second;
+        (y[r] > 0.0 ? pos[u] : neg[u]) += 1.0;
+    }
+
+    UniqueRows<value_type> result{
+        array2d<value_type>({firsts.size(), NCOLS}, 0.0),
+        std::valarray<value_type>(pos.data(), pos.size()),
+        std::valarray<value_type>(neg.data(), neg.size())
+    };
+
+    for (size_type u{0}; u < firsts.size(); ++u)
+    {
+        result.X[result.X.row(u)] = X[X.row(firsts[u])];
+    }
+
+    return result;
+}
+
+}  // namespace num
+
+#endif /* DEDUP_HPP_ */
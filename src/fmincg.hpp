@@ -74,6 +74,8 @@
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <functional>
+#include <limits>
 
 namespace num
 {
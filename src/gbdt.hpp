@@ -0,0 +1,736 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: gbdt.hpp
+ *
+ * Description:
+ *      Histogram based gradient boosted decision trees, logistic loss
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef GBDT_HPP_
+#define GBDT_HPP_
+
+#include "array2d.hpp"
+#include "sigmoid.hpp"
+#include "thread_pool.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <future>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+#include <cassert>
+
+namespace num
+{
+
+template<typename _ValueType = double>
+struct GbdtCfg
+{
+    GbdtCfg()
+    :
+        m_ntrees{100},
+        m_max_depth{6},
+        m_learning_rate{0.1},
+        m_max_bins{255},
+        m_min_samples_leaf{20},
+        m_min_hessian{1e-3},
+        m_lambda{1.0},
+        m_threads{std::max(1u, std::thread::hardware_concurrency())}
+    {}
+
+    size_type ntrees(void) const
+    {
+        return m_ntrees;
+    }
+
+    GbdtCfg & ntrees(size_type _ntrees)
+    {
+        m_ntrees = _ntrees;
+        return *this;
+    }
+
+    size_type max_depth(void) const
+    {
+        return m_max_depth;
+    }
+
+    GbdtCfg & max_depth(size_type _max_depth)
+    {
+        m_max_depth = _max_depth;
+        return *this;
+    }
+
+    _ValueType learning_rate(void) const
+    {
+        return m_learning_rate;
+    }
+
+    /// shrinkage of leaf values
+    GbdtCfg & learning_rate(_ValueType _learning_rate)
+    {
+        m_learning_rate = _learning_rate;
+        return *this;
+    }
+
+    size_type max_bins(void) const
+    {
+        return m_max_bins;
+    }
+
+    /// bins per feature, at most 256 so that codes fit in uint8
+    GbdtCfg & max_bins(size_type _max_bins)
+    {
+        m_max_bins = _max_bins;
+        return *this;
+    }
+
+    size_type min_samples_leaf(void) const
+    {
+        return m_min_samples_leaf;
+    }
+
+    GbdtCfg & min_samples_leaf(size_type _min_samples_leaf)
+    {
+        m_min_samples_leaf = _min_samples_leaf;
+        return *this;
+    }
+
+    _ValueType min_hessian(void) const
+    {
+        return m_min_hessian;
+    }
+
+    /// minimum sum of hessians in a leaf
+    GbdtCfg & min_hessian(_ValueType _min_hessian)
+    {
+        m_min_hessian = _min_hessian;
+        return *this;
+    }
+
+    _ValueType lambda(void) const
+    {
+        return m_lambda;
+    }
+
+    /// L2 regularization of leaf values
+    GbdtCfg & lambda(_ValueType _lambda)
+    {
+        m_lambda = _lambda;
+        return *this;
+    }
+
+    size_type threads(void) const
+    {
+        return m_threads;
+    }
+
+    GbdtCfg & threads(size_type _threads)
+    {
+        m_threads = _threads;
+        return *this;
+    }
+
+    size_type m_ntrees;
+    size_type m_max_depth;
+    _ValueType m_learning_rate;
+    size_type m_max_bins;
+    size_type m_min_samples_leaf;
+    _ValueType m_min_hessian;
+    _ValueType m_lambda;
+    size_type m_threads;
+};
+
+/*
+ * Binary classifier boosting regression trees on the gradient and hessian
+ * of the logistic loss.
+ *
+ * Features are binned once, before training: every feature gets up to
+ * max_bins bins bounded by quantile cut points (one bin per distinct
+ * value when there are few), rows are coded as max_bins <= 256 uint8
+ * codes, row-major, so that a row's codes share a cache line.
+ *
+ * Trees are grown depth-first. Rows of a node are a contiguous range of
+ * an index array, which is stably partitioned on split. Split finding
+ * scans per-node histograms of gradient/hessian sums over bins; only the
+ * smaller child gets its histogram built from rows, the larger one is
+ * the parent's histogram minus it. Histograms of large nodes are built
+ * over row chunks on a thread pool and reduced.
+ *
+ * Splits are kept as raw feature thresholds, so prediction does not need
+ * binning.
+ */
+template<typename _ValueType = double>
+class GradientBoostedTrees
+{
+public:
+    typedef _ValueType value_type;
+    typedef array2d<value_type> array_type;
+    typedef std::valarray<value_type> vector_type;
+
+    explicit GradientBoostedTrees(const GbdtCfg<value_type> & cfg = GbdtCfg<value_type>());
+
+    /// y in {0, 1}
+    void fit(const array_type & X, const vector_type & y);
+
+    /// log odds of the positive class
+    vector_type margins(const array_type & X) const;
+
+    vector_type predict_proba(const array_type & X) const;
+
+    size_type ntrees(void) const
+    {
+        return m_trees.size();
+    }
+
+private:
+    struct Node
+    {
+        /// LEAF for leaves
+        std::uint32_t feature;
+        /// go left if x[feature] <= threshold
+        value_type threshold;
+        std::uint32_t left;
+        std::uint32_t right;
+        value_type value;
+    };
+
+    static constexpr std::uint32_t LEAF = std::numeric_limits<std::uint32_t>::max();
+
+    struct HistBin
+    {
+        double g;
+        double h;
+        double n;
+    };
+
+    typedef std::vector<HistBin> histogram_type;
+
+    struct GradHess
+    {
+        double g;
+        double h;
+    };
+
+    struct Split
+    {
+        double gain;
+        size_type feature;
+        size_type bin;
+    };
+
+    /// nodes smaller than this get their histograms built by a single thread
+    static constexpr size_type PARALLEL_MIN_ROWS = 1 << 14;
+
+    void make_bins(const array_type & X);
+    void encode(const array_type & X);
+
+    void build_histogram(histogram_type & hist, size_type begin, size_type end);
+    Split find_split(const histogram_type & hist, const HistBin & total) const;
+    size_type partition(size_type begin, size_type end, size_type feature, size_type bin);
+
+    void grow(
+        std::vector<Node> & tree,
+        size_type node,
+        histogram_type & hist,
+        const HistBin & total,
+        size_type begin,
+        size_type end,
+        size_type depth,
+        vector_type & F);
+
+    value_type leaf_value(const HistBin & total) const
+    {
+        return -m_cfg.learning_rate() * total.g / (total.h + m_cfg.lambda());
+    }
+
+    value_type score(const value_type * x) const;
+
+    const GbdtCfg<value_type> m_cfg;
+
+    value_type m_base;
+    std::vector<std::vector<Node>> m_trees;
+
+    /// per feature upper bin edges, bin b holds (cuts[b - 1], cuts[b]]
+    std::vector<std::vector<value_type>> m_cuts;
+    /// first bin of every feature in a histogram
+    std::vector<size_type> m_offsets;
+
+    // training state
+    size_type m_nfeat;
+    std::vector<std::uint8_t> m_codes;
+    /// the same codes feature-major, for partitioning on a single feature
+    std::vector<std::uint8_t> m_feature_codes;
+    std::vector<std::uint32_t> m_rows;
+    std::vector<std::uint32_t> m_scratch;
+    /// gradient and hessian of every row, side by side for one load
+    std::vector<GradHess> m_gh;
+    std::unique_ptr<ThreadPool> m_pool;
+    std::vector<histogram_type> m_local;
+};
+
+template<typename _ValueType>
+GradientBoostedTrees<_ValueType>::GradientBoostedTrees(const GbdtCfg<value_type> & cfg)
+:
+    m_cfg(cfg),
+    m_base{0.0},
+    m_trees{},
+    m_cuts{},
+    m_offsets{},
+    m_nfeat{0},
+    m_codes{},
+    m_feature_codes{},
+    m_rows{},
+    m_scratch{},
+    m_gh{},
+    m_pool{},
+    m_local{}
+{
+    assert(cfg.max_bins() >= 2 && cfg.max_bins() <= 256);
+}
+
+template<typename _ValueType>
+void
+GradientBoostedTrees<_ValueType>::make_bins(const array_type & X)
+{
+    const size_type NROWS = X.shape().first;
+    const size_type MAX_CUTS = m_cfg.max_bins() - 1;
+
+    m_cuts.assign(m_nfeat, {});
+    m_offsets.assign(m_nfeat + 1, 0);
+
+    for (size_type f{0}; f < m_nfeat; ++f)
+    {
+        std::vector<value_type> values(NROWS);
+        for (size_type r{0}; r < NROWS; ++r)
+        {
+            values[r] = X.data()[r * m_nfeat + f];
+        }
+        std::sort(values.begin(), values.end());
+
+        std::vector<value_type> & cuts = m_cuts[f];
+
+        std::vector<value_type> distinct(values);
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+        if (distinct.size() <= MAX_CUTS + 1)
+        {
+            // a bin per distinct value, the last one is open ended
+            cuts.assign(distinct.begin(), distinct.end() - (distinct.empty() ? 0 : 1));
+        }
+        else
+        {
+            for (size_type q{1}; q <= MAX_CUTS; ++q)
+            {
+                const value_type cut = values[NROWS * q / (MAX_CUTS + 1)];
+                if (cuts.empty() || cut > cuts.back())
+                {
+                    cuts.push_back(cut);
+                }
+            }
+            if (!cuts.empty() && cuts.back() >= values.back())
+            {
+                cuts.pop_back();
+            }
+        }
+
+        m_offsets[f + 1] = m_offsets[f] + cuts.size() + 1;
+    }
+}
+
+template<typename _ValueType>
+void
+GradientBoostedTrees<_ValueType>::encode(const array_type & X)
+{
+    const size_type NROWS = X.shape().first;
+    const size_type NCHUNKS = std::max<size_type>(1, std::min(m_pool->size(), NROWS / PARALLEL_MIN_ROWS));
+
+    m_codes.resize(NROWS * m_nfeat);
+    m_feature_codes.resize(NROWS * m_nfeat);
+
+    std::vector<std::future<void>> done;
+    for (size_type chunk{0}; chunk < NCHUNKS; ++chunk)
+    {
+        done.push_back(m_pool->submit(
+            [this, &X, chunk, NROWS, NCHUNKS]()
+            {
+                for (size_type r{NROWS * chunk / NCHUNKS}; r < NROWS * (chunk + 1) / NCHUNKS; ++r)
+                {
+                    for (size_type f{0}; f < m_nfeat; ++f)
+                    {
+                        const std::vector<value_type> & cuts = m_cuts[f];
+                        const value_type x = X.data()[r * m_nfeat + f];
+
+                        m_codes[r * m_nfeat + f] = std::lower_bound(cuts.begin(), cuts.end(), x) - cuts.begin();
+                        m_feature_codes[f * NROWS + r] = m_codes[r * m_nfeat + f];
+                    }
+                }
+            }
+        ));
+    }
+    for (auto & d : done)
+    {
+        d.get();
+    }
+}
+
+template<typename _ValueType>
+void
+GradientBoostedTrees<_ValueType>::build_histogram(histogram_type & hist, size_type begin, size_type end)
+{
+    const size_type NBINS = m_offsets.back();
+    const size_type NCHUNKS = std::max<size_type>(1, std::min(m_pool->size(), (end - begin) / PARALLEL_MIN_ROWS));
+
+    auto accumulate = [this](histogram_type & out, size_type begin, size_type end)
+    {
+        const std::uint8_t * codes = m_codes.data();
+        const size_type * offsets = m_offsets.data();
+        HistBin * bins = out.data();
+
+        for (size_type i{begin}; i < end; ++i)
+        {
+            const std::uint32_t r = m_rows[i];
+            const std::uint8_t * code = codes + (size_type)r * m_nfeat;
+            const double g = m_gh[r].g;
+            const double h = m_gh[r].h;
+
+            for (size_type f{0}; f < m_nfeat; ++f)
+            {
+                HistBin & bin = bins[offsets[f] + code[f]];
+                bin.g += g;
+                bin.h += h;
+                bin.n += 1.0;
+            }
+        }
+    };
+
+    hist.assign(NBINS, HistBin{0.0, 0.0, 0.0});
+
+    if (NCHUNKS == 1)
+    {
+        accumulate(hist, begin, end);
+        return;
+    }
+
+    std::vector<std::future<void>> done;
+    for (size_type chunk{0}; chunk < NCHUNKS; ++chunk)
+    {
+        done.push_back(m_pool->submit(
+            [this, &accumulate, chunk, begin, end, NBINS, NCHUNKS]()
+            {
+                histogram_type & local = m_local[chunk];
+                local.assign(NBINS, HistBin{0.0, 0.0, 0.0});
+                accumulate(local, begin + (end - begin) * chunk / NCHUNKS, begin + (end - begin) * (chunk + 1) / NCHUNKS);
+            }
+        ));
+    }
+    for (auto & d : done)
+    {
+        d.get();
+    }
+
+    for (size_type chunk{0}; chunk < NCHUNKS; ++chunk)
+    {
+        for (size_type b{0}; b < NBINS; ++b)
+        {
+            hist[b].g += m_local[chunk][b].g;
+            hist[b].h += m_local[chunk][b].h;
+            hist[b].n += m_local[chunk][b].n;
+        }
+    }
+}
+
+template<typename _ValueType>
+typename GradientBoostedTrees<_ValueType>::Split
+GradientBoostedTrees<_ValueType>::find_split(const histogram_type & hist, const HistBin & total) const
+{
+    const double lambda = m_cfg.lambda();
+    const double parent = total.g * total.g / (total.h + lambda);
+
+    Split best{0.0, 0, 0};
+
+    for (size_type f{0}; f < m_nfeat; ++f)
+    {
+        HistBin left{0.0, 0.0, 0.0};
+
+        // the last bin cannot be a left side
+        for (size_type b{m_offsets[f]}; b + 1 < m_offsets[f + 1]; ++b)
+        {
+            left.g += hist[b].g;
+            left.h += hist[b].h;
+            left.n += hist[b].n;
+
+            const HistBin right{total.g - left.g, total.h - left.h, total.n - left.n};
+
+            if (left.n < m_cfg.min_samples_leaf() || left.h < m_cfg.min_hessian())
+            {
+                continue;
+            }
+            if (right.n < m_cfg.min_samples_leaf() || right.h < m_cfg.min_hessian())
+            {
+                break;
+            }
+
+            const double gain =
+                left.g * left.g / (left.h + lambda) + right.g * right.g / (right.h + lambda) - parent;
+
+            if (gain > best.gain)
+            {
+                best = Split{gain, f, b - m_offsets[f]};
+            }
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Stable partition of m_rows[begin, end) on code <= bin, returns the
+ * start of the right side. Stability keeps rows ascending, so histogram
+ * building walks codes forward.
+ */
+template<typename _ValueType>
+size_type
+GradientBoostedTrees<_ValueType>::partition(size_type begin, size_type end, size_type feature, size_type bin)
+{
+    const std::uint8_t * codes = m_feature_codes.data() + feature * m_rows.size();
+
+    size_type nleft{0};
+    size_type nright{0};
+
+    for (size_type i{begin}; i < end; ++i)
+    {
+        const std::uint32_t r = m_rows[i];
+
+        if (codes[r] <= bin)
+        {
+            m_rows[begin + nleft++] = r;
+        }
+        else
+        {
+            m_scratch[nright++] = r;
+        }
+    }
+    std::copy(m_scratch.cbegin(), m_scratch.cbegin() + nright, m_rows.begin() + begin + nleft);
+
+    return begin + nleft;
+}
+
+template<typename _ValueType>
+void
+GradientBoostedTrees<_ValueType>::grow(
+    std::vector<Node> & tree,
+    size_type node,
+    histogram_type & hist,
+    const HistBin & total,
+    size_type begin,
+    size_type end,
+    size_type depth,
+    vector_type & F)
+{
+    const Split split =
+        depth < m_cfg.max_depth() ? find_split(hist, total) : Split{0.0, 0, 0};
+
+    if (split.gain <= 0.0)
+    {
+        const value_type value = leaf_value(total);
+
+        tree[node] = Node{LEAF, 0.0, 0, 0, value};
+        for (size_type i{begin}; i < end; ++i)
+        {
+            F[m_rows[i]] += value;
+        }
+        return;
+    }
+
+    const size_type middle = partition(begin, end, split.feature, split.bin);
+
+    HistBin left_total{0.0, 0.0, 0.0};
+    for (size_type b{m_offsets[split.feature]}; b <= m_offsets[split.feature] + split.bin; ++b)
+    {
+        left_total.g += hist[b].g;
+        left_total.h += hist[b].h;
+        left_total.n += hist[b].n;
+    }
+    const HistBin right_total{total.g - left_total.g, total.h - left_total.h, total.n - left_total.n};
+
+    const std::uint32_t left = tree.size();
+    const std::uint32_t right = left + 1;
+    tree.resize(tree.size() + 2);
+    tree[node] = Node{(std::uint32_t)split.feature, m_cuts[split.feature][split.bin], left, right, 0.0};
+
+    const size_type nleft = middle - begin;
+    const size_type nright = end - middle;
+
+    // children that cannot be split any further need no histograms
+    const size_type MIN_SPLIT = 2 * m_cfg.min_samples_leaf();
+    if (depth + 1 >= m_cfg.max_depth() || (nleft < MIN_SPLIT && nright < MIN_SPLIT))
+    {
+        histogram_type none;
+        grow(tree, left, none, left_total, begin, middle, m_cfg.max_depth(), F);
+        grow(tree, right, none, right_total, middle, end, m_cfg.max_depth(), F);
+        return;
+    }
+
+    // histogram of the smaller child from its rows, the larger one by
+    // subtraction in place of the parent's
+    const bool left_smaller = nleft <= nright;
+
+    histogram_type small;
+    if (left_smaller)
+    {
+        build_histogram(small, begin, middle);
+    }
+    else
+    {
+        build_histogram(small, middle, end);
+    }
+
+    for (size_type b{0}; b < hist.size(); ++b)
+    {
+        hist[b].g -= small[b].g;
+        hist[b].h -= small[b].h;
+        hist[b].n -= small[b].n;
+    }
+
+    if (left_smaller)
+    {
+        grow(tree, left, small, left_total, begin, middle, depth + 1, F);
+        grow(tree, right, hist, right_total, middle, end, depth + 1, F);
+    }
+    else
+    {
+        grow(tree, left, hist, left_total, begin, middle, depth + 1, F);
+        grow(tree, right, small, right_total, middle, end, depth + 1, F);
+    }
+}
+
+template<typename _ValueType>
+void
+GradientBoostedTrees<_ValueType>::fit(const array_type & X, const vector_type & y)
+{
+    const size_type NROWS = X.shape().first;
+
+    assert(y.size() == NROWS);
+    assert(NROWS > 0);
+    assert(NROWS <= std::numeric_limits<std::uint32_t>::max());
+
+    m_nfeat = X.shape().second;
+    m_pool.reset(new ThreadPool(m_cfg.threads()));
+    m_local.assign(m_pool->size(), {});
+
+    make_bins(X);
+    encode(X);
+
+    // start from the log odds of the base rate
+    const double p0 = std::min(std::max(y.sum() / NROWS, 1e-6), 1.0 - 1e-6);
+    m_base = std::log(p0 / (1.0 - p0));
+
+    vector_type F(m_base, NROWS);
+
+    m_gh.resize(NROWS);
+    m_rows.resize(NROWS);
+    m_scratch.resize(NROWS);
+
+    m_trees.clear();
+
+    for (size_type t{0}; t < m_cfg.ntrees(); ++t)
+    {
+        HistBin total{0.0, 0.0, (double)NROWS};
+
+        for (size_type r{0}; r < NROWS; ++r)
+        {
+            const double p = sigmoid(F[r]);
+
+            m_gh[r] = GradHess{p - y[r], std::max(p * (1.0 - p), 1e-16)};
+
+            total.g += m_gh[r].g;
+            total.h += m_gh[r].h;
+        }
+
+        std::iota(m_rows.begin(), m_rows.end(), 0);
+
+        histogram_type hist;
+        build_histogram(hist, 0, NROWS);
+
+        std::vector<Node> tree(1);
+        grow(tree, 0, hist, total, 0, NROWS, 0, F);
+
+        m_trees.push_back(std::move(tree));
+    }
+
+    // training state is not needed for prediction
+    m_codes = std::vector<std::uint8_t>();
+    m_feature_codes = std::vector<std::uint8_t>();
+    m_rows = std::vector<std::uint32_t>();
+    m_scratch = std::vector<std::uint32_t>();
+    m_gh = std::vector<GradHess>();
+    m_local.clear();
+    m_pool.reset();
+}
+
+template<typename _ValueType>
+typename GradientBoostedTrees<_ValueType>::value_type
+GradientBoostedTrees<_ValueType>::score(const value_type * x) const
+{
+    value_type result{m_base};
+
+    for (const auto & tree : m_trees)
+    {
+        const Node * node = &tree[0];
+        while (node->feature != LEAF)
+        {
+            node = &tree[x[node->feature] <= node->threshold ? node->left : node->right];
+        }
+        result += node->value;
+    }
+
+    return result;
+}
+
+template<typename _ValueType>
+typename GradientBoostedTrees<_ValueType>::vector_type
+GradientBoostedTrees<_ValueType>::margins(const array_type & X) const
+{
+    assert(X.shape().second == m_nfeat);
+
+    vector_type result(X.shape().first);
+
+    for (size_type r{0}; r < X.shape().first; ++r)
+    {
+        result[r] = score(X.data() + r * m_nfeat);
+    }
+
+    return result;
+}
+
+template<typename _ValueType>
+typename GradientBoostedTrees<_ValueType>::vector_type
+GradientBoostedTrees<_ValueType>::predict_proba(const array_type & X) const
+{
+    return sigmoid(margins(X));
+}
+
+}  // namespace num
+
+#endif /* GBDT_HPP_ */
@@ -0,0 +1,388 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: gen_trips.cpp
+ *
+ * Description:
+ *      Synthetic trip records for scaling tests, events from a planted model
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "TripSafetyFactors.hpp"
+#include "ingest.hpp"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+
+namespace
+{
+
+typedef trip::col col;
+
+/// splitmix64, small and fast, with the same stream on every platform
+class Rng
+{
+public:
+    explicit Rng(std::uint64_t seed)
+    :
+        m_state{seed}
+    {}
+
+    std::uint64_t operator()(void)
+    {
+        std::uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    /// in [0, 1)
+    double uniform(void)
+    {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /// in [lo, hi]
+    long uniform(long lo, long hi)
+    {
+        return lo + (long)(uniform() * (hi - lo + 1));
+    }
+
+    double gauss(void)
+    {
+        // Box-Muller, one of the pair
+        const double u = 1.0 - uniform();
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * uniform());
+    }
+
+    bool bernoulli(double p)
+    {
+        return uniform() < p;
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+/*
+ * The planted model: per source and per pilot risks drawn once from the
+ * seed, event probability sigmoid(z) with z linear in a few columns.
+ * Rows are independent given the model.
+ */
+struct Planted
+{
+    Planted(std::uint64_t seed, std::size_t sources, std::size_t pilots, double intercept)
+    :
+        intercept{intercept},
+        source_risk(sources),
+        pilot_risk(pilots)
+    {
+        Rng rng(seed);
+
+        for (auto & risk : source_risk)
+        {
+            risk = 0.5 * rng.gauss();
+        }
+        for (auto & risk : pilot_risk)
+        {
+            risk = 0.7 * rng.gauss();
+        }
+    }
+
+    /// sets the event rate, about 13% at -4, 6% at -5
+    double intercept;
+    std::vector<double> source_risk;
+    std::vector<double> pilot_risk;
+};
+
+void append(std::string & out, long value)
+{
+    char buf[24];
+    char * end = buf + sizeof (buf);
+    char * p = end;
+    const bool negative = value < 0;
+    unsigned long v = negative ? -(unsigned long)value : value;
+
+    do
+    {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    if (negative)
+    {
+        *--p = '-';
+    }
+
+    out.append(p, end);
+}
+
+/// value with the given number of decimals, value >= 0
+void append(std::string & out, double value, int decimals)
+{
+    long scale{1};
+    for (int d{0}; d < decimals; ++d)
+    {
+        scale *= 10;
+    }
+
+    const long fixed = std::lround(value * scale);
+
+    append(out, fixed / scale);
+    out += '.';
+
+    std::string frac = std::to_string(fixed % scale);
+    out.append(decimals - frac.size(), '0');
+    out += frac;
+}
+
+/*
+ * Rows [first, first + nrows) as CSV text. Each chunk has its own random
+ * stream derived from the seed and its index, so the output depends on
+ * the seed and the chunk size only, not on the number of threads.
+ */
+std::string generate_chunk(
+    const Planted & planted,
+    std::uint64_t seed,
+    std::uint64_t chunk,
+    std::uint64_t first,
+    std::size_t nrows)
+{
+    Rng rng(Rng(seed ^ (chunk * 0xd1b54a32d192ed03ULL))());
+
+    std::string out;
+    out.reserve(nrows * 128);
+
+    const long SOURCES = planted.source_risk.size();
+    const long PILOTS = planted.pilot_risk.size();
+
+    long values[col::EVT_CNT + 1];
+
+    for (std::size_t i{0}; i < nrows; ++i)
+    {
+        values[col::ID] = first + i;
+        values[col::SOURCE] = rng.uniform(0, SOURCES - 1);
+        values[col::DIST] = rng.uniform(100, 3000);
+        values[col::CYCLES] = rng.uniform(1, 20);
+        values[col::COMPLEXITY] = rng.uniform(0, 10);
+        values[col::CARGO] = rng.uniform(0, 5);
+        values[col::STOPS] = rng.uniform(0, 5);
+        values[col::START_DAY] = rng.uniform(0, 730);
+        values[col::START_MONTH] = rng.uniform(1, 12);
+        values[col::START_DAY_OF_MONTH] = rng.uniform(1, 28);
+        values[col::START_DAY_OF_WEEK] = rng.uniform(0, 6);
+        const long hours = rng.uniform(0, 23);
+        const long minutes = rng.uniform(0, 59);
+        values[col::DAYS] = rng.uniform(1, 10);
+        values[col::PILOT] = rng.uniform(0, PILOTS - 1);
+        values[col::PILOT2] = rng.uniform(0, PILOTS - 1);
+        values[col::PILOT_EXP] = rng.uniform(0, 30);
+        values[col::PILOT_VISITS_PREV] = rng.uniform(0, 50);
+        const double hours_prev = 200.0 * rng.uniform();
+        const double duty_hours_prev = 100.0 * rng.uniform();
+        values[col::PILOT_DIST_PREV] = rng.uniform(0, 5000);
+        const double route_risk_1 = rng.uniform();
+        const double route_risk_2 = rng.uniform();
+        values[col::WEATHER] = rng.uniform(0, 5);
+        values[col::VISIBILITY] = rng.uniform(0, 10);
+        for (std::size_t c{col::TRAF0}; c <= col::TRAF4; ++c)
+        {
+            values[c] = rng.uniform(0, 20);
+        }
+
+        const long month = values[col::START_MONTH];
+        const double z = planted.intercept
+            + planted.pilot_risk[values[col::PILOT]]
+            + planted.source_risk[values[col::SOURCE]]
+            + 0.0005 * values[col::DIST]
+            + 0.3 * values[col::WEATHER]
+            - 0.1 * values[col::VISIBILITY]
+            + 1.5 * route_risk_1
+            + (month == 12 || month <= 2 ? 0.4 : 0.0)
+            - 0.02 * values[col::PILOT_EXP];
+
+        long events{0};
+        if (rng.bernoulli(1.0 / (1.0 + std::exp(-z))))
+        {
+            events = 1 + rng.bernoulli(0.3) + rng.bernoulli(0.1);
+        }
+        values[col::EVT_CNT] = events;
+
+        // recorded counts, somewhat more of them on trips with events
+        for (std::size_t c{col::ACCEL_CNT}; c <= col::STABILITY_CNT; ++c)
+        {
+            values[c] = rng.uniform(0, 5) + (events ? rng.uniform(0, 2) : 0);
+        }
+
+        for (std::size_t c{0}; c <= col::EVT_CNT; ++c)
+        {
+            if (c)
+            {
+                out += ',';
+            }
+
+            switch (c)
+            {
+            case col::START_TIME:
+                append(out, hours);
+                out += minutes < 10 ? ":0" : ":";
+                append(out, minutes);
+                break;
+            case col::PILOT_HOURS_PREV:
+                append(out, hours_prev, 2);
+                break;
+            case col::PILOT_DUTY_HOURS_PREV:
+                append(out, duty_hours_prev, 2);
+                break;
+            case col::ROUTE_RISK_1:
+                append(out, route_risk_1, 3);
+                break;
+            case col::ROUTE_RISK_2:
+                append(out, route_risk_2, 3);
+                break;
+            default:
+                append(out, values[c]);
+                break;
+            }
+        }
+        out += '\n';
+    }
+
+    return out;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    // gen_trips [--rows=N] [--seed=S] [--threads=T] [--chunk=ROWS]
+    //      [--sources=40] [--pilots=800] [--intercept=-4] [--out=CSV]
+    // CSV goes to stdout unless written to a file
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg(argv[i]);
+        const std::size_t eq = arg.find('=');
+
+        if (arg.compare(0, 2, "--") == 0 && eq != std::string::npos)
+        {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    // std::stod so that --rows=1e9 works
+    const std::uint64_t NROWS = std::stod(option("rows", "1e6"));
+    const std::uint64_t SEED = std::stoull(option("seed", "1"));
+    const std::size_t NTHREADS = std::max<std::size_t>(1,
+        std::stoul(option("threads", std::to_string(std::max(1u, std::thread::hardware_concurrency())))));
+    const std::size_t CHUNK = std::max<std::size_t>(1, std::stoul(option("chunk", "65536")));
+
+    const Planted planted(SEED, std::stoul(option("sources", "40")), std::stoul(option("pilots", "800")),
+        std::stod(option("intercept", "-4")));
+
+    std::FILE * fout = options.count("out") ? std::fopen(options.at("out").c_str(), "wb") : stdout;
+    if (!fout)
+    {
+        std::cerr << "cannot open " << options.at("out") << std::endl;
+        return 1;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    const std::uint64_t NCHUNKS = (NROWS + CHUNK - 1) / CHUNK;
+
+    // thread t formats chunks t, t + T, ...; the writer takes them round
+    // robin, i.e. in order, each queue bounding how far its thread runs ahead
+    std::vector<std::unique_ptr<num::BoundedQueue<std::string>>> queues;
+    for (std::size_t t{0}; t < NTHREADS; ++t)
+    {
+        queues.emplace_back(new num::BoundedQueue<std::string>(2));
+    }
+
+    std::vector<std::thread> workers;
+    for (std::size_t t{0}; t < NTHREADS; ++t)
+    {
+        workers.emplace_back(
+            [&, t]()
+            {
+                for (std::uint64_t chunk{t}; chunk < NCHUNKS; chunk += NTHREADS)
+                {
+                    const std::uint64_t first = chunk * CHUNK;
+                    const std::size_t nrows = std::min<std::uint64_t>(CHUNK, NROWS - first);
+
+                    if (!queues[t]->push(generate_chunk(planted, SEED, chunk, first, nrows)))
+                    {
+                        break;
+                    }
+                }
+                queues[t]->close();
+            }
+        );
+    }
+
+    std::uint64_t bytes{0};
+    bool ok{true};
+
+    for (std::uint64_t chunk{0}; chunk < NCHUNKS && ok; ++chunk)
+    {
+        std::string text;
+        ok = queues[chunk % NTHREADS]->pop(text) && std::fwrite(text.data(), 1, text.size(), fout) == text.size();
+        bytes += text.size();
+    }
+
+    for (auto & queue : queues)
+    {
+        queue->close();
+    }
+    for (auto & worker : workers)
+    {
+        worker.join();
+    }
+
+    ok = (std::fflush(fout) == 0) && ok;
+    if (fout != stdout)
+    {
+        ok = (std::fclose(fout) == 0) && ok;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cerr << "rows: " << NROWS << ", bytes: " << bytes << ", threads: " << NTHREADS
+        << ", time [s]: " << seconds << ", MB/s: " << bytes / 1e6 / std::max(seconds, 1e-9) << std::endl;
+
+    if (!ok)
+    {
+        std::cerr << "write failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: incremental.hpp
+ *
+ * Description:
+ *      Model updates from batches of new rows only
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef INCREMENTAL_HPP_
+#define INCREMENTAL_HPP_
+
+#include "model.hpp"
+#include "logreg.hpp"
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Mutable copy of a saved model, updated from batches of new rows without
+ * revisiting the rows it was fitted with. Per batch:
+ *
+ *  - event counts of density tables get the batch added, densities follow,
+ *  - column means and deviations are merged with those of the batch
+ *    (Welford / Chan), deviations of older rows being kept in M2 form,
+ *  - theta is re-expressed for the new standardization, so that margins
+ *    do not move before the fit,
+ *  - theta is refitted on the batch with fmincg, warm started from the
+ *    previous theta and penalized for moving away from it: the rows fitted
+ *    before count through a quadratic penalty with the Hessian of their
+ *    log-loss, estimated on the batch at the previous theta and scaled to
+ *    their number, on top of the ridge penalty 1 / C. A batch moves the
+ *    model about as much as it would move a refit over all rows.
+ *
+ * Standardization of older rows is that of the tables at the time they
+ * arrived, their density mapped values are not recomputed. Every step is
+ * linear in the batch size.
+ */
+class IncrementalModel
+{
+public:
+    typedef double value_type;
+    typedef std::valarray<value_type> vector_type;
+
+    explicit IncrementalModel(const ModelView & model);
+
+    size_type nrows(void) const
+    {
+        return m_nrows;
+    }
+
+    const vector_type & theta(void) const
+    {
+        return m_theta;
+    }
+
+    /*
+     * X has the intercept in column 0 and raw features in the remaining
+     * ones, like for ModelView::encode, y are event counts.
+     */
+    void update(
+        const array2d<value_type> & X,
+        const vector_type & y,
+        value_type C,
+        size_type max_iter,
+        size_type * o_rows_visited = nullptr);
+
+    std::vector<std::uint64_t> serialize(void) const;
+
+private:
+    size_type m_nrows;
+    vector_type m_theta;
+    vector_type m_mu;
+    /// sum of squared deviations from m_mu
+    vector_type m_m2;
+    density_counts_type m_counts;
+};
+
+inline
+IncrementalModel::IncrementalModel(const ModelView & model)
+:
+    m_nrows{model.nrows()},
+    m_theta(model.theta(), model.ncols()),
+    m_mu(model.mu(), model.ncols()),
+    m_m2(model.dev(), model.ncols()),
+    m_counts{}
+{
+    if (model.version() < 2 || m_nrows < 2)
+    {
+        throw std::runtime_error("model lacks the statistics needed for updates, version "
+            + std::to_string(model.version()));
+    }
+
+    m_m2 = m_m2 * m_m2 * (value_type)(m_nrows - 1);
+
+    for (const auto & table : model.tables())
+    {
+        event_counts_type counts;
+        for (size_type k{0}; k < table.size; ++k)
+        {
+            counts.emplace_hint(counts.cend(), table.keys[k], std::make_pair(table.occurrences[k], table.events[k]));
+        }
+        m_counts.emplace_back(table.column, std::move(counts));
+    }
+}
+
+inline
+void
+IncrementalModel::update(
+    const array2d<value_type> & X,
+    const vector_type & y,
+    value_type C,
+    size_type max_iter,
+    size_type * o_rows_visited)
+{
+    const size_type NROWS = X.shape().first;
+    const size_type NCOLS = X.shape().second;
+
+    assert(NCOLS == m_theta.size());
+    assert(y.size() == NROWS);
+
+    if (NROWS == 0)
+    {
+        return;
+    }
+
+    array2d<value_type> X_batch(X);
+
+    // event counts, then batch columns mapped through updated densities
+    for (auto & table : m_counts)
+    {
+        const size_type c = table.first;
+
+        for (size_type r{0}; r < NROWS; ++r)
+        {
+            auto & count = table.second[X.data()[r * NCOLS + c]];
+            count.first += 1.0;
+            count.second += y[r];
+        }
+
+        vector_type col = X_batch[X_batch.column(c)];
+        for (auto & x : col)
+        {
+            const auto & count = table.second.at(x);
+            x = count.second / count.first;
+        }
+        X_batch[X_batch.column(c)] = col;
+    }
+
+    // merged statistics, theta for the new standardization
+    const value_type n = m_nrows;
+    const value_type m = NROWS;
+
+    for (size_type c{1}; c < NCOLS; ++c)
+    {
+        const vector_type col = X_batch[X_batch.column(c)];
+
+        const value_type batch_mu = col.sum() / m;
+        const value_type batch_m2 = ((col - batch_mu) * (col - batch_mu)).sum();
+        const value_type delta = batch_mu - m_mu[c];
+
+        const value_type dev = std::sqrt(m_m2[c] / (n - 1.0));
+        const value_type mu = m_mu[c] + delta * m / (n + m);
+
+        m_m2[c] += batch_m2 + delta * delta * n * m / (n + m);
+
+        const value_type new_dev = std::sqrt(m_m2[c] / (n + m - 1.0));
+
+        m_theta[0] += m_theta[c] * (mu - m_mu[c]) / dev;
+        m_theta[c] *= new_dev / dev;
+        m_mu[c] = mu;
+    }
+    m_nrows += NROWS;
+
+    for (size_type c{1}; c < NCOLS; ++c)
+    {
+        const vector_type & col = X_batch[X_batch.column(c)];
+        X_batch[X_batch.column(c)] = (col - m_mu[c]) / std::sqrt(m_m2[c] / (m_nrows - 1.0));
+    }
+
+    const vector_type y_batch = y.apply(
+        [](value_type v)
+        {
+            return v > 1.0 ? 1.0 : v;
+        }
+    );
+
+    // fitted is the step from the previous theta, penalized instead of theta
+    const vector_type theta_prev = m_theta;
+    vector_type tcol(NROWS);
+    size_type nevals{0};
+
+    // log-loss Hessian of the n earlier rows, taken to be distributed
+    // like the batch: n / m * sum of h * (1 - h) * x * x'
+    array2d<value_type> prior({NCOLS, NCOLS}, 0.0);
+    for (size_type r{0}; r < NROWS; ++r)
+    {
+        const vector_type x = X_batch[X_batch.row(r)];
+        const value_type h = 1.0 / (1.0 + std::exp(-(x * theta_prev).sum()));
+        const value_type w = h * (1.0 - h) * n / m;
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            prior[prior.row(c)] += vector_type(x * (w * x[c]));
+        }
+    }
+
+    const vector_type step = detail::fit_partial_sums(
+        [&](value_type & sigma, vector_type & grad, const vector_type & step)
+        {
+            logreg_partial_sums(sigma, grad, tcol, vector_type(theta_prev + step), X_batch, y_batch, 0, NROWS);
+
+            for (size_type c{0}; c < NCOLS; ++c)
+            {
+                const value_type * row = prior.data() + c * NCOLS;
+                const value_type Hstep = std::inner_product(row, row + NCOLS, std::begin(step), (value_type)0.0);
+
+                sigma += 0.5 * step[c] * Hstep;
+                grad[c] += Hstep;
+            }
+        },
+        m, vector_type(0.0, NCOLS), C, max_iter, &nevals);
+
+    m_theta += step;
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * NROWS;
+    }
+}
+
+inline
+std::vector<std::uint64_t>
+IncrementalModel::serialize(void) const
+{
+    const vector_type dev = std::sqrt(m_m2 / (value_type)(m_nrows - 1));
+
+    vector_type dev_out(dev);
+    dev_out[0] = 1.0;
+
+    return serialize_model(m_theta, m_mu, dev_out, m_counts, m_nrows);
+}
+
+}  // namespace num
+
+#endif /* INCREMENTAL_HPP_ */
@@ -0,0 +1,720 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: ingest.hpp
+ *
+ * Description:
+ *      Pipelined CSV ingest: reading, parsing and encoding run concurrently
+ *      over bounded queues
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef INGEST_HPP_
+#define INGEST_HPP_
+
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <valarray>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * FIFO of at most capacity items. push blocks while full, which is what
+ * holds back a stage running ahead of its consumer; pop blocks while
+ * empty. Once closed, push drops items and pop drains what is left, then
+ * returns false.
+ */
+template<typename _ItemType>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_type capacity)
+    :
+        m_capacity{std::max<size_type>(capacity, 1)},
+        m_items{},
+        m_mutex{},
+        m_not_full{},
+        m_not_empty{},
+        m_closed{false}
+    {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue & operator=(const BoundedQueue &) = delete;
+
+    /// false if the queue has been closed
+    bool push(_ItemType && item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+
+        if (m_closed)
+        {
+            return false;
+        }
+
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_not_empty.notify_one();
+
+        return true;
+    }
+
+    /// false once the queue is closed and empty
+    bool pop(_ItemType & item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+
+        if (m_items.empty())
+        {
+            return false;
+        }
+
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_not_full.notify_one();
+
+        return true;
+    }
+
+    void close(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+private:
+    const size_type m_capacity;
+    std::deque<_ItemType> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_not_full;
+    std::condition_variable m_not_empty;
+    bool m_closed;
+};
+
+template<typename _ValueType>
+struct IngestCfg
+{
+    typedef std::map<size_type, _ValueType(*)(const char *)> converters_type;
+
+    IngestCfg()
+    :
+        m_delimiter{','},
+        m_converters{},
+        m_block_size{1 << 20},
+        m_parsers{std::max(1u, std::thread::hardware_concurrency())},
+        m_queue_depth{4}
+    {}
+
+    char delimiter(void) const
+    {
+        return m_delimiter;
+    }
+
+    IngestCfg & delimiter(char _delimiter)
+    {
+        m_delimiter = _delimiter;
+        return *this;
+    }
+
+    const converters_type & converters(void) const
+    {
+        return m_converters;
+    }
+
+    /// like loadtxtCfg::converters, called with the start of a field
+    IngestCfg & converters(const converters_type & _converters)
+    {
+        m_converters = _converters;
+        return *this;
+    }
+
+    size_type block_size(void) const
+    {
+        return m_block_size;
+    }
+
+    /// bytes read at once, blocks are extended to the end of their last line
+    IngestCfg & block_size(size_type _block_size)
+    {
+        m_block_size = _block_size;
+        return *this;
+    }
+
+    size_type parsers(void) const
+    {
+        return m_parsers;
+    }
+
+    /// number of parser threads
+    IngestCfg & parsers(size_type _parsers)
+    {
+        m_parsers = _parsers;
+        return *this;
+    }
+
+    size_type queue_depth(void) const
+    {
+        return m_queue_depth;
+    }
+
+    /// capacity of queues between stages, in blocks
+    IngestCfg & queue_depth(size_type _queue_depth)
+    {
+        m_queue_depth = _queue_depth;
+        return *this;
+    }
+
+    char m_delimiter;
+    converters_type m_converters;
+    size_type m_block_size;
+    size_type m_parsers;
+    size_type m_queue_depth;
+};
+
+/// busy time of every stage and the wall time, in seconds
+struct IngestStats
+{
+    double read;
+    double parse;
+    double encode;
+    double wall;
+    size_type blocks;
+};
+
+namespace detail
+{
+
+struct TextBlock
+{
+    size_type seq;
+    std::string text;
+};
+
+template<typename _ValueType>
+struct RowChunk
+{
+    size_type seq;
+    size_type ncols;
+    std::vector<_ValueType> values;
+};
+
+/*
+ * Admits sequence numbers less than width ahead of the oldest one not
+ * consumed yet. Parsers wait here before queueing a chunk, so the encoder
+ * never holds more than width chunks waiting for a predecessor. Once
+ * closed, wait returns false at once.
+ */
+class SequenceWindow
+{
+public:
+    explicit SequenceWindow(size_type width)
+    :
+        m_width{std::max<size_type>(width, 1)},
+        m_first{0},
+        m_mutex{},
+        m_advanced{},
+        m_closed{false}
+    {}
+
+    SequenceWindow(const SequenceWindow &) = delete;
+    SequenceWindow & operator=(const SequenceWindow &) = delete;
+
+    /// false if the window has been closed
+    bool wait(size_type seq)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_advanced.wait(lock, [this, seq]() { return m_closed || seq < m_first + m_width; });
+
+        return !m_closed;
+    }
+
+    /// the oldest sequence number has been consumed
+    void advance(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_first;
+        }
+        m_advanced.notify_all();
+    }
+
+    void close(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_advanced.notify_all();
+    }
+
+private:
+    const size_type m_width;
+    size_type m_first;
+    std::mutex m_mutex;
+    std::condition_variable m_advanced;
+    bool m_closed;
+};
+
+/*
+ * Parses all lines of a block, row-major. Every line has to have as many
+ * fields as the first one and fields without a converter have to be
+ * numbers in full, std::runtime_error otherwise. Empty lines are skipped.
+ */
+template<typename _ValueType>
+RowChunk<_ValueType>
+parse_block(const TextBlock & block, const IngestCfg<_ValueType> & cfg)
+{
+    RowChunk<_ValueType> chunk{block.seq, 0, {}};
+
+    const char * p = block.text.data();
+    const char * const end = p + block.text.size();
+
+    std::vector<_ValueType(*)(const char *)> converters;
+
+    while (p < end)
+    {
+        const char * eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        eol = eol ? eol : end;
+
+        const char * line_end = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+
+        if (line_end > p)
+        {
+            if (chunk.ncols == 0)
+            {
+                chunk.ncols = 1 + std::count(p, line_end, cfg.delimiter());
+                converters.assign(chunk.ncols, nullptr);
+                for (const auto & converter : cfg.converters())
+                {
+                    if (converter.first < chunk.ncols)
+                    {
+                        converters[converter.first] = converter.second;
+                    }
+                }
+            }
+
+            const size_type nfields = 1 + std::count(p, line_end, cfg.delimiter());
+            if (nfields != chunk.ncols)
+            {
+                throw std::runtime_error(std::to_string(nfields) + " fields instead of "
+                    + std::to_string(chunk.ncols) + " in line: " + std::string(p, line_end));
+            }
+
+            const size_type at = chunk.values.size();
+            chunk.values.resize(at + chunk.ncols, 0.0);
+
+            const char * field = p;
+            for (size_type c{0}; c < chunk.ncols; ++c)
+            {
+                const char * field_end = static_cast<const char *>(std::memchr(field, cfg.delimiter(), line_end - field));
+                field_end = field_end ? field_end : line_end;
+
+                if (converters[c])
+                {
+                    // every field is followed by a delimiter, a newline or the end
+                    chunk.values[at + c] = converters[c](field);
+                }
+                else
+                {
+                    char * number_end;
+                    chunk.values[at + c] = std::strtod(field, &number_end);
+
+                    if (number_end == field || number_end != field_end)
+                    {
+                        throw std::runtime_error("not a number: '" + std::string(field, field_end)
+                            + "' in line: " + std::string(p, line_end));
+                    }
+                }
+
+                field = field_end + 1;
+            }
+        }
+
+        p = eol + 1;
+    }
+
+    return chunk;
+}
+
+/*
+ * Number of rows parse_block would find in what is left of is, i.e. of
+ * lines that are not empty once a trailing '\r' is dropped.
+ */
+inline
+size_type
+count_rows(std::istream & is, size_type block_size)
+{
+    std::string buffer(std::max<size_type>(block_size, 1), '\0');
+
+    size_type nrows{0};
+    size_type line_size{0};
+    bool cr{false};
+
+    while (is.read(&buffer[0], buffer.size()) || is.gcount())
+    {
+        const char * p = buffer.data();
+        const char * const end = p + is.gcount();
+
+        while (p < end)
+        {
+            const char * eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            const char * const stop = eol ? eol : end;
+
+            if (stop > p)
+            {
+                line_size += stop - p;
+                cr = stop[-1] == '\r';
+            }
+            if (!eol)
+            {
+                break;
+            }
+
+            nrows += line_size > (cr ? 1u : 0u);
+            line_size = 0;
+            cr = false;
+            p = eol + 1;
+        }
+    }
+
+    return nrows + (line_size > (cr ? 1u : 0u));
+}
+
+}  // namespace detail
+
+/*
+ * Reads delimited text from is through a three-stage pipeline:
+ *
+ *      reader      -> blocks of block_size bytes cut at line ends
+ *      parsers     -> row-major chunks of values, cfg.parsers() threads
+ *      encoder     -> encode(rows, nrows, ncols), on the calling thread
+ *
+ * Stages are connected with BoundedQueues of queue_depth blocks, so they
+ * overlap. A parser also holds its chunk back until it is less than
+ * queue_depth chunks ahead of the next one to encode, hence at most about
+ * 2 * queue_depth + parsers blocks are in memory at any time, whatever
+ * the size of the input and the order parsers finish in. encode is called
+ * with chunks in input order and may keep no pointers into them.
+ *
+ * All rows have to have the same number of columns, std::runtime_error
+ * otherwise. An exception thrown by any stage stops the pipeline and is
+ * rethrown here.
+ */
+template<typename _ValueType, typename _EncodeFn>
+void
+ingest(
+    std::istream & is,
+    const IngestCfg<_ValueType> & cfg,
+    _EncodeFn encode,
+    IngestStats * o_stats = nullptr)
+{
+    typedef _ValueType value_type;
+    typedef std::chrono::steady_clock clock_type;
+
+    auto seconds = [](clock_type::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    const auto t0 = clock_type::now();
+
+    BoundedQueue<detail::TextBlock> blocks(cfg.queue_depth());
+    BoundedQueue<detail::RowChunk<value_type>> chunks(cfg.queue_depth());
+    detail::SequenceWindow window(cfg.queue_depth());
+
+    // the first exception of the reader or of a parser, it stops all stages
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+
+    auto fail = [&](std::exception_ptr what)
+    {
+        {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            failure = failure ? failure : what;
+        }
+        blocks.close();
+        window.close();
+        chunks.close();
+    };
+
+    double read_time{0.0};
+    std::vector<double> parse_times(std::max<size_type>(cfg.parsers(), 1), 0.0);
+
+    std::thread reader(
+        [&]()
+        {
+            try
+            {
+                std::string carry;
+                size_type seq{0};
+
+                while (is)
+                {
+                    const auto start = clock_type::now();
+
+                    std::string text(std::move(carry));
+                    const size_type have = text.size();
+                    text.resize(have + cfg.block_size());
+                    is.read(&text[have], cfg.block_size());
+                    text.resize(have + is.gcount());
+
+                    // the incomplete last line goes to the next block
+                    const std::string::size_type eol = text.rfind('\n');
+                    carry.clear();
+                    if (is && eol != std::string::npos)
+                    {
+                        carry.assign(text, eol + 1, std::string::npos);
+                        text.resize(eol + 1);
+                    }
+
+                    read_time += seconds(clock_type::now() - start);
+
+                    if (text.empty())
+                    {
+                        continue;
+                    }
+                    if (!blocks.push(detail::TextBlock{seq++, std::move(text)}))
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                fail(std::current_exception());
+            }
+            blocks.close();
+        }
+    );
+
+    std::vector<std::thread> parsers;
+    std::mutex parsers_mutex;
+    size_type parsers_running{parse_times.size()};
+
+    for (size_type t{0}; t < parse_times.size(); ++t)
+    {
+        parsers.emplace_back(
+            [&, t]()
+            {
+                try
+                {
+                    detail::TextBlock block;
+                    while (blocks.pop(block))
+                    {
+                        const auto start = clock_type::now();
+                        detail::RowChunk<value_type> chunk = detail::parse_block(block, cfg);
+                        parse_times[t] += seconds(clock_type::now() - start);
+
+                        if (!window.wait(chunk.seq) || !chunks.push(std::move(chunk)))
+                        {
+                            break;
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    fail(std::current_exception());
+                }
+
+                std::lock_guard<std::mutex> lock(parsers_mutex);
+                if (--parsers_running == 0)
+                {
+                    chunks.close();
+                }
+            }
+        );
+    }
+
+    auto shutdown = [&]()
+    {
+        blocks.close();
+        window.close();
+        chunks.close();
+        reader.join();
+        for (auto & parser : parsers)
+        {
+            parser.join();
+        }
+    };
+
+    // encoder, chunks arriving out of order wait for their predecessors,
+    // no more than queue_depth of them thanks to the window
+    double encode_time{0.0};
+    size_type next_seq{0};
+    size_type ncols{0};
+    std::map<size_type, detail::RowChunk<value_type>> pending;
+
+    try
+    {
+        detail::RowChunk<value_type> chunk;
+        while (chunks.pop(chunk))
+        {
+            pending.emplace(chunk.seq, std::move(chunk));
+
+            for (auto it = pending.begin(); it != pending.end() && it->first == next_seq; it = pending.erase(it), ++next_seq)
+            {
+                const auto start = clock_type::now();
+
+                const detail::RowChunk<value_type> & ready = it->second;
+
+                if (!ready.values.empty())
+                {
+                    ncols = ncols ? ncols : ready.ncols;
+                    if (ready.ncols != ncols)
+                    {
+                        throw std::runtime_error("inconsistent number of columns: "
+                            + std::to_string(ready.ncols) + " instead of " + std::to_string(ncols));
+                    }
+                    encode(ready.values.data(), ready.values.size() / ncols, ncols);
+                }
+
+                window.advance();
+
+                encode_time += seconds(clock_type::now() - start);
+            }
+        }
+    }
+    catch (...)
+    {
+        shutdown();
+        throw;
+    }
+
+    shutdown();
+
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+
+    assert(pending.empty());
+
+    if (o_stats)
+    {
+        o_stats->read = read_time;
+        o_stats->parse = 0.0;
+        for (const double t : parse_times)
+        {
+            o_stats->parse += t;
+        }
+        o_stats->encode = encode_time;
+        o_stats->wall = seconds(clock_type::now() - t0);
+        o_stats->blocks = next_seq;
+    }
+}
+
+/*
+ * Same as loadtxt over all lines of is, through the ingest pipeline.
+ *
+ * When is can be rewound, its rows are counted first and the result is
+ * allocated once, chunks are copied straight into it. Otherwise chunks
+ * are kept until the end of the input and then copied into the result,
+ * each released once copied, which needs twice the memory of the result
+ * for a moment.
+ */
+template<typename _ValueType>
+array2d<_ValueType>
+ingest_matrix(std::istream & is, const IngestCfg<_ValueType> & cfg, IngestStats * o_stats = nullptr)
+{
+    typedef _ValueType value_type;
+
+    const std::istream::pos_type start = is.tellg();
+
+    if (start != std::istream::pos_type(-1))
+    {
+        const size_type NROWS = detail::count_rows(is, cfg.block_size());
+
+        is.clear();
+        if (!is.seekg(start))
+        {
+            throw std::runtime_error("cannot rewind the input");
+        }
+
+        array2d<value_type> result({0, 0}, 0.0);
+        size_type at{0};
+
+        ingest(is, cfg,
+            [&result, &at, NROWS](const value_type * rows, size_type nrows, size_type ncols)
+            {
+                if (at == 0)
+                {
+                    result = array2d<value_type>({NROWS, ncols}, 0.0);
+                }
+                if (at + nrows > NROWS)
+                {
+                    throw std::runtime_error("input changed while being read");
+                }
+                std::copy(rows, rows + nrows * ncols, result.data() + at * ncols);
+                at += nrows;
+            },
+            o_stats);
+
+        if (at != NROWS)
+        {
+            throw std::runtime_error("input changed while being read");
+        }
+
+        return result;
+    }
+
+    std::vector<std::vector<value_type>> parts;
+    size_type nrows{0};
+    size_type ncols{0};
+
+    ingest(is, cfg,
+        [&parts, &nrows, &ncols](const value_type * rows, size_type _nrows, size_type _ncols)
+        {
+            parts.emplace_back(rows, rows + _nrows * _ncols);
+            nrows += _nrows;
+            ncols = _ncols;
+        },
+        o_stats);
+
+    array2d<value_type> result({nrows, ncols}, 0.0);
+    value_type * out = result.data();
+
+    for (auto & part : parts)
+    {
+        out = std::copy(part.begin(), part.end(), out);
+        std::vector<value_type>().swap(part);
+    }
+
+    return result;
+}
+
+}  // namespace num
+
+#endif /* INGEST_HPP_ */
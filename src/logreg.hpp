@@ -25,95 +25,1379 @@
 #define LOGREG_HPP_
 
 #include "array2d.hpp"
+#include "array2d_fixed.hpp"
 #include "sigmoid.hpp"
 #include "fmincg.hpp"
+#include "minibatch.hpp"
+#include "weights.hpp"
+#include "compact.hpp"
+#include "coordinate_descent.hpp"
+#include "csr.hpp"
 #include <utility>
+#include <vector>
 #include <valarray>
 #include <cassert>
 #include <functional>
+#include <numeric>
+#include <algorithm>
+#include <cstdint>
 #include <cmath>
+#include <type_traits>
+
+/*
+ * Widths of X (intercept included) that LogisticRegression fits and
+ * scores with array2d_fixed row kernels, a comma separated list, e.g.
+ * -DNUM_LOGREG_FIXED_WIDTHS=29,35. 29 is the intercept and 28 features
+ * of TripSafetyFactors.
+ */
+#ifndef NUM_LOGREG_FIXED_WIDTHS
+#define NUM_LOGREG_FIXED_WIDTHS 29
+#endif
 
 namespace num
 {
 
+/*
+ * Unregularized, unnormalized partial sums of the logistic cost over
+ * rows [rbegin, rend) of X:
+ *      out_sigma = sum_i -y_i * log(h_i) - (1 - y_i) * log(1 - h_i)
+ *      out_grad = (H - y)' * X
+ * Shards computed over disjoint row ranges can be simply added together
+ * and then finalized with logreg_cost_grad_finalize.
+ */
+template<typename _ValueType>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const size_type rbegin,
+    const size_type rend
+)
+{
+    typedef _ValueType value_type;
+
+    const shape_type X_shape = X.shape();
+
+    assert(y.size() == X_shape.first);
+    assert(out_grad.size() == X_shape.second);
+    assert(theta.size() == X_shape.second);
+    assert(rbegin <= rend && rend <= X_shape.first);
+
+    assert(tcol.size() >= rend - rbegin);
+
+    const size_type nrows = rend - rbegin;
+
+    // H is indexed relative to rbegin
+    std::valarray<value_type> & H = tcol;
+
+    //    H = sigmoid(theta' * X')';
+    for (size_type r{rbegin}; r < rend; ++r)
+    {
+        H[r - rbegin] = (X[X.row(r)] * theta).sum();
+    }
+    std::valarray<value_type> Hs = sigmoid<std::valarray<value_type>>(H[std::slice(0, nrows, 1)]);
+    const std::valarray<value_type> ys = y[std::slice(rbegin, nrows, 1)];
+
+    //    sigma_i = -y' * log(H) - (1 - y') * log(1 - H);
+    out_sigma = -(ys * std::log(Hs)).sum() - (((value_type)1.0 - ys) * std::log((value_type)1.0 - Hs)).sum();
+
+    //    grad = (H - y)' * X;
+    Hs -= ys;
+    for (size_type c{0}; c < X_shape.second; ++c)
+    {
+        out_grad[c] = (X[X.column(c, rbegin, rend)] * Hs).sum();
+    }
+}
+
+/*
+ * Same partial sums over a matrix of compile-time width, in one pass:
+ * every row is read once for both its margin and its gradient term,
+ * with row kernels unrolled over the padded width. tcol is not used.
+ */
+template<typename _ValueType, size_type _NCols>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> &,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d_fixed<_ValueType, _NCols> & X,
+    const std::valarray<_ValueType> & y,
+    const size_type rbegin,
+    const size_type rend
+)
+{
+    typedef _ValueType value_type;
+    typedef array2d_fixed<value_type, _NCols> array_type;
+
+    constexpr size_type STRIDE = array_type::STRIDE;
+
+    assert(y.size() == X.shape().first);
+    assert(out_grad.size() == _NCols);
+    assert(rbegin <= rend && rend <= X.shape().first);
+
+    const typename array_type::row_type th = array_type::pad(theta);
+
+    typename array_type::row_type grad;
+    grad.fill(0.0);
+
+    value_type sigma{0.0};
+
+    for (size_type r{rbegin}; r < rend; ++r)
+    {
+        const value_type * x = X.row(r);
+        const value_type h = sigmoid(detail::fixed_dot<STRIDE>(x, th.data()));
+        const value_type yr = y[r];
+
+        sigma -= yr * std::log(h) + ((value_type)1.0 - yr) * std::log((value_type)1.0 - h);
+
+        detail::fixed_axpy<STRIDE>(h - yr, x, grad.data());
+    }
+
+    out_sigma = sigma;
+    std::copy(grad.cbegin(), grad.cbegin() + _NCols, std::begin(out_grad));
+}
+
+namespace detail
+{
+
+/*
+ * Partial sums over a row index view, with row i of the view weighted
+ * by weight(i):
+ *      out_sigma = sum_i w_i * logloss_i
+ *      out_grad = sum_i w_i * (h_i - y_i) * x_i
+ */
+template<typename _ValueType, typename _WeightFn>
+void
+logreg_rows_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::vector<size_type> & rows,
+    _WeightFn weight
+)
+{
+    typedef _ValueType value_type;
+
+    const size_type NCOLS = X.shape().second;
+
+    assert(y.size() == X.shape().first);
+    assert(out_grad.size() == NCOLS);
+    assert(theta.size() == NCOLS);
+    assert(tcol.size() >= rows.size());
+
+    const value_type * data = X.data();
+    const value_type * th = &theta[0];
+
+    out_sigma = 0.0;
+    out_grad = 0.0;
+
+    for (size_type i{0}; i < rows.size(); ++i)
+    {
+        assert(rows[i] < X.shape().first);
+
+        const value_type * x = data + rows[i] * NCOLS;
+        value_type z{0.0};
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            z += x[c] * th[c];
+        }
+        tcol[i] = z;
+    }
+
+    std::valarray<value_type> Hs = sigmoid<std::valarray<value_type>>(tcol[std::slice(0, rows.size(), 1)]);
+
+    value_type * grad = &out_grad[0];
+
+    for (size_type i{0}; i < rows.size(); ++i)
+    {
+        const value_type w = weight(i);
+        const value_type yi = y[rows[i]];
+        const value_type * x = data + rows[i] * NCOLS;
+        const value_type d = w * (Hs[i] - yi);
+
+        out_sigma -= w * (yi * std::log(Hs[i]) + ((value_type)1.0 - yi) * std::log((value_type)1.0 - Hs[i]));
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            grad[c] += d * x[c];
+        }
+    }
+}
+
+}  // namespace detail
+
+/*
+ * Same partial sums as above, over the rows of X listed in rows (a row
+ * index view, rows may repeat), so that subsets of one feature matrix can
+ * be fitted without copying it. tcol is indexed like rows.
+ */
+template<typename _ValueType>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::vector<size_type> & rows
+)
+{
+    detail::logreg_rows_partial_sums(out_sigma, out_grad, tcol, theta, X, y, rows,
+        [](size_type) { return (_ValueType)1.0; });
+}
+
+/*
+ * Row index view with per-row (importance) weights, weights are indexed
+ * like rows. Finalize with the sum of weights in place of m.
+ */
+template<typename _ValueType>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::vector<size_type> & rows,
+    const std::valarray<_ValueType> & weights
+)
+{
+    assert(weights.size() == rows.size());
+
+    detail::logreg_rows_partial_sums(out_sigma, out_grad, tcol, theta, X, y, rows,
+        [&weights](size_type i) { return weights[i]; });
+}
+
+/*
+ * Turns partial sums accumulated over all m rows into the regularized cost
+ * and gradient, in place. For weighted sums m is the sum of weights.
+ */
+template<typename _ValueType, typename _CountType>
+void
+logreg_cost_grad_finalize(
+    /// out
+    _ValueType & out_cost,
+    std::valarray<_ValueType> & io_grad,
+    /// in
+    const _ValueType sigma,
+    const std::valarray<_ValueType> & theta,
+    const _CountType count,
+    const _ValueType C
+)
+{
+    const _ValueType m = count;
+
+    //    theta_for_reg = [0; theta(2:size(theta))];
+    //    J = sigma_i / m + sum(theta_for_reg.^2) / (2 * C * m);
+    out_cost = ((theta * theta).sum() - theta[0] * theta[0]) / (2.0 * C * m);
+    out_cost += sigma / m;
+
+    //    grad = (theta_for_reg' / C + grad) / m;
+    const _ValueType intercept_grad = io_grad[0];
+    io_grad += theta / C;
+    io_grad[0] = intercept_grad;
+    io_grad /= m;
+}
+
+template<typename _ValueType>
+void
+logreg_cost_grad(
+    /// out
+    _ValueType & out_cost,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const _ValueType C
+)
+{
+    typedef _ValueType value_type;
+
+    const size_type m = X.shape().first;
+    value_type Sigma;
+
+    logreg_partial_sums(Sigma, out_grad, tcol, theta, X, y, 0, m);
+    logreg_cost_grad_finalize(out_cost, out_grad, Sigma, theta, m, C);
+}
+
+
+template<typename _ValueType, size_type _NCols>
+void
+logreg_cost_grad(
+    /// out
+    _ValueType & out_cost,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d_fixed<_ValueType, _NCols> & X,
+    const std::valarray<_ValueType> & y,
+    const _ValueType C
+)
+{
+    const size_type m = X.shape().first;
+    _ValueType Sigma;
+
+    logreg_partial_sums(Sigma, out_grad, tcol, theta, X, y, 0, m);
+    logreg_cost_grad_finalize(out_cost, out_grad, Sigma, theta, m, C);
+}
+
+
+template<typename _ValueType>
+std::pair<_ValueType, std::valarray<_ValueType>>
+logreg_cost_grad(
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const _ValueType C)
+{
+    typedef _ValueType value_type;
+    typedef std::valarray<value_type> vector;
+
+    const shape_type X_shape = X.shape();
+
+    vector temp(X_shape.first);
+
+    value_type cost;
+    vector grad(X_shape.second);
+
+    logreg_cost_grad(cost, grad, temp, theta, X, y, C);
+
+    return std::make_pair(cost, grad);
+}
+
+namespace detail
+{
+
+/*
+ * Weighted partial sums over all rows of X, for_each_run(fn) has to call
+ * fn(rbegin, rend, w) for consecutive row ranges sharing weight w.
+ */
+template<typename _ValueType, typename _ForEachRun>
+void
+logreg_runs_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    _ForEachRun for_each_run
+)
+{
+    typedef _ValueType value_type;
+
+    const size_type NROWS = X.shape().first;
+    const size_type NCOLS = X.shape().second;
+
+    assert(y.size() == NROWS);
+    assert(out_grad.size() == NCOLS);
+    assert(theta.size() == NCOLS);
+    assert(tcol.size() >= NROWS);
+
+    for (size_type r{0}; r < NROWS; ++r)
+    {
+        tcol[r] = (X[X.row(r)] * theta).sum();
+    }
+    const std::valarray<value_type> Hs = sigmoid<std::valarray<value_type>>(tcol[std::slice(0, NROWS, 1)]);
+
+    const value_type * data = X.data();
+    value_type * grad = &out_grad[0];
+
+    out_sigma = 0.0;
+    out_grad = 0.0;
+
+    for_each_run(
+        [&](size_type rbegin, size_type rend, value_type w)
+        {
+            for (size_type r{rbegin}; r < rend; ++r)
+            {
+                const value_type * x = data + r * NCOLS;
+                const value_type d = w * (Hs[r] - y[r]);
+
+                out_sigma -= w * (y[r] * std::log(Hs[r]) + ((value_type)1.0 - y[r]) * std::log((value_type)1.0 - Hs[r]));
+
+                for (size_type c{0}; c < NCOLS; ++c)
+                {
+                    grad[c] += d * x[c];
+                }
+            }
+        }
+    );
+}
+
+// run visitors, C++11 lambdas cannot take the kernel's lambda generically
+
+template<typename _WeightType>
+struct PerRowRuns
+{
+    const std::vector<_WeightType> & weights;
+
+    template<typename _Fn>
+    void operator()(_Fn fn) const
+    {
+        for (size_type r{0}; r < weights.size(); ++r)
+        {
+            fn(r, r + 1, weights[r]);
+        }
+    }
+};
+
+template<typename _WeightType>
+struct CompressedRuns
+{
+    const RunLengthWeights<_WeightType> & weights;
+
+    template<typename _Fn>
+    void operator()(_Fn fn) const
+    {
+        weights.for_each_run(fn);
+    }
+};
+
+}  // namespace detail
+
+/*
+ * Partial sums with row r of X weighted by weights[r], e.g. a collapsed
+ * repeat count or an importance weight. Finalize with weights_sum.
+ */
+template<typename _ValueType, typename _WeightType>
+void
+logreg_weighted_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::vector<_WeightType> & weights
+)
+{
+    assert(weights.size() == X.shape().first);
+
+    detail::logreg_runs_partial_sums(out_sigma, out_grad, tcol, theta, X, y,
+        detail::PerRowRuns<_WeightType>{weights});
+}
+
+/*
+ * Same with run-length compressed weights, rows of a run share a single
+ * weight load.
+ */
+template<typename _ValueType, typename _WeightType>
+void
+logreg_weighted_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const RunLengthWeights<_WeightType> & weights
+)
+{
+    assert(weights.size() == X.shape().first);
+
+    detail::logreg_runs_partial_sums(out_sigma, out_grad, tcol, theta, X, y,
+        detail::CompressedRuns<_WeightType>{weights});
+}
+
+template<typename _WeightType>
+double
+weights_sum(const std::vector<_WeightType> & weights)
+{
+    return std::accumulate(weights.cbegin(), weights.cend(), 0.0);
+}
+
+template<typename _WeightType>
+double
+weights_sum(const RunLengthWeights<_WeightType> & weights)
+{
+    return weights.sum();
+}
+
+/*
+ * Weighted logistic cost and gradient,
+ *      J = sum_i w_i * logloss_i / sum(w) + sum(theta(2:end).^2) / (2 * C * sum(w)),
+ * for weights given as std::vector<float/double> or RunLengthWeights.
+ * Integer weights give the same J as the data set with rows repeated.
+ */
+template<typename _ValueType, typename _Weights>
+void
+logreg_weighted_cost_grad(
+    /// out
+    _ValueType & out_cost,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const _Weights & weights,
+    const _ValueType C
+)
+{
+    _ValueType Sigma;
+
+    logreg_weighted_partial_sums(Sigma, out_grad, tcol, theta, X, y, weights);
+    logreg_cost_grad_finalize(out_cost, out_grad, Sigma, theta, weights_sum(weights), C);
+}
+
+/*
+ * Partial sums over unique rows of X standing for pos[r] positive and
+ * neg[r] negative records each:
+ *      out_sigma = sum_r -pos_r * log(h_r) - neg_r * log(1 - h_r)
+ *      out_grad = sum_r ((pos_r + neg_r) * h_r - pos_r) * x_r
+ * the same sums as over the records themselves. Finalize with
+ * sum(pos + neg).
+ */
+template<typename _ValueType>
+void
+logreg_counts_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    std::valarray<_ValueType> & tcol,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & pos,
+    const std::valarray<_ValueType> & neg
+)
+{
+    typedef _ValueType value_type;
+
+    const size_type NROWS = X.shape().first;
+    const size_type NCOLS = X.shape().second;
+
+    assert(pos.size() == NROWS && neg.size() == NROWS);
+    assert(out_grad.size() == NCOLS);
+    assert(theta.size() == NCOLS);
+    assert(tcol.size() >= NROWS);
+
+    for (size_type r{0}; r < NROWS; ++r)
+    {
+        tcol[r] = (X[X.row(r)] * theta).sum();
+    }
+    const std::valarray<value_type> Hs = sigmoid<std::valarray<value_type>>(tcol[std::slice(0, NROWS, 1)]);
+
+    //    sigma = -pos' * log(H) - neg' * log(1 - H);
+    out_sigma = -(pos * std::log(Hs)).sum() - (neg * std::log((value_type)1.0 - Hs)).sum();
+
+    //    grad = ((pos + neg) .* H - pos)' * X;
+    const std::valarray<value_type> D = (pos + neg) * Hs - pos;
+    for (size_type c{0}; c < NCOLS; ++c)
+    {
+        out_grad[c] = (X[X.column(c)] * D).sum();
+    }
+}
+
+/*
+ * Partial sums over all rows of a CompactMatrix, same as the array2d
+ * variant. Rows are processed in blocks small enough for margins and
+ * residuals to stay in L1. Columns are decoded inside the loops: for
+ * dictionary columns margins add entries of a table of dict[k] * theta_c,
+ * and gradients first sum residuals per code and only then multiply them
+ * with the dictionary.
+ */
+template<typename _ValueType>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const CompactMatrix<_ValueType> & X,
+    const std::valarray<_ValueType> & y
+)
+{
+    typedef _ValueType value_type;
+    typedef typename CompactMatrix<value_type>::Encoding Encoding;
+    typedef typename CompactMatrix<value_type>::Column Column;
+
+    constexpr size_type BLOCK{1024};
+
+    const size_type NROWS = X.shape().first;
+    const size_type NCOLS = X.shape().second;
+
+    assert(y.size() == NROWS);
+    assert(out_grad.size() == NCOLS);
+    assert(theta.size() == NCOLS);
+
+    // per dictionary column: dict * theta_c, then residual sums per code
+    std::vector<std::vector<value_type>> tables(NCOLS);
+    std::vector<std::vector<value_type>> sums(NCOLS);
+
+    for (size_type c{0}; c < NCOLS; ++c)
+    {
+        const Column & column = X.column(c);
+        if (column.encoding != Encoding::Float)
+        {
+            tables[c].resize(column.dict.size());
+            for (size_type k{0}; k < column.dict.size(); ++k)
+            {
+                tables[c][k] = column.dict[k] * theta[c];
+            }
+            sums[c].assign(column.dict.size(), 0.0);
+        }
+    }
+
+    value_type z[BLOCK];
+    value_type d[BLOCK];
+
+    out_sigma = 0.0;
+    out_grad = 0.0;
+
+    for (size_type rbegin{0}; rbegin < NROWS; rbegin += BLOCK)
+    {
+        const size_type n = std::min(BLOCK, NROWS - rbegin);
+
+        std::fill(z, z + n, 0.0);
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            const Column & column = X.column(c);
+
+            switch (column.encoding)
+            {
+            case Encoding::Dict8:
+            {
+                const value_type * table = tables[c].data();
+                const std::uint8_t * codes = column.codes8.data() + rbegin;
+                for (size_type i{0}; i < n; ++i)
+                {
+                    z[i] += table[codes[i]];
+                }
+                break;
+            }
+            case Encoding::Dict16:
+            {
+                const value_type * table = tables[c].data();
+                const std::uint16_t * codes = column.codes16.data() + rbegin;
+                for (size_type i{0}; i < n; ++i)
+                {
+                    z[i] += table[codes[i]];
+                }
+                break;
+            }
+            case Encoding::Float:
+            {
+                const value_type th = theta[c];
+                const float * values = column.values.data() + rbegin;
+                for (size_type i{0}; i < n; ++i)
+                {
+                    z[i] += th * values[i];
+                }
+                break;
+            }
+            }
+        }
+
+        for (size_type i{0}; i < n; ++i)
+        {
+            const value_type h = sigmoid(z[i]);
+            const value_type yi = y[rbegin + i];
+
+            out_sigma -= yi * std::log(h) + ((value_type)1.0 - yi) * std::log((value_type)1.0 - h);
+            d[i] = h - yi;
+        }
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            const Column & column = X.column(c);
+
+            switch (column.encoding)
+            {
+            case Encoding::Dict8:
+            {
+                value_type * sum = sums[c].data();
+                const std::uint8_t * codes = column.codes8.data() + rbegin;
+                for (size_type i{0}; i < n; ++i)
+                {
+                    sum[codes[i]] += d[i];
+                }
+                break;
+            }
+            case Encoding::Dict16:
+            {
+                value_type * sum = sums[c].data();
+                const std::uint16_t * codes = column.codes16.data() + rbegin;
+                for (size_type i{0}; i < n; ++i)
+                {
+                    sum[codes[i]] += d[i];
+                }
+                break;
+            }
+            case Encoding::Float:
+            {
+                const float * values = column.values.data() + rbegin;
+                value_type g{0.0};
+                for (size_type i{0}; i < n; ++i)
+                {
+                    g += d[i] * values[i];
+                }
+                out_grad[c] += g;
+                break;
+            }
+            }
+        }
+    }
+
+    for (size_type c{0}; c < NCOLS; ++c)
+    {
+        const Column & column = X.column(c);
+        for (size_type k{0}; k < sums[c].size(); ++k)
+        {
+            out_grad[c] += sums[c][k] * column.dict[k];
+        }
+    }
+}
+
+/*
+ * Pairwise products of columns of X, (a, b) adds x_a * x_b as a feature.
+ * Products are never materialized, theta holds their coefficients after
+ * those of the columns of X.
+ */
+typedef std::vector<std::pair<size_type, size_type>> interactions_type;
+
+namespace detail
+{
+
+/// x' * theta plus interaction terms
+template<typename _ValueType>
+inline
+_ValueType
+interaction_margin(
+    const _ValueType * x,
+    const _ValueType * theta,
+    const size_type ncols,
+    const interactions_type & interactions)
+{
+    _ValueType z{0.0};
+
+    for (size_type c{0}; c < ncols; ++c)
+    {
+        z += x[c] * theta[c];
+    }
+    for (size_type k{0}; k < interactions.size(); ++k)
+    {
+        z += x[interactions[k].first] * x[interactions[k].second] * theta[ncols + k];
+    }
+
+    return z;
+}
+
+}  // namespace detail
+
+/*
+ * Partial sums over rows [rbegin, rend) of X extended with interaction
+ * terms. Every row is read once: its margin, residual and gradient
+ * contribution, products included, are computed while it is in L1.
+ * theta and out_grad have X.shape().second + interactions.size() elements.
+ */
+template<typename _ValueType>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const interactions_type & interactions,
+    const size_type rbegin,
+    const size_type rend
+)
+{
+    typedef _ValueType value_type;
+
+    const size_type NCOLS = X.shape().second;
+    const size_type NFEAT = NCOLS + interactions.size();
+
+    assert(y.size() == X.shape().first);
+    assert(out_grad.size() == NFEAT);
+    assert(theta.size() == NFEAT);
+    assert(rbegin <= rend && rend <= X.shape().first);
+
+    for (const auto & ab : interactions)
+    {
+        assert(ab.first < NCOLS && ab.second < NCOLS);
+        (void)ab;
+    }
+
+    const value_type * th = &theta[0];
+    value_type * grad = &out_grad[0];
+
+    out_sigma = 0.0;
+    out_grad = 0.0;
+
+    for (size_type r{rbegin}; r < rend; ++r)
+    {
+        const value_type * x = X.data() + r * NCOLS;
+
+        const value_type h = sigmoid(detail::interaction_margin(x, th, NCOLS, interactions));
+        const value_type d = h - y[r];
+
+        out_sigma -= y[r] * std::log(h) + ((value_type)1.0 - y[r]) * std::log((value_type)1.0 - h);
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            grad[c] += d * x[c];
+        }
+        for (size_type k{0}; k < interactions.size(); ++k)
+        {
+            grad[NCOLS + k] += d * x[interactions[k].first] * x[interactions[k].second];
+        }
+    }
+}
+
+template<typename _ValueType>
+void
+logreg_cost_grad(
+    /// out
+    _ValueType & out_cost,
+    std::valarray<_ValueType> & out_grad,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const interactions_type & interactions,
+    const _ValueType C
+)
+{
+    const size_type m = X.shape().first;
+    _ValueType Sigma;
+
+    logreg_partial_sums(Sigma, out_grad, theta, X, y, interactions, 0, m);
+    logreg_cost_grad_finalize(out_cost, out_grad, Sigma, theta, m, C);
+}
+
+namespace detail
+{
+
+/// x' * theta[0, ncols) plus sparse row r of S against theta[ncols, ...)
+template<typename _ValueType>
+inline
+_ValueType
+hybrid_margin(
+    const _ValueType * x,
+    const _ValueType * theta,
+    const size_type ncols,
+    const csr_matrix<_ValueType> & S,
+    const size_type r)
+{
+    _ValueType z{0.0};
+
+    for (size_type c{0}; c < ncols; ++c)
+    {
+        z += x[c] * theta[c];
+    }
+    for (size_type k{S.row_ptr()[r]}; k < S.row_ptr()[r + 1]; ++k)
+    {
+        z += S.values()[k] * theta[ncols + S.col_idx()[k]];
+    }
+
+    return z;
+}
+
+}  // namespace detail
+
+/*
+ * Partial sums over rows [rbegin, rend) of the hybrid matrix [X S]:
+ * dense features X followed by sparse ones S, e.g. one-hot categories.
+ * theta and out_grad have X.shape().second + S.shape().second elements.
+ * A row touches only the coefficients of its own nonzeros, so the sparse
+ * part costs O(nnz) per evaluation however wide S is.
+ */
+template<typename _ValueType>
+void
+logreg_partial_sums(
+    /// out
+    _ValueType & out_sigma,
+    std::valarray<_ValueType> & out_grad,
+    /// in
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const csr_matrix<_ValueType> & S,
+    const std::valarray<_ValueType> & y,
+    const size_type rbegin,
+    const size_type rend
+)
+{
+    typedef _ValueType value_type;
+
+    const size_type NCOLS = X.shape().second;
+
+    assert(y.size() == X.shape().first);
+    assert(S.shape().first == X.shape().first);
+    assert(out_grad.size() == NCOLS + S.shape().second);
+    assert(theta.size() == NCOLS + S.shape().second);
+    assert(rbegin <= rend && rend <= X.shape().first);
+
+    const value_type * th = &theta[0];
+    value_type * grad = &out_grad[0];
+
+    out_sigma = 0.0;
+    out_grad = 0.0;
+
+    for (size_type r{rbegin}; r < rend; ++r)
+    {
+        const value_type * x = X.data() + r * NCOLS;
+
+        const value_type h = sigmoid(detail::hybrid_margin(x, th, NCOLS, S, r));
+        const value_type d = h - y[r];
+
+        out_sigma -= y[r] * std::log(h) + ((value_type)1.0 - y[r]) * std::log((value_type)1.0 - h);
+
+        for (size_type c{0}; c < NCOLS; ++c)
+        {
+            grad[c] += d * x[c];
+        }
+        for (size_type k{S.row_ptr()[r]}; k < S.row_ptr()[r + 1]; ++k)
+        {
+            grad[NCOLS + S.col_idx()[k]] += d * S.values()[k];
+        }
+    }
+}
+
 template<typename _ValueType>
 void
 logreg_cost_grad(
     /// out
     _ValueType & out_cost,
     std::valarray<_ValueType> & out_grad,
-    std::valarray<_ValueType> & tcol,
     /// in
-    const std::valarray<_ValueType> theta,
-    const array2d<_ValueType> X,
-    const std::valarray<_ValueType> y,
+    const std::valarray<_ValueType> & theta,
+    const array2d<_ValueType> & X,
+    const csr_matrix<_ValueType> & S,
+    const std::valarray<_ValueType> & y,
     const _ValueType C
 )
+{
+    const size_type m = X.shape().first;
+    _ValueType Sigma;
+
+    logreg_partial_sums(Sigma, out_grad, theta, X, S, y, 0, m);
+    logreg_cost_grad_finalize(out_cost, out_grad, Sigma, theta, m, C);
+}
+
+/*
+ * Minimizes the same objective as logreg_cost_grad,
+ *      J = sum_i logloss_i / m + sum(theta(2:end).^2) / (2 * C * m),
+ * with Adam steps on mini-batch gradients. m is not known upfront for
+ * streaming sources, during the first epoch the number of rows seen so far
+ * stands in for it.
+ */
+template<typename _ValueType, typename _RowSource>
+std::valarray<_ValueType>
+minibatch_fit(
+    _RowSource & source,
+    std::valarray<_ValueType> theta,
+    const _ValueType C,
+    const MiniBatchCfg<_ValueType> & cfg,
+    size_type * o_rows_visited = nullptr
+)
 {
     typedef _ValueType value_type;
-    typedef std::valarray<value_type> vector;
+    typedef std::valarray<value_type> vector_type;
 
-    const shape_type X_shape = X.shape();
+    const size_type NCOLS = source.ncols();
+    assert(theta.size() == NCOLS);
+    assert(cfg.batch_size() > 0);
 
-    assert(y.size() == X_shape.first);
-    assert(out_grad.size() == X_shape.second);
-    assert(theta.size() == X_shape.second);
+    array2d<value_type> X_block({cfg.batch_size(), NCOLS}, 0.0);
+    vector_type y_block(cfg.batch_size());
+    vector_type tcol(cfg.batch_size());
+    vector_type grad(NCOLS);
 
-    assert(tcol.size() >= X_shape.first);
+    // first and second moment estimates
+    vector_type m1(0.0, NCOLS);
+    vector_type m2(0.0, NCOLS);
+    value_type beta1_t{1.0};
+    value_type beta2_t{1.0};
 
-    vector & H = tcol;
+    size_type step{0};
+    size_type rows_total{0};
+    size_type rows_per_epoch{0};
 
-    //    H = sigmoid(theta' * X')';
-    for (size_type r{0}; r < X_shape.first; ++r)
+    for (size_type epoch{0}; epoch < cfg.epochs(); ++epoch)
     {
-        H[r] = (X[X.row(r)] * theta).sum();
+        source.rewind(cfg.seed() + epoch);
+
+        size_type rows_this_epoch{0};
+
+        for (size_type nrows; (nrows = source.next(X_block, y_block)) != 0;)
+        {
+            rows_this_epoch += nrows;
+
+            value_type sigma;
+            logreg_partial_sums(sigma, grad, tcol, theta, X_block, y_block, 0, nrows);
+
+            const value_type m = std::max(rows_per_epoch, rows_this_epoch);
+
+            //  grad = (H - y)' * X / b + theta_for_reg' / (C * m)
+            const value_type intercept_grad = grad[0] / nrows;
+            grad = grad / (value_type)nrows + theta / (C * m);
+            grad[0] = intercept_grad;
+
+            ++step;
+            beta1_t *= cfg.m_beta1;
+            beta2_t *= cfg.m_beta2;
+
+            m1 = cfg.m_beta1 * m1 + (1.0 - cfg.m_beta1) * grad;
+            m2 = cfg.m_beta2 * m2 + (1.0 - cfg.m_beta2) * grad * grad;
+
+            const value_type lr = cfg.step_size(step, epoch) * std::sqrt(1.0 - beta2_t) / (1.0 - beta1_t);
+
+            theta -= lr * m1 / (std::sqrt(m2) + cfg.m_epsilon);
+        }
+
+        rows_per_epoch = std::max(rows_per_epoch, rows_this_epoch);
+        rows_total += rows_this_epoch;
     }
-    H = sigmoid(H);
 
-    //    theta_for_reg = [0; theta(2:size(theta))];
+    if (o_rows_visited)
+    {
+        *o_rows_visited = rows_total;
+    }
 
-    //    grad = theta_for_reg' / C;
-    out_grad = theta / C;
-    out_grad[0] = 0.0;
+    return theta;
+}
 
-    //    sigma_i = -y' * log(H) - (1 - y') * log(1 - H);
-    const value_type Sigma = -(y * std::log(H)).sum() - (((value_type)1.0 - y) * std::log((value_type)1.0 - H)).sum();
-    //    J = sigma_i / m + sum(theta_for_reg.^2) / (2 * C * m);
-    out_cost = ((theta * theta).sum() - theta[0] * theta[0]) / (2.0 * C * X_shape.first);
-    out_cost += Sigma / X_shape.first;
+namespace detail
+{
+
+/*
+ * fmincg over the cost assembled from partial_sums(sigma, grad, theta)
+ * and finalized with m, the number (sum of weights) of rows.
+ */
+template<typename _ValueType, typename _PartialSumsFn>
+std::valarray<_ValueType>
+fit_partial_sums(
+    _PartialSumsFn partial_sums,
+    const _ValueType m,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type * o_nevals
+)
+{
+    typedef _ValueType value_type;
+    typedef std::valarray<value_type> vector_type;
+
+    size_type nevals{0};
+
+    std::function<std::pair<value_type, vector_type> (vector_type)>
+
+    cost_fn = [&](const vector_type theta) -> std::pair<value_type, vector_type>
+    {
+        ++nevals;
+
+        value_type sigma;
+        value_type cost;
+        vector_type grad(theta.size());
+
+        partial_sums(sigma, grad, theta);
+        logreg_cost_grad_finalize(cost, grad, sigma, theta, m, C);
+
+        return std::make_pair(cost, grad);
+    };
+
+    const vector_type theta = num::fmincg(cost_fn, theta0, max_iter, false);
+
+    *o_nevals = nevals;
+
+    return theta;
+}
+
+/*
+ * Calls fn(std::integral_constant<size_type, W>()) for the first of
+ * _Widths equal to ncols, false if there is none.
+ */
+template<size_type... _Widths>
+struct FixedWidthDispatch;
+
+template<>
+struct FixedWidthDispatch<>
+{
+    template<typename _Fn>
+    static bool apply(size_type, _Fn &)
+    {
+        return false;
+    }
+};
+
+template<size_type _Width, size_type... _Rest>
+struct FixedWidthDispatch<_Width, _Rest...>
+{
+    template<typename _Fn>
+    static bool apply(size_type ncols, _Fn & fn)
+    {
+        if (ncols == _Width)
+        {
+            fn(std::integral_constant<size_type, _Width>());
+            return true;
+        }
+        return FixedWidthDispatch<_Rest...>::apply(ncols, fn);
+    }
+};
+
+/// LogisticRegression::fit over a fixed width copy of X
+template<typename _ValueType>
+struct FixedWidthFit
+{
+    typedef std::valarray<_ValueType> vector_type;
+
+    template<size_type _NCols>
+    void operator()(std::integral_constant<size_type, _NCols>)
+    {
+        const array2d_fixed<_ValueType, _NCols> X_fixed(X);
+        const size_type m = X.shape().first;
+        vector_type tcol;
+
+        theta = fit_partial_sums(
+            [&](_ValueType & sigma, vector_type & grad, const vector_type & theta)
+            {
+                logreg_partial_sums(sigma, grad, tcol, theta, X_fixed, y, 0, m);
+            },
+            (_ValueType)m, theta0, C, max_iter, &nevals);
+    }
+
+    const array2d<_ValueType> & X;
+    const vector_type & y;
+    const vector_type & theta0;
+    const _ValueType C;
+    const size_type max_iter;
+
+    vector_type theta;
+    size_type nevals;
+};
+
+/// margins of rows of X, fixed width row kernel
+template<typename _ValueType>
+struct FixedWidthMargins
+{
+    template<size_type _NCols>
+    void operator()(std::integral_constant<size_type, _NCols>)
+    {
+        for (size_type r{0}; r < X.shape().first; ++r)
+        {
+            H[r] = fixed_dot<_NCols>(X.data() + r * _NCols, &theta[0]);
+        }
+    }
+
+    const array2d<_ValueType> & X;
+    const std::valarray<_ValueType> & theta;
+    std::valarray<_ValueType> & H;
+};
+
+}  // namespace detail
+
+/*
+ * Same as LogisticRegression::fit, but over the rows of X listed in rows
+ * only, X is shared and not copied.
+ */
+template<typename _ValueType>
+std::valarray<_ValueType>
+fit_rows(
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::vector<size_type> & rows,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef std::valarray<_ValueType> vector_type;
+
+    vector_type tcol(rows.size());
+    size_type nevals{0};
+
+    const vector_type theta = detail::fit_partial_sums(
+        [&](_ValueType & sigma, vector_type & grad, const vector_type & theta)
+        {
+            logreg_partial_sums(sigma, grad, tcol, theta, X, y, rows);
+        },
+        (_ValueType)rows.size(), theta0, C, max_iter, &nevals);
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * rows.size();
+    }
+
+    return theta;
+}
+
+/*
+ * Weighted variant, row rows[i] contributes weights[i] times its loss.
+ * Regularization is scaled by the sum of weights, so importance weights
+ * of a subsample leave the objective of the full data set in expectation.
+ */
+template<typename _ValueType>
+std::valarray<_ValueType>
+fit_rows(
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::vector<size_type> & rows,
+    const std::valarray<_ValueType> & weights,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef std::valarray<_ValueType> vector_type;
+
+    vector_type tcol(rows.size());
+    size_type nevals{0};
 
-    //    grad += (H - y)' * X;
-    H -= y;
-    for (size_type r{0}; r < X_shape.second; ++r)
+    const vector_type theta = detail::fit_partial_sums(
+        [&](_ValueType & sigma, vector_type & grad, const vector_type & theta)
+        {
+            logreg_partial_sums(sigma, grad, tcol, theta, X, y, rows, weights);
+        },
+        weights.sum(), theta0, C, max_iter, &nevals);
+
+    if (o_rows_visited)
     {
-        out_grad[r] += (X[X.column(r)] * H).sum();
+        *o_rows_visited = nevals * rows.size();
     }
-    //    grad /= m;
-    out_grad /= X_shape.first;
+
+    return theta;
 }
 
+/*
+ * Same as LogisticRegression::fit on the records behind unique rows X
+ * with label counts pos and neg, see dedup_rows.
+ */
+template<typename _ValueType>
+std::valarray<_ValueType>
+fit_counts(
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & pos,
+    const std::valarray<_ValueType> & neg,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef std::valarray<_ValueType> vector_type;
+
+    vector_type tcol(X.shape().first);
+    size_type nevals{0};
+
+    const vector_type theta = detail::fit_partial_sums(
+        [&](_ValueType & sigma, vector_type & grad, const vector_type & theta)
+        {
+            logreg_counts_partial_sums(sigma, grad, tcol, theta, X, pos, neg);
+        },
+        (pos + neg).sum(), theta0, C, max_iter, &nevals);
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * X.shape().first;
+    }
+
+    return theta;
+}
 
+/*
+ * Same as LogisticRegression::fit over a CompactMatrix.
+ */
 template<typename _ValueType>
-std::pair<_ValueType, std::valarray<_ValueType>>
-logreg_cost_grad(
-    const std::valarray<_ValueType> theta,
-    const array2d<_ValueType> X,
-    const std::valarray<_ValueType> y,
-    const _ValueType C)
+std::valarray<_ValueType>
+fit_compact(
+    const CompactMatrix<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type * o_rows_visited = nullptr
+)
 {
-    typedef _ValueType value_type;
-    typedef std::valarray<value_type> vector;
+    typedef std::valarray<_ValueType> vector_type;
 
-    const shape_type X_shape = X.shape();
+    size_type nevals{0};
 
-    vector temp(X_shape.first);
+    const vector_type theta = detail::fit_partial_sums(
+        [&](_ValueType & sigma, vector_type & grad, const vector_type & theta)
+        {
+            logreg_partial_sums(sigma, grad, theta, X, y);
+        },
+        (_ValueType)X.shape().first, theta0, C, max_iter, &nevals);
 
-    const double cost;
-    const vector grad(X_shape.first);
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * X.shape().first;
+    }
 
-    logreg_cost_grad(cost, grad, temp, theta, X, y, C);
+    return theta;
+}
 
-    return std::make_pair(cost, grad);
+/*
+ * Same as LogisticRegression::fit over the hybrid matrix [X S].
+ */
+template<typename _ValueType>
+std::valarray<_ValueType>
+fit_hybrid(
+    const array2d<_ValueType> & X,
+    const csr_matrix<_ValueType> & S,
+    const std::valarray<_ValueType> & y,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef std::valarray<_ValueType> vector_type;
+
+    size_type nevals{0};
+
+    const vector_type theta = detail::fit_partial_sums(
+        [&](_ValueType & sigma, vector_type & grad, const vector_type & theta)
+        {
+            logreg_partial_sums(sigma, grad, theta, X, S, y, 0, X.shape().first);
+        },
+        (_ValueType)X.shape().first, theta0, C, max_iter, &nevals);
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * X.shape().first;
+    }
+
+    return theta;
 }
 
 template<typename _ValueType>
@@ -129,11 +1413,31 @@ public:
         vector_type && y,
         vector_type && theta0,
         value_type C,
-        size_type max_iter
+        size_type max_iter,
+        interactions_type interactions = interactions_type()
     );
 
+    /// number of coefficients, intercept and interactions included
+    size_type nfeatures(void) const
+    {
+        return m_X.shape().second + m_interactions.size();
+    }
+
+    vector_type
+    fit(size_type * o_rows_visited = nullptr) const;
+
+    vector_type
+    fit(const MiniBatchCfg<value_type> & cfg, size_type * o_rows_visited = nullptr) const;
+
+    /// L1 / elastic-net fit, the penalty comes from cfg instead of C
+    vector_type
+    fit(const ElasticNetCfg<value_type> & cfg, size_type * o_rows_visited = nullptr) const;
+
+    /// weighted fit, row r of X counts weights[r] times; weights are
+    /// std::vector<float/double> or RunLengthWeights
+    template<typename _Weights>
     vector_type
-    fit(void) const;
+    fit_weighted(const _Weights & weights, size_type * o_rows_visited = nullptr) const;
 
     vector_type
     predict(const array_type & X, const vector_type & theta, bool round = true) const;
@@ -141,12 +1445,17 @@ public:
     vector_type
     predict(array_type && X, vector_type && theta, bool round = true) const;
 
+    /// prediction over the hybrid matrix [X S], theta as fitted by fit_hybrid
+    vector_type
+    predict(const array_type & X, const csr_matrix<value_type> & S, const vector_type & theta, bool round = true) const;
+
 private:
     const array_type m_X;
     const vector_type m_y;
     const vector_type m_theta0;
     const value_type m_C;
     const size_type m_max_iter;
+    const interactions_type m_interactions;
 };
 
 template<typename _ValueType>
@@ -155,37 +1464,116 @@ LogisticRegression<_ValueType>::LogisticRegression(
     vector_type && y,
     vector_type && theta0,
     value_type C,
-    size_type max_iter
+    size_type max_iter,
+    interactions_type interactions
 )
 :
     m_X{std::move(X)},
     m_y{std::move(y)},
-    m_theta0{m_theta0.size() == m_X.shape().second ? std::move(theta0) : vector_type(m_X.shape().second)},
+    m_theta0{theta0.size() == m_X.shape().second + interactions.size() ?
+        std::move(theta0) : vector_type(m_X.shape().second + interactions.size())},
     m_C{C},
-    m_max_iter{max_iter}
+    m_max_iter{max_iter},
+    m_interactions{std::move(interactions)}
 {
 }
 
 template<typename _ValueType>
 typename LogisticRegression<_ValueType>::vector_type
-LogisticRegression<_ValueType>::fit(void) const
+LogisticRegression<_ValueType>::fit(size_type * o_rows_visited) const
 {
-    vector_type tcol(m_y.size());
+    size_type nevals{0};
 
-    std::function<std::pair<value_type, vector_type> (vector_type)>
+    // widths known at compile time get unrolled row kernels
+    detail::FixedWidthFit<value_type> fixed_fit{m_X, m_y, m_theta0, m_C, m_max_iter, vector_type(), 0};
 
-    /* NOTE: Capturing member variables is always done via capturing this */
-    cost_fn = [this, &tcol](const vector_type theta) -> std::pair<value_type, vector_type>
+    vector_type theta;
+    if (m_interactions.empty() && detail::FixedWidthDispatch<NUM_LOGREG_FIXED_WIDTHS>::apply(m_X.shape().second, fixed_fit))
     {
-        value_type cost;
-        vector_type grad(theta.size());
+        theta = fixed_fit.theta;
+        nevals = fixed_fit.nevals;
+    }
+    else
+    {
+        vector_type tcol(m_y.size());
 
-        num::logreg_cost_grad(cost, grad, tcol, theta, this->m_X, this->m_y, this->m_C);
+        std::function<std::pair<value_type, vector_type> (vector_type)>
 
-        return std::make_pair(cost, grad);
-    };
+        /* NOTE: Capturing member variables is always done via capturing this */
+        cost_fn = [this, &tcol, &nevals](const vector_type theta) -> std::pair<value_type, vector_type>
+        {
+            ++nevals;
+
+            value_type cost;
+            vector_type grad(theta.size());
+
+            if (this->m_interactions.empty())
+            {
+                num::logreg_cost_grad(cost, grad, tcol, theta, this->m_X, this->m_y, this->m_C);
+            }
+            else
+            {
+                num::logreg_cost_grad(cost, grad, theta, this->m_X, this->m_y, this->m_interactions, this->m_C);
+            }
 
-    const vector_type theta = num::fmincg(cost_fn, m_theta0, m_max_iter, false);
+            return std::make_pair(cost, grad);
+        };
+
+        theta = num::fmincg(cost_fn, m_theta0, m_max_iter, false);
+    }
+
+    if (o_rows_visited)
+    {
+        // every evaluation is a full pass over the training rows
+        *o_rows_visited = nevals * m_y.size();
+    }
+
+    return theta;
+}
+
+template<typename _ValueType>
+typename LogisticRegression<_ValueType>::vector_type
+LogisticRegression<_ValueType>::fit(const MiniBatchCfg<value_type> & cfg, size_type * o_rows_visited) const
+{
+    // interaction terms are evaluated by the full-batch kernel only
+    assert(m_interactions.empty());
+
+    ArrayRowSource<value_type> source(m_X, m_y);
+
+    return num::minibatch_fit(source, m_theta0, m_C, cfg, o_rows_visited);
+}
+
+template<typename _ValueType>
+typename LogisticRegression<_ValueType>::vector_type
+LogisticRegression<_ValueType>::fit(const ElasticNetCfg<value_type> & cfg, size_type * o_rows_visited) const
+{
+    assert(m_interactions.empty());
+
+    return num::elastic_net_fit(m_X, m_y, m_theta0, cfg, o_rows_visited);
+}
+
+template<typename _ValueType>
+template<typename _Weights>
+typename LogisticRegression<_ValueType>::vector_type
+LogisticRegression<_ValueType>::fit_weighted(const _Weights & weights, size_type * o_rows_visited) const
+{
+    assert(weights.size() == m_y.size());
+    assert(m_interactions.empty());
+
+    vector_type tcol(m_y.size());
+    size_type nevals{0};
+
+    const vector_type theta = detail::fit_partial_sums(
+        [this, &tcol, &weights](value_type & sigma, vector_type & grad, const vector_type & theta)
+        {
+            logreg_weighted_partial_sums(sigma, grad, tcol, theta, this->m_X, this->m_y, weights);
+        },
+        (value_type)weights_sum(weights), m_theta0, m_C, m_max_iter, &nevals);
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * m_y.size();
+    }
 
     return theta;
 }
@@ -194,12 +1582,52 @@ template<typename _ValueType>
 typename LogisticRegression<_ValueType>::vector_type
 LogisticRegression<_ValueType>::predict(const array_type & X, const vector_type & theta, bool round) const
 {
-    assert(theta.size() == X.shape().second);
+    assert(theta.size() == X.shape().second + m_interactions.size());
     vector_type H(X.shape().first);
 
-    for (size_type r{0}; r < X.shape().first; ++r)
+    // sparse (L1 fitted) models are scored over their nonzero coefficients
+    std::vector<size_type> support;
+    for (size_type c{0}; c < X.shape().second; ++c)
     {
-        H[r] = (X[X.row(r)] * theta).sum();
+        if (theta[c] != 0.0)
+        {
+            support.push_back(c);
+        }
+    }
+
+    if (m_interactions.empty() && support.size() == X.shape().second)
+    {
+        // widths known at compile time get an unrolled row kernel
+        detail::FixedWidthMargins<value_type> fixed_margins{X, theta, H};
+
+        if (!detail::FixedWidthDispatch<NUM_LOGREG_FIXED_WIDTHS>::apply(X.shape().second, fixed_margins))
+        {
+            for (size_type r{0}; r < X.shape().first; ++r)
+            {
+                H[r] = (X[X.row(r)] * theta).sum();
+            }
+        }
+    }
+    else if (m_interactions.empty())
+    {
+        for (size_type r{0}; r < X.shape().first; ++r)
+        {
+            const value_type * x = X.data() + r * X.shape().second;
+            value_type z{0.0};
+
+            for (const size_type c : support)
+            {
+                z += x[c] * theta[c];
+            }
+            H[r] = z;
+        }
+    }
+    else
+    {
+        for (size_type r{0}; r < X.shape().first; ++r)
+        {
+            H[r] = detail::interaction_margin(X.data() + r * X.shape().second, &theta[0], X.shape().second, m_interactions);
+        }
     }
 
     if (round)
@@ -221,6 +1649,34 @@ LogisticRegression<_ValueType>::predict(array_type && X, vector_type && theta, b
     return predict(X, theta, round);
 }
 
+template<typename _ValueType>
+typename LogisticRegression<_ValueType>::vector_type
+LogisticRegression<_ValueType>::predict(
+    const array_type & X, const csr_matrix<value_type> & S, const vector_type & theta, bool round) const
+{
+    assert(m_interactions.empty());
+    assert(S.shape().first == X.shape().first);
+    assert(theta.size() == X.shape().second + S.shape().second);
+
+    vector_type H(X.shape().first);
+
+    for (size_type r{0}; r < X.shape().first; ++r)
+    {
+        H[r] = detail::hybrid_margin(X.data() + r * X.shape().second, &theta[0], X.shape().second, S, r);
+    }
+
+    if (round)
+    {
+        H = sigmoid(H).apply(std::round);
+    }
+    else
+    {
+        H = sigmoid(H);
+    }
+
+    return H;
+}
+
 }  // namespace num
 
 #endif /* LOGREG_HPP_ */
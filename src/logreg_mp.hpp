@@ -0,0 +1,467 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: logreg_mp.hpp
+ *
+ * Description:
+ *      Data-parallel logistic regression cost/gradient evaluated by
+ *      several local worker processes
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef LOGREG_MP_HPP_
+#define LOGREG_MP_HPP_
+
+#include "array2d.hpp"
+#include "logreg.hpp"
+#include "fmincg.hpp"
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <functional>
+#include <system_error>
+#include <utility>
+#include <valarray>
+#include <vector>
+
+namespace num
+{
+
+/*
+ * Training rows are split into nshards contiguous shards. Shard 0 is
+ * evaluated by the calling (coordinator) process, the remaining ones by
+ * forked worker processes. Every worker copies its shard into memory it
+ * touches first, so that on a multi-node box the pages end up local to
+ * the node the worker is scheduled on.
+ *
+ * Per evaluation the coordinator publishes theta in a shared anonymous
+ * mapping, wakes the workers through a pipe, evaluates its own shard and
+ * then sums up partial costs and gradients from the shared mapping in
+ * shard order, so the result does not depend on worker timing.
+ */
+template<typename _ValueType>
+class ShardedLogRegCostGrad
+{
+public:
+    typedef _ValueType value_type;
+    typedef std::valarray<value_type> vector_type;
+    typedef array2d<value_type> array_type;
+
+    ShardedLogRegCostGrad(
+        const array_type & X,
+        const vector_type & y,
+        value_type C,
+        size_type nshards
+    );
+
+    ~ShardedLogRegCostGrad();
+
+    ShardedLogRegCostGrad(const ShardedLogRegCostGrad &) = delete;
+    ShardedLogRegCostGrad & operator=(const ShardedLogRegCostGrad &) = delete;
+
+    std::pair<value_type, vector_type>
+    operator()(const vector_type & theta);
+
+private:
+    size_type shard_begin(size_type shard) const;
+    value_type * theta_slot(void) const;
+    value_type * partial_slot(size_type shard) const;
+
+    /// forks the worker of shard, on failure nothing is left open
+    void spawn_worker(size_type shard);
+    void worker_loop(size_type shard, int cmd_fd, int done_fd) const;
+
+    /// closes the pipes, reaps the workers and unmaps the shared memory
+    void teardown(void);
+
+    /// false when the reading end is gone, SIGPIPE is not delivered
+    static bool write_byte(int fd, char ch);
+    /// false on EOF
+    static bool read_byte(int fd, char & ch);
+
+    const array_type & m_X;
+    const vector_type & m_y;
+    const value_type m_C;
+    const size_type m_nshards;
+    const size_type m_ncols;
+
+    vector_type m_tcol;
+
+    value_type * m_shm;
+    size_type m_shm_bytes;
+
+    std::vector<pid_t> m_pids;
+    std::vector<int> m_cmd_fds;
+    std::vector<int> m_done_fds;
+};
+
+template<typename _ValueType>
+ShardedLogRegCostGrad<_ValueType>::ShardedLogRegCostGrad(
+    const array_type & X,
+    const vector_type & y,
+    value_type C,
+    size_type nshards
+)
+:
+    m_X(X),
+    m_y(y),
+    m_C{C},
+    m_nshards{std::max<size_type>(1, std::min(nshards, X.shape().first))},
+    m_ncols{X.shape().second},
+    m_tcol(shard_begin(1)),
+    m_shm{nullptr},
+    m_shm_bytes{(m_ncols + m_nshards * (1 + m_ncols)) * sizeof (value_type)}
+{
+    assert(y.size() == X.shape().first);
+
+    void * shm = ::mmap(nullptr, m_shm_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shm == MAP_FAILED)
+    {
+        throw std::system_error(errno, std::system_category(), "mmap");
+    }
+    m_shm = static_cast<value_type *>(shm);
+
+    try
+    {
+        for (size_type shard{1}; shard < m_nshards; ++shard)
+        {
+            spawn_worker(shard);
+        }
+    }
+    catch (...)
+    {
+        // the destructor will not run, workers forked so far must not
+        // outlive us waiting for commands
+        for (auto pid : m_pids)
+        {
+            ::kill(pid, SIGKILL);
+        }
+        teardown();
+        throw;
+    }
+}
+
+template<typename _ValueType>
+void
+ShardedLogRegCostGrad<_ValueType>::spawn_worker(size_type shard)
+{
+    int cmd_pipe[2];
+    int done_pipe[2];
+
+    if (::pipe(cmd_pipe) != 0)
+    {
+        throw std::system_error(errno, std::system_category(), "pipe");
+    }
+    if (::pipe(done_pipe) != 0)
+    {
+        const int error = errno;
+        ::close(cmd_pipe[0]);
+        ::close(cmd_pipe[1]);
+        throw std::system_error(error, std::system_category(), "pipe");
+    }
+
+    const pid_t pid = ::fork();
+
+    if (pid < 0)
+    {
+        const int error = errno;
+        for (auto fd : {cmd_pipe[0], cmd_pipe[1], done_pipe[0], done_pipe[1]})
+        {
+            ::close(fd);
+        }
+        throw std::system_error(error, std::system_category(), "fork");
+    }
+    else if (pid == 0)
+    {
+        // drop descriptors of the workers forked before us,
+        // otherwise they would not see EOF when we are torn down
+        for (auto fd : m_cmd_fds)
+        {
+            ::close(fd);
+        }
+        for (auto fd : m_done_fds)
+        {
+            ::close(fd);
+        }
+        ::close(cmd_pipe[1]);
+        ::close(done_pipe[0]);
+
+        int status = EXIT_SUCCESS;
+        try
+        {
+            worker_loop(shard, cmd_pipe[0], done_pipe[1]);
+        }
+        catch (...)
+        {
+            status = EXIT_FAILURE;
+        }
+        ::_exit(status);
+    }
+
+    ::close(cmd_pipe[0]);
+    ::close(done_pipe[1]);
+
+    m_pids.push_back(pid);
+    m_cmd_fds.push_back(cmd_pipe[1]);
+    m_done_fds.push_back(done_pipe[0]);
+}
+
+template<typename _ValueType>
+ShardedLogRegCostGrad<_ValueType>::~ShardedLogRegCostGrad()
+{
+    teardown();
+}
+
+template<typename _ValueType>
+void
+ShardedLogRegCostGrad<_ValueType>::teardown(void)
+{
+    // workers leave their loop on EOF
+    for (auto fd : m_cmd_fds)
+    {
+        ::close(fd);
+    }
+    for (auto pid : m_pids)
+    {
+        int status;
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+    }
+    for (auto fd : m_done_fds)
+    {
+        ::close(fd);
+    }
+
+    ::munmap(m_shm, m_shm_bytes);
+}
+
+template<typename _ValueType>
+size_type
+ShardedLogRegCostGrad<_ValueType>::shard_begin(size_type shard) const
+{
+    return m_X.shape().first * shard / m_nshards;
+}
+
+template<typename _ValueType>
+_ValueType *
+ShardedLogRegCostGrad<_ValueType>::theta_slot(void) const
+{
+    return m_shm;
+}
+
+template<typename _ValueType>
+_ValueType *
+ShardedLogRegCostGrad<_ValueType>::partial_slot(size_type shard) const
+{
+    // [sigma, grad[0], ..., grad[ncols - 1]]
+    return m_shm + m_ncols + shard * (1 + m_ncols);
+}
+
+template<typename _ValueType>
+bool
+ShardedLogRegCostGrad<_ValueType>::write_byte(int fd, char ch)
+{
+    // writing to a pipe whose reader died raises SIGPIPE, which by default
+    // would kill the process; block it for the write and take the one the
+    // write raised, unless it was pending already, off the pending set
+    sigset_t sigpipe_set;
+    sigset_t saved_set;
+    sigset_t pending_set;
+
+    ::sigemptyset(&sigpipe_set);
+    ::sigaddset(&sigpipe_set, SIGPIPE);
+    ::pthread_sigmask(SIG_BLOCK, &sigpipe_set, &saved_set);
+
+    ::sigpending(&pending_set);
+    const bool was_pending = ::sigismember(&pending_set, SIGPIPE);
+
+    int error{0};
+    while (::write(fd, &ch, 1) != 1)
+    {
+        if (errno != EINTR)
+        {
+            error = errno;
+            break;
+        }
+    }
+
+    if (error == EPIPE && !was_pending)
+    {
+        const timespec no_wait{0, 0};
+        while (::sigtimedwait(&sigpipe_set, nullptr, &no_wait) < 0 && errno == EINTR)
+        {
+        }
+    }
+    ::pthread_sigmask(SIG_SETMASK, &saved_set, nullptr);
+
+    if (error && error != EPIPE)
+    {
+        throw std::system_error(error, std::system_category(), "write");
+    }
+
+    return error == 0;
+}
+
+template<typename _ValueType>
+bool
+ShardedLogRegCostGrad<_ValueType>::read_byte(int fd, char & ch)
+{
+    ssize_t nread;
+
+    while ((nread = ::read(fd, &ch, 1)) < 0)
+    {
+        if (errno != EINTR)
+        {
+            throw std::system_error(errno, std::system_category(), "read");
+        }
+    }
+
+    return nread == 1;
+}
+
+template<typename _ValueType>
+void
+ShardedLogRegCostGrad<_ValueType>::worker_loop(size_type shard, int cmd_fd, int done_fd) const
+{
+    const size_type rbegin = shard_begin(shard);
+    const size_type rend = shard_begin(shard + 1);
+    const size_type nrows = rend - rbegin;
+
+    // private, first-touched copy of our shard
+    array_type X({nrows, m_ncols}, 0.0);
+    for (size_type r{0}; r < nrows; ++r)
+    {
+        X[X.row(r)] = m_X[m_X.row(rbegin + r)];
+    }
+    const vector_type y = m_y[std::slice(rbegin, nrows, 1)];
+
+    vector_type theta(m_ncols);
+    vector_type grad(m_ncols);
+    vector_type tcol(nrows);
+
+    for (char cmd; read_byte(cmd_fd, cmd);)
+    {
+        std::copy(theta_slot(), theta_slot() + m_ncols, std::begin(theta));
+
+        value_type sigma;
+        logreg_partial_sums(sigma, grad, tcol, theta, X, y, 0, nrows);
+
+        value_type * slot = partial_slot(shard);
+        slot[0] = sigma;
+        std::copy(std::begin(grad), std::end(grad), slot + 1);
+
+        if (!write_byte(done_fd, cmd))
+        {
+            // the coordinator is gone
+            break;
+        }
+    }
+}
+
+template<typename _ValueType>
+std::pair<_ValueType, std::valarray<_ValueType>>
+ShardedLogRegCostGrad<_ValueType>::operator()(const vector_type & theta)
+{
+    assert(theta.size() == m_ncols);
+
+    std::copy(std::begin(theta), std::end(theta), theta_slot());
+
+    for (auto fd : m_cmd_fds)
+    {
+        if (!write_byte(fd, 'E'))
+        {
+            throw std::system_error(EPIPE, std::system_category(), "worker died");
+        }
+    }
+
+    // meanwhile, take care of shard 0 ourselves
+    value_type sigma;
+    vector_type grad(m_ncols);
+    logreg_partial_sums(sigma, grad, m_tcol, theta, m_X, m_y, 0, shard_begin(1));
+
+    for (size_type shard{1}; shard < m_nshards; ++shard)
+    {
+        char ack;
+        if (!read_byte(m_done_fds[shard - 1], ack))
+        {
+            throw std::system_error(EPIPE, std::system_category(), "worker died");
+        }
+
+        const value_type * slot = partial_slot(shard);
+        sigma += slot[0];
+        grad += vector_type(slot + 1, m_ncols);
+    }
+
+    value_type cost;
+    logreg_cost_grad_finalize(cost, grad, sigma, theta, m_X.shape().first, m_C);
+
+    return std::make_pair(cost, grad);
+}
+
+/*
+ * Same as LogisticRegression::fit, but with cost/gradient evaluated
+ * by nshards processes.
+ */
+template<typename _ValueType>
+std::valarray<_ValueType>
+fit_sharded(
+    const array2d<_ValueType> & X,
+    const std::valarray<_ValueType> & y,
+    const std::valarray<_ValueType> & theta0,
+    _ValueType C,
+    size_type max_iter,
+    size_type nshards,
+    size_type * o_rows_visited = nullptr
+)
+{
+    typedef _ValueType value_type;
+    typedef std::valarray<value_type> vector_type;
+
+    ShardedLogRegCostGrad<value_type> sharded_cost_grad(X, y, C, nshards);
+
+    size_type nevals{0};
+
+    std::function<std::pair<value_type, vector_type> (vector_type)>
+
+    cost_fn = [&sharded_cost_grad, &nevals](const vector_type theta) -> std::pair<value_type, vector_type>
+    {
+        ++nevals;
+        return sharded_cost_grad(theta);
+    };
+
+    const vector_type theta = num::fmincg(cost_fn, theta0, max_iter, false);
+
+    if (o_rows_visited)
+    {
+        *o_rows_visited = nevals * y.size();
+    }
+
+    return theta;
+}
+
+}  // namespace num
+
+#endif /* LOGREG_MP_HPP_ */
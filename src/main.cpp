@@ -22,6 +22,7 @@
  ******************************************************************************/
 
 #include "TripSafetyFactors.hpp"
+#include "thread_pool.hpp"
 
 #include <fstream>
 #include <vector>
@@ -34,138 +35,709 @@
 #include <cassert>
 #include <valarray>
 #include <iterator>
+#include <map>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <utility>
+#include <numeric>
+#include <cmath>
+#include <stdexcept>
 
-int main(int argc, char **argv)
+/*
+ * Contest score of ranks for rows with known EVT_CNT labels: a row with
+ * EVT_CNT > 0 ranked r earns max((2N - r) / 2N, 0), one with EVT_CNT > 1
+ * additionally max(0.3 (2M - r) / 2M, 0). Points are normalized by the
+ * best achievable and scaled to 1000000.
+ */
+int tco_score(const std::vector<int> & ranks, const std::vector<int> & labels)
 {
-    const int SEED = (argc == 2 ? std::atoi(argv[1]) : 1);
-    const char * FNAME = (argc == 3 ? argv[2] : "../data/exampleData.csv");
+    assert(ranks.size() == labels.size());
 
-    std::cerr << "SEED: " << SEED << ", CSV: " << FNAME << std::endl;
+    const std::size_t N = std::count_if(labels.cbegin(), labels.cend(), [](int v) { return v > 0; });
+    const std::size_t M = std::count_if(labels.cbegin(), labels.cend(), [](int v) { return v > 1; });
 
-    std::ifstream fcsv(FNAME);
-    std::vector<std::string> vcsv;
+    auto score = [N](std::size_t rank) { return std::max((2.0f * N - rank) / (2 * N), 0.0f); };
+    auto bonus = [M](std::size_t rank) { return std::max(0.3f * (2.0f * M - rank) / (2 * M), 0.0f); };
 
-    for (std::string line; std::getline(fcsv, line);)
+    float MAX_POINTS{0.0f};
+    for (std::size_t rank{1}; rank <= N; ++rank)
+    {
+        MAX_POINTS += score(rank);
+    }
+    for (std::size_t rank{1}; rank <= M; ++rank)
+    {
+        MAX_POINTS += bonus(rank);
+    }
+
+    float POINTS{0.0f};
+    for (std::size_t i{0}; i < ranks.size(); ++i)
+    {
+        POINTS += labels[i] > 0 ? score(ranks[i]) : 0.0f;
+    }
+    for (std::size_t i{0}; i < ranks.size(); ++i)
     {
-        vcsv.push_back(line);
+        POINTS += labels[i] > 1 ? bonus(ranks[i]) : 0.0f;
     }
-    fcsv.close();
 
-    std::cerr << "Read " << vcsv.size() << " lines" << std::endl;
+    return (int)std::round(1000000 * POINTS / MAX_POINTS);
+}
+
+/*
+ * Row selection helpers over a parsed data set (all columns, EVT_CNT
+ * included), shared by cross-validation and hyperparameter search.
+ */
+std::vector<std::size_t> shuffled_rows(const std::size_t nrows, const int seed)
+{
+    std::vector<std::size_t> perm(nrows);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::mt19937 g(seed);
+    std::shuffle(perm.begin(), perm.end(), g);
+    return perm;
+}
+
+/// random 67/33 train/test split, like the one of the default mode
+std::pair<std::vector<std::size_t>, std::vector<std::size_t>>
+split_rows(const std::size_t nrows, const int seed)
+{
+    const std::vector<std::size_t> perm = shuffled_rows(nrows, seed);
+    const std::size_t PIVOT = 0.67 * nrows;
+
+    return std::make_pair(
+        std::vector<std::size_t>(perm.cbegin(), perm.cbegin() + PIVOT),
+        std::vector<std::size_t>(perm.cbegin() + PIVOT, perm.cend()));
+}
+
+/*
+ * Fits and scores the model selected by model_cfg on several train/test
+ * partitions of one parsed data set, concurrently on a thread pool.
+ * Every fit runs in this process, LogRegCfg::Fit::Sharded falls back to
+ * LogRegCfg::Fit::CG. With
+ * nfolds > 1 the partitions are
+ * k folds of a shuffled data set, otherwise nrepeats random 67/33 splits
+ * like the one of the default mode, for seeds SEED, SEED + 1, ...
+ */
+void cross_validate(
+    const num::array2d<real_type> & data,
+    const LogRegCfg & cfg,
+    const ModelCfg & model_cfg,
+    const int SEED,
+    const std::size_t nfolds,
+    const std::size_t nrepeats,
+    const std::size_t nthreads,
+    const bool top_k_auto)
+{
+    typedef std::vector<std::size_t> rows_type;
+
+    const std::size_t NROWS = data.shape().first;
+
+    std::vector<std::pair<rows_type, rows_type>> partitions;
+
+    auto shuffled = [NROWS](int seed) -> rows_type
+    {
+        return shuffled_rows(NROWS, seed);
+    };
+
+    if (nfolds > 1)
+    {
+        const rows_type perm = shuffled(SEED);
+
+        for (std::size_t fold{0}; fold < nfolds; ++fold)
+        {
+            const std::size_t lo = NROWS * fold / nfolds;
+            const std::size_t hi = NROWS * (fold + 1) / nfolds;
+
+            rows_type train(perm.cbegin(), perm.cbegin() + lo);
+            train.insert(train.end(), perm.cbegin() + hi, perm.cend());
+
+            partitions.emplace_back(std::move(train), rows_type(perm.cbegin() + lo, perm.cbegin() + hi));
+        }
+    }
+    else
+    {
+        for (std::size_t rep{0}; rep < nrepeats; ++rep)
+        {
+            partitions.push_back(split_rows(NROWS, SEED + rep));
+        }
+    }
 
+    if (cfg.fit() == LogRegCfg::Fit::Sharded)
     {
-        std::mt19937 g(SEED);
-        std::shuffle(vcsv.begin(), vcsv.end(), g);
+        std::cerr << "note: --workers=" << cfg.workers() << " ignored, cross-validation fits in one process" << std::endl;
     }
 
-    const std::size_t PIVOT = 0.67 * vcsv.size();
+    const auto t0 = std::chrono::steady_clock::now();
 
-    std::vector<std::string> train_data(vcsv.cbegin(), vcsv.cbegin() + PIVOT);
-    std::vector<std::string> test_data(vcsv.cbegin() + PIVOT, vcsv.cend());
+    std::vector<std::future<std::pair<int, double>>> results;
+    {
+        num::ThreadPool pool(nthreads);
 
-    const std::size_t N = std::count_if(test_data.cbegin(), test_data.cend(),
-        [](const std::string & line) -> bool
+        for (const auto & partition : partitions)
         {
-            const std::size_t pos = line.rfind(',');
-            assert(pos != std::string::npos);
-            const int last_val = std::atoi(line.c_str() + pos + 1);
-            return last_val > 0;
+            results.push_back(pool.submit(
+                [&, cfg]() -> std::pair<int, double>
+                {
+                    const auto start = std::chrono::steady_clock::now();
+
+                    const std::valarray<real_type> y_test = TripSafetyFactors::gather_labels(data, partition.second);
+                    const std::vector<int> test_labels(std::begin(y_test), std::end(y_test));
+
+                    LogRegCfg fold_cfg(cfg);
+                    // forking from a multi-threaded process is not an option
+                    fold_cfg.verbose(false);
+                    if (fold_cfg.fit() == LogRegCfg::Fit::Sharded)
+                    {
+                        fold_cfg.fit(LogRegCfg::Fit::CG);
+                    }
+                    if (top_k_auto)
+                    {
+                        fold_cfg.rank_top_k(2 * std::count_if(test_labels.cbegin(), test_labels.cend(), [](int v) { return v > 0; }));
+                    }
+
+                    const std::vector<int> ranks =
+                        TripSafetyFactors(fold_cfg, model_cfg).predict(data, partition.first, partition.second);
+
+                    const auto stop = std::chrono::steady_clock::now();
+
+                    return std::make_pair(tco_score(ranks, test_labels), std::chrono::duration<double>(stop - start).count());
+                }
+            ));
         }
-    );
-    std::cerr << "N: " << N << std::endl;
+    }
+
+    const double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::valarray<real_type> scores(results.size());
+    for (std::size_t i{0}; i < results.size(); ++i)
+    {
+        const std::pair<int, double> result = results[i].get();
+        scores[i] = result.first;
+
+        std::cerr << (nfolds > 1 ? "fold " : "split ") << i << ": SCORE: " << result.first
+            << ", time [s]: " << result.second << std::endl;
+    }
+
+    std::cerr << "SCORE mean: " << num::mean(scores) << ", std: " << num::std(scores)
+        << ", partitions: " << scores.size() << ", threads: " << nthreads
+        << ", wall time [s]: " << wall_time << std::endl;
+}
+
+/*
+ * Grid search over C, max_iter and the set of density encoded columns on
+ * one random split of the data, logistic regression only. Every fit runs
+ * in this process, LogRegCfg::Fit::Sharded falls back to LogRegCfg::Fit::CG.
+ * Every (max_iter, columns) pair is a task
+ * on the thread pool, walking the C grid in ascending order: each fit is
+ * warm started from theta of the previous, more regularized one, so that
+ * a path costs much less than the same number of cold fits.
+ */
+void hyperparameter_search(
+    const num::array2d<real_type> & data,
+    const LogRegCfg & cfg,
+    const int SEED,
+    std::vector<real_type> C_grid,
+    const std::vector<std::size_t> & iter_grid,
+    const std::vector<std::vector<std::size_t>> & density_sets,
+    const std::size_t nthreads,
+    const bool top_k_auto)
+{
+    typedef std::vector<std::size_t> rows_type;
+
+    struct Result
+    {
+        real_type C;
+        int score;
+        double seconds;
+    };
+
+    std::sort(C_grid.begin(), C_grid.end());
 
-    const std::size_t M = std::count_if(test_data.cbegin(), test_data.cend(),
-        [](const std::string & line) -> bool
+    const std::pair<rows_type, rows_type> split = split_rows(data.shape().first, SEED);
+
+    const num::array2d<real_type> X_train = TripSafetyFactors::gather_features(data, split.first);
+    const std::valarray<real_type> y_train = TripSafetyFactors::gather_labels(data, split.first);
+    const num::array2d<real_type> X_test = TripSafetyFactors::gather_features(data, split.second);
+
+    const std::valarray<real_type> y_test = TripSafetyFactors::gather_labels(data, split.second);
+    const std::vector<int> test_labels(std::begin(y_test), std::end(y_test));
+
+    if (cfg.fit() == LogRegCfg::Fit::Sharded)
+    {
+        std::cerr << "note: --workers=" << cfg.workers() << " ignored, the search fits in one process" << std::endl;
+    }
+
+    LogRegCfg search_cfg(cfg);
+    // forking from a multi-threaded process is not an option
+    search_cfg.verbose(false).model_path("");
+    if (search_cfg.fit() == LogRegCfg::Fit::Sharded)
+    {
+        search_cfg.fit(LogRegCfg::Fit::CG);
+    }
+    if (top_k_auto)
+    {
+        search_cfg.rank_top_k(2 * std::count_if(test_labels.cbegin(), test_labels.cend(), [](int v) { return v > 0; }));
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<std::size_t, std::size_t>> paths;
+    std::vector<std::future<std::vector<Result>>> results;
+    {
+        num::ThreadPool pool(nthreads);
+
+        for (std::size_t iset{0}; iset < density_sets.size(); ++iset)
         {
-            const std::size_t pos = line.rfind(',');
-            assert(pos != std::string::npos);
-            const int last_val = std::atoi(line.c_str() + pos + 1);
-            return last_val > 1;
+            for (const std::size_t max_iter : iter_grid)
+            {
+                paths.emplace_back(iset, max_iter);
+
+                results.push_back(pool.submit(
+                    [&, iset, max_iter]() -> std::vector<Result>
+                    {
+                        LogRegCfg path_cfg(search_cfg);
+                        path_cfg.max_iter(max_iter).density_columns(density_sets[iset]);
+
+                        std::vector<Result> path;
+                        std::valarray<real_type> theta;
+
+                        for (const real_type C : C_grid)
+                        {
+                            const auto start = std::chrono::steady_clock::now();
+
+                            path_cfg.C(C).theta0(theta);
+
+                            const std::vector<int> ranks = do_log_reg(
+                                num::array2d<real_type>(X_train), std::valarray<real_type>(y_train),
+                                num::array2d<real_type>(X_test), path_cfg, &theta);
+
+                            const auto stop = std::chrono::steady_clock::now();
+
+                            path.push_back({C, tco_score(ranks, test_labels), std::chrono::duration<double>(stop - start).count()});
+                        }
+
+                        return path;
+                    }
+                ));
+            }
         }
-    );
-    std::cerr << "M: " << M << std::endl;
+    }
+
+    const double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::string best;
+    int best_score{-1};
 
-    std::sort(test_data.begin(), test_data.end(),
-        [](const std::string & lhs, const std::string & rhs) -> bool
+    std::cerr << "columns\tmax_iter\tC\tSCORE\ttime [s]" << std::endl;
+    for (std::size_t p{0}; p < paths.size(); ++p)
+    {
+        std::string columns;
+        for (const std::size_t c : density_sets[paths[p].first])
+        {
+            columns += (columns.empty() ? "" : "+") + std::string(trip::name(static_cast<trip::col>(c)));
+        }
+        columns = columns.empty() ? "-" : columns;
+
+        for (const Result & result : results[p].get())
         {
-            const std::size_t lpos = lhs.rfind(',');
-            const std::size_t rpos = rhs.rfind(',');
-            assert(lpos != std::string::npos);
-            assert(rpos != std::string::npos);
+            const std::string row = columns + "\t" + std::to_string(paths[p].second) + "\t" + std::to_string(result.C);
 
-            const int last_l_val = std::atoi(lhs.c_str() + lpos + 1);
-            const int last_r_val = std::atoi(rhs.c_str() + rpos + 1);
+            std::cerr << row << "\t" << result.score << "\t" << result.seconds << std::endl;
 
-            return last_l_val > last_r_val;
+            if (result.score > best_score)
+            {
+                best_score = result.score;
+                best = row;
+            }
         }
-    );
+    }
 
-    for (auto & item : test_data)
+    std::cerr << "best: " << best << "\tSCORE: " << best_score
+        << ", paths: " << paths.size() << ", threads: " << nthreads
+        << ", wall time [s]: " << wall_time << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    // main [--option=value ...] [SEED [CSV]]
+    std::vector<std::string> positional;
+    std::map<std::string, std::string> options;
+
+    for (int i{1}; i < argc; ++i)
     {
-        constexpr std::size_t TEST_NCOL{29};
-        std::size_t ncomma{0};
+        const std::string arg(argv[i]);
 
-        item.resize(std::distance(item.cbegin(), std::find_if(item.cbegin(), item.cend(),
-            [&ncomma](const char & ch)
+        if (arg.compare(0, 2, "--") == 0)
+        {
+            const std::size_t eq = arg.find('=');
+            options[arg.substr(2, eq - 2)] = (eq == std::string::npos ? "" : arg.substr(eq + 1));
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+
+    auto option = [&options](const std::string & name, const std::string & fallback) -> std::string
+    {
+        return options.count(name) ? options.at(name) : fallback;
+    };
+
+    auto split = [](const std::string & text, const char sep) -> std::vector<std::string>
+    {
+        std::vector<std::string> items;
+        std::string::size_type pos{0};
+        for (std::string::size_type next; (next = text.find(sep, pos)) != std::string::npos; pos = next + 1)
+        {
+            items.push_back(text.substr(pos, next - pos));
+        }
+        items.push_back(text.substr(pos));
+        return items;
+    };
+
+    const int SEED = (positional.size() >= 1 ? std::atoi(positional[0].c_str()) : 1);
+    const std::string FNAME = (positional.size() >= 2 ? positional[1] : "../data/exampleData.csv");
+
+    const std::string LR_SCHEDULE = option("lr-schedule", "invtime");
+
+    const ModelCfg model_cfg =
+        ModelCfg()
+        .model(option("model", "logreg") == "gbdt" ? ModelCfg::Model::GBDT : ModelCfg::Model::LogisticRegression)
+        .gbdt(
+            num::GbdtCfg<real_type>()
+            .ntrees(std::stoul(option("trees", "100")))
+            .max_depth(std::stoul(option("depth", "6")))
+            .learning_rate(std::stod(option("gbdt-lr", "0.1")))
+            .max_bins(std::stoul(option("bins", "255")))
+            .min_samples_leaf(std::stoul(option("min-leaf", "20")))
+            .lambda(std::stod(option("lambda", "1.0")))
+            .threads(std::stoul(option("gbdt-threads", std::to_string(std::max(1u, std::thread::hardware_concurrency())))))
+        );
+
+    LogRegCfg cfg =
+        LogRegCfg()
+        .workers(std::stoul(option("workers", "1")))
+        .minibatch(
+            num::MiniBatchCfg<real_type>()
+            .batch_size(std::stoul(option("batch-size", "256")))
+            .epochs(std::stoul(option("epochs", "4")))
+            .learning_rate(std::stod(option("lr", "0.05")))
+            .schedule(
+                LR_SCHEDULE == "const" ? num::MiniBatchCfg<real_type>::Schedule::Constant :
+                LR_SCHEDULE == "step" ? num::MiniBatchCfg<real_type>::Schedule::Step :
+                num::MiniBatchCfg<real_type>::Schedule::InverseTime)
+            .decay(std::stod(option("lr-decay", "1e-3")))
+            .seed(std::stoul(option("shuffle-seed", "1")))
+        )
+        .elastic_net(
+            num::ElasticNetCfg<real_type>()
+            .lambda(std::stod(option("l1-lambda", "1e-3")))
+            .l1_ratio(std::stod(option("l1-ratio", "1.0")))
+            .path_length(std::stoul(option("l1-path", "10")))
+            .max_sweeps(std::stoul(option("cd-sweeps", "200")))
+            .tol(std::stod(option("cd-tol", "1e-7")))
+            .strong_rules(option("strong-rules", "on") != "off")
+        )
+        .bagging(
+            num::BaggingCfg<real_type>()
+            .bags(std::stoul(option("bags", "0")))
+            .fraction(std::stod(option("bag-fraction", "1.0")))
+            .bootstrap(option("bag-sampling", "bootstrap") == "bootstrap")
+            .combine(
+                option("bag-combine", "score") == "rank" ? num::BaggingCfg<real_type>::Combine::Rank :
+                option("bag-combine", "score") == "margin" ? num::BaggingCfg<real_type>::Combine::Margin :
+                num::BaggingCfg<real_type>::Combine::Score)
+            .seed(std::stoul(option("bag-seed", "1")))
+        )
+        .negative_rate(std::stod(option("neg-rate", "1.0")))
+        .downsample_seed(std::stoul(option("neg-seed", "1")))
+        .model_path(option("model-out", ""))
+        .rank_threads(std::stoul(option("rank-threads", "1")));
+
+    if (options.count("interactions"))
+    {
+        // --interactions=WEATHER*VISIBILITY,PILOT_EXP*DIST,...
+        num::interactions_type interactions;
+        for (const auto & item : split(option("interactions", ""), ','))
+        {
+            const std::vector<std::string> names = split(item, '*');
+            if (names.size() != 2)
             {
-                if (ch == ',' && ncomma == (TEST_NCOL - 1))
-                {
-                    return true;
-                }
-                else
-                {
-                    ncomma += (ch == ',');
-                    return false;
-                }
+                throw std::invalid_argument("interaction is not a pair: " + item);
             }
-        )));
-        assert(std::count(item.cbegin(), item.cend(), ',') == (TEST_NCOL - 1));
+            interactions.emplace_back(trip::column(names[0]), trip::column(names[1]));
+        }
+        cfg.interactions(interactions);
     }
 
-    ////////////////////////////////////////////////////////////////////////////
-    TripSafetyFactors worker;
-    std::vector<int> prediction = worker.predict(train_data, test_data);
-    ////////////////////////////////////////////////////////////////////////////
+    if (options.count("one-hot"))
+    {
+        // --one-hot=PILOT,PILOT2,SOURCE
+        std::vector<num::size_type> columns;
+        for (const auto & name : split(option("one-hot", ""), ','))
+        {
+            columns.push_back(trip::column(name));
+        }
+        cfg.one_hot_columns(columns);
+    }
+
+    // each of these options selects a way of fitting of its own, none of
+    // them is dropped silently in favour of another
+    struct FitOption
+    {
+        bool given;
+        LogRegCfg::Fit fit;
+        const char * name;
+    };
+    const FitOption fit_options[] =
+    {
+        {cfg.workers() > 1, LogRegCfg::Fit::Sharded, "--workers"},
+        {option("solver", "cg") == "minibatch", LogRegCfg::Fit::MiniBatch, "--solver=minibatch"},
+        {option("solver", "cg") == "cd", LogRegCfg::Fit::CoordinateDescent, "--solver=cd"},
+        {!cfg.interactions().empty(), LogRegCfg::Fit::Interactions, "--interactions"},
+        {!cfg.one_hot_columns().empty(), LogRegCfg::Fit::OneHot, "--one-hot"},
+        {cfg.bagging().bags() != 0, LogRegCfg::Fit::Bagging, "--bags"},
+        {cfg.negative_rate() < 1.0, LogRegCfg::Fit::Downsampled, "--neg-rate"},
+        {options.count("dedup") != 0, LogRegCfg::Fit::UniqueRows, "--dedup"},
+        {options.count("compact") != 0, LogRegCfg::Fit::Compact, "--compact"},
+        {options.count("collapse-repeats") != 0, LogRegCfg::Fit::CollapsedRepeats, "--collapse-repeats"},
+    };
+
+    std::string fit_option;
+    for (const FitOption & candidate : fit_options)
+    {
+        if (candidate.given && !fit_option.empty())
+        {
+            throw std::invalid_argument("fit options cannot be combined: " + fit_option + ", " + candidate.name);
+        }
+        else if (candidate.given)
+        {
+            fit_option = candidate.name;
+            cfg.fit(candidate.fit);
+        }
+    }
+
+    if (options.count("update"))
+    {
+        // main --update=MODEL --train=CSV [--model-out=PATH]: CSV holds new
+        // labelled rows, the updated model replaces MODEL unless written elsewhere
+        const num::MappedModel model(option("update", ""));
+
+        std::ifstream fcsv(option("train", FNAME));
+        std::vector<std::string> lines;
+
+        for (std::string line; std::getline(fcsv, line);)
+        {
+            lines.push_back(line);
+        }
+
+        const std::vector<std::uint64_t> words = TripSafetyFactors(cfg).update(model.view(), std::move(lines));
+
+        const std::string path = option("model-out", option("update", ""));
+        num::save_model(path, words);
+        std::cerr << "model saved to " << path << std::endl;
+
+        return 0;
+    }
+
+    if (options.count("refine"))
+    {
+        // main --refine=MODEL --train=CSV [--model-out=PATH] [--shuffle-buffer=ROWS]
+        //      [--epochs=E] [--batch-size=B] [--lr=...]: coefficients refitted
+        // by the mini-batch solver over CSV streamed from disk, the encoders
+        // of MODEL kept; the result replaces MODEL unless written elsewhere
+        const num::MappedModel model(option("refine", ""));
+
+        std::ifstream fcsv(option("train", FNAME));
+        if (!fcsv)
+        {
+            throw std::runtime_error("cannot open " + option("train", FNAME));
+        }
+
+        const std::vector<std::uint64_t> words = TripSafetyFactors(cfg).refine(model.view(), fcsv,
+            std::stoul(option("shuffle-buffer", "65536")));
+
+        const std::string path = option("model-out", option("refine", ""));
+        num::save_model(path, words);
+        std::cerr << "model saved to " << path << std::endl;
+
+        return 0;
+    }
+
+    if (options.count("model-in"))
+    {
+        // predict-only: score the CSV with a saved model, print ranks
+        const auto t0 = std::chrono::steady_clock::now();
+
+        const num::MappedModel model(option("model-in", ""));
+
+        const auto t1 = std::chrono::steady_clock::now();
+
+        // rows are parsed straight from the mapped file
+        const num::MappedFile csv(option("test", FNAME));
+        const std::vector<num::string_ref> lines = num::split_lines(static_cast<const char *>(csv.data()), csv.size());
+
+        const std::vector<int> prediction = TripSafetyFactors(cfg).predict(model.view(), lines);
+
+        const auto t2 = std::chrono::steady_clock::now();
+
+        std::copy(prediction.cbegin(), prediction.cend(), std::ostream_iterator<int>(std::cout, "\n"));
+
+        std::cerr << "model load [ms]: " << std::chrono::duration<double, std::milli>(t1 - t0).count()
+            << ", scoring " << prediction.size() << " rows [ms]: "
+            << std::chrono::duration<double, std::milli>(t2 - t1).count() << std::endl;
+
+        return 0;
+    }
 
-    std::valarray<float> scores(test_data.size());
-    std::size_t index = 1;
-    std::generate(std::begin(scores), std::end(scores),
-        [&N, &index]()
+    std::cerr << "SEED: " << SEED << ", CSV: " << FNAME << ", workers: " << cfg.workers() << std::endl;
+
+    // parsed data set, reading, parsing and assembling overlap
+    auto ingest = [&]() -> num::array2d<real_type>
+    {
+        std::ifstream fcsv(FNAME);
+        num::IngestStats stats;
+
+        num::array2d<real_type> data = TripSafetyFactors::ingest(fcsv,
+            std::stoul(option("parsers", std::to_string(std::max(1u, std::thread::hardware_concurrency())))), &stats);
+
+        std::cerr << "parsed " << data.shape() << " in " << stats.blocks << " blocks, wall [s]: " << stats.wall
+            << ", busy [s] read: " << stats.read << ", parse: " << stats.parse << ", encode: " << stats.encode << std::endl;
+
+        return data;
+    };
+
+    if (options.count("cv"))
+    {
+        // main --cv=kfold [--folds=5] | --cv=split [--repeats=10], [--threads=T]
+        const std::size_t NFOLDS = option("cv", "") == "kfold" ? std::stoul(option("folds", "5")) : 0;
+        const std::size_t NREPEATS = std::stoul(option("repeats", "10"));
+        const std::size_t NTHREADS = std::stoul(option("threads", std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+
+        const num::array2d<real_type> data = ingest();
+
+        cross_validate(data, cfg, model_cfg, SEED, NFOLDS, NREPEATS, NTHREADS, option("top-k", "0") == "auto");
+
+        return 0;
+    }
+
+    if (options.count("search"))
+    {
+        // main --search [--C-grid=0.005,0.01,...] [--iter-grid=50,200]
+        //      [--density-sets=SOURCE+PILOT;PILOT+CYCLES;...] [--threads=T]
+        if (model_cfg.model() != ModelCfg::Model::LogisticRegression)
         {
-            return std::max((2.0f * N - index++) / (2 * N), 0.0f);
+            throw std::invalid_argument("--search tunes logistic regression only, not --model=" + option("model", ""));
         }
-    );
-    std::valarray<float> bonuses(test_data.size());
-    index = 1;
-    std::generate(std::begin(bonuses), std::end(bonuses),
-        [&M, &index]()
+
+        std::vector<real_type> C_grid;
+        for (const auto & item : split(option("C-grid", "0.002,0.005,0.01,0.02,0.05,0.1,0.2"), ','))
         {
-            return std::max(0.3f * (2.0f * M - index++) / (2 * M), 0.0f);
+            C_grid.push_back(std::stod(item));
         }
-    );
 
-    const float MAX_POINTS =
-        std::accumulate(std::begin(scores), std::begin(scores) + N, 0.0f) +
-        std::accumulate(std::begin(bonuses), std::begin(bonuses) + M, 0.0f);
+        std::vector<std::size_t> iter_grid;
+        for (const auto & item : split(option("iter-grid", std::to_string(cfg.max_iter())), ','))
+        {
+            iter_grid.push_back(std::stoul(item));
+        }
 
-    const float POINTS =
-        std::accumulate(prediction.cbegin(), prediction.cbegin() + N, 0.0f,
-            [&scores](const float & a, const int & i)
+        std::vector<std::vector<std::size_t>> density_sets;
+        if (options.count("density-sets"))
+        {
+            for (const auto & set : split(option("density-sets", ""), ';'))
             {
-                return scores[i - 1] + a;
+                density_sets.emplace_back();
+                for (const auto & name : split(set, '+'))
+                {
+                    if (!name.empty())
+                    {
+                        density_sets.back().push_back(trip::column(name));
+                    }
+                }
             }
-        ) +
-        std::accumulate(prediction.cbegin(), prediction.cbegin() + M, 0.0f,
-            [&bonuses](const float & a, const int & i)
+        }
+        else
+        {
+            density_sets.push_back(cfg.density_columns());
+        }
+
+        const std::size_t NTHREADS = std::stoul(option("threads", std::to_string(std::max(1u, std::thread::hardware_concurrency()))));
+
+        const num::array2d<real_type> data = ingest();
+
+        hyperparameter_search(data, cfg, SEED, C_grid, iter_grid, density_sets, NTHREADS, option("top-k", "0") == "auto");
+
+        return 0;
+    }
+
+    const num::array2d<real_type> data = ingest();
+
+    // same rows as a shuffle of the CSV lines with SEED, split at 67%
+    std::pair<std::vector<std::size_t>, std::vector<std::size_t>> partition = split_rows(data.shape().first, SEED);
+
+    const std::vector<std::size_t> & train_rows = partition.first;
+    std::vector<std::size_t> & test_rows = partition.second;
+
+    {
+        // EVT_CNT of every row, read once; test rows ordered by it
+        const std::valarray<real_type> labels = data[data.column(TripSafetyFactors::col::EVT_CNT)];
+
+        std::sort(test_rows.begin(), test_rows.end(),
+            [&labels](const std::size_t lhs, const std::size_t rhs) -> bool
             {
-                return bonuses[i - 1] + a;
+                return (int)labels[lhs] > (int)labels[rhs];
             }
         );
+    }
+
+    const std::valarray<real_type> y_test = TripSafetyFactors::gather_labels(data, test_rows);
+    const std::vector<int> test_labels(std::begin(y_test), std::end(y_test));
 
-    std::cerr << "MAX_POINTS: " << MAX_POINTS << std::endl;
-    std::cerr << "POINTS: " << POINTS << std::endl;
+    const std::size_t N = std::count_if(test_labels.cbegin(), test_labels.cend(), [](int v) { return v > 0; });
+    std::cerr << "N: " << N << std::endl;
+
+    const std::size_t M = std::count_if(test_labels.cbegin(), test_labels.cend(), [](int v) { return v > 1; });
+    std::cerr << "M: " << M << std::endl;
 
-    std::cerr << "SCORE: " << (int)std::round(1000000 * POINTS / MAX_POINTS) << std::endl;
+    // only ranks below 2N score any points
+    if (option("top-k", "0") == "auto")
+    {
+        cfg.rank_top_k(2 * N);
+    }
+    else
+    {
+        cfg.rank_top_k(std::stoul(option("top-k", "0")));
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+
+    ////////////////////////////////////////////////////////////////////////////
+    TripSafetyFactors worker(cfg, model_cfg);
+    std::vector<int> prediction = worker.predict(data, train_rows, test_rows);
+    ////////////////////////////////////////////////////////////////////////////
+
+    const double fit_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const int SCORE = tco_score(prediction, test_labels);
+
+    std::cerr << "SCORE: " << SCORE << std::endl;
+
+    if (cfg.fit() == LogRegCfg::Fit::Downsampled)
+    {
+        // impact of downsampling, against the same fit on all negatives
+        LogRegCfg full_cfg(cfg);
+        full_cfg.fit(LogRegCfg::Fit::CG).verbose(false).model_path("");
+
+        const auto t1 = std::chrono::steady_clock::now();
+        const std::vector<int> full_prediction = TripSafetyFactors(full_cfg, model_cfg).predict(data, train_rows, test_rows);
+        const double full_fit_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+        const int FULL_SCORE = tco_score(full_prediction, test_labels);
+
+        std::cerr << "negative rate: " << cfg.negative_rate()
+            << ", SCORE: " << SCORE << " vs " << FULL_SCORE << " on all rows (" << std::showpos << SCORE - FULL_SCORE << std::noshowpos
+            << "), time [s]: " << fit_time << " vs " << full_fit_time << std::endl;
+    }
 
     return 0;
 }
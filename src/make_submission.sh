@@ -1,5 +1,5 @@
 #!/bin/sh
 
-cat num.hpp sigmoid.hpp fmincg.hpp array2d.hpp logreg.hpp TripSafetyFactors.hpp | grep -v "#include \"" > submission.cpp
+cat num.hpp sigmoid.hpp fmincg.hpp array2d.hpp array2d_fixed.hpp minibatch.hpp dedup.hpp weights.hpp compact.hpp coordinate_descent.hpp csr.hpp logreg.hpp logreg_mp.hpp thread_pool.hpp bagging.hpp gbdt.hpp model.hpp incremental.hpp ingest.hpp scorer.hpp rank.hpp TripSafetyFactors.hpp | grep -v "#include \"" > submission.cpp
 g++ -std=c++11 -c submission.cpp
 gvim submission.cpp &
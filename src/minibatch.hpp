@@ -0,0 +1,337 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: minibatch.hpp
+ *
+ * Description:
+ *      Row sources and configuration for mini-batch solvers
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef MINIBATCH_HPP_
+#define MINIBATCH_HPP_
+
+#include "array2d.hpp"
+
+#include <valarray>
+#include <vector>
+#include <string>
+#include <istream>
+#include <functional>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cassert>
+
+namespace num
+{
+
+template<typename _ValueType = double>
+struct MiniBatchCfg
+{
+    enum class Schedule
+    {
+        Constant,       // lr
+        InverseTime,    // lr / (1 + decay * step)
+        Step            // lr * decay ^ epoch
+    };
+
+    MiniBatchCfg()
+    :
+        m_batch_size{256},
+        m_epochs{4},
+        m_learning_rate{0.05},
+        m_schedule{Schedule::InverseTime},
+        m_decay{1e-3},
+        m_seed{1},
+        m_beta1{0.9},
+        m_beta2{0.999},
+        m_epsilon{1e-8}
+    {}
+
+    size_type batch_size(void) const
+    {
+        return m_batch_size;
+    }
+
+    MiniBatchCfg & batch_size(size_type _batch_size)
+    {
+        m_batch_size = _batch_size;
+        return *this;
+    }
+
+    size_type epochs(void) const
+    {
+        return m_epochs;
+    }
+
+    MiniBatchCfg & epochs(size_type _epochs)
+    {
+        m_epochs = _epochs;
+        return *this;
+    }
+
+    _ValueType learning_rate(void) const
+    {
+        return m_learning_rate;
+    }
+
+    MiniBatchCfg & learning_rate(_ValueType _learning_rate)
+    {
+        m_learning_rate = _learning_rate;
+        return *this;
+    }
+
+    Schedule schedule(void) const
+    {
+        return m_schedule;
+    }
+
+    MiniBatchCfg & schedule(Schedule _schedule)
+    {
+        m_schedule = _schedule;
+        return *this;
+    }
+
+    _ValueType decay(void) const
+    {
+        return m_decay;
+    }
+
+    MiniBatchCfg & decay(_ValueType _decay)
+    {
+        m_decay = _decay;
+        return *this;
+    }
+
+    unsigned int seed(void) const
+    {
+        return m_seed;
+    }
+
+    MiniBatchCfg & seed(unsigned int _seed)
+    {
+        m_seed = _seed;
+        return *this;
+    }
+
+    _ValueType step_size(size_type step, size_type epoch) const
+    {
+        switch (m_schedule)
+        {
+        case Schedule::InverseTime:
+            return m_learning_rate / (1.0 + m_decay * step);
+        case Schedule::Step:
+            return m_learning_rate * std::pow(m_decay, (_ValueType)epoch);
+        case Schedule::Constant:
+        default:
+            return m_learning_rate;
+        }
+    }
+
+    size_type m_batch_size;
+    size_type m_epochs;
+    _ValueType m_learning_rate;
+    Schedule m_schedule;
+    _ValueType m_decay;
+    unsigned int m_seed;
+    _ValueType m_beta1;
+    _ValueType m_beta2;
+    _ValueType m_epsilon;
+};
+
+/*
+ * Row sources hand out blocks of rows. Required interface:
+ *
+ *      size_type ncols(void) const;
+ *      void rewind(unsigned int seed);
+ *      size_type next(array2d<T> & X_block, std::valarray<T> & y_block);
+ *
+ * rewind starts a new epoch, next fills up to X_block.shape().first rows
+ * and returns how many it filled, 0 at the end of an epoch.
+ */
+
+/*
+ * In-memory source, visits rows of X in an order reshuffled every epoch.
+ */
+template<typename _ValueType>
+class ArrayRowSource
+{
+public:
+    typedef _ValueType value_type;
+    typedef array2d<value_type> array_type;
+    typedef std::valarray<value_type> vector_type;
+
+    ArrayRowSource(const array_type & X, const vector_type & y)
+    :
+        m_X(X),
+        m_y(y),
+        m_order(X.shape().first),
+        m_pos{0}
+    {
+        assert(X.shape().first == y.size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+    }
+
+    size_type ncols(void) const
+    {
+        return m_X.shape().second;
+    }
+
+    void rewind(unsigned int seed)
+    {
+        std::mt19937 g(seed);
+        std::shuffle(m_order.begin(), m_order.end(), g);
+        m_pos = 0;
+    }
+
+    size_type next(array_type & X_block, vector_type & y_block)
+    {
+        const size_type nrows = std::min(X_block.shape().first, m_order.size() - m_pos);
+
+        for (size_type r{0}; r < nrows; ++r)
+        {
+            const size_type src = m_order[m_pos + r];
+            X_block[X_block.row(r)] = m_X[m_X.row(src)];
+            y_block[r] = m_y[src];
+        }
+        m_pos += nrows;
+
+        return nrows;
+    }
+
+private:
+    const array_type & m_X;
+    const vector_type & m_y;
+    std::vector<size_type> m_order;
+    size_type m_pos;
+};
+
+/*
+ * Streaming source, reads one record per line and converts it through
+ * a user supplied parser into a feature row and a label. A stream cannot
+ * be shuffled globally, so rows pass through a shuffle buffer of the given
+ * capacity, from which they are drawn at random.
+ */
+template<typename _ValueType>
+class StreamRowSource
+{
+public:
+    typedef _ValueType value_type;
+    typedef array2d<value_type> array_type;
+    typedef std::valarray<value_type> vector_type;
+    /// returns false for lines which are to be skipped
+    typedef std::function<bool (const std::string & line, value_type * row, value_type & label)> parser_type;
+
+    StreamRowSource(
+        std::istream & is,
+        size_type ncols,
+        parser_type && parser,
+        size_type shuffle_capacity = 1 << 16
+    )
+    :
+        m_is(is),
+        m_ncols{ncols},
+        m_parser(std::move(parser)),
+        m_capacity{std::max<size_type>(shuffle_capacity, 1)},
+        m_rows(),
+        m_labels(),
+        m_gen()
+    {
+        m_rows.reserve(m_capacity * m_ncols);
+        m_labels.reserve(m_capacity);
+    }
+
+    size_type ncols(void) const
+    {
+        return m_ncols;
+    }
+
+    void rewind(unsigned int seed)
+    {
+        m_is.clear();
+        m_is.seekg(0);
+        m_rows.clear();
+        m_labels.clear();
+        m_gen.seed(seed);
+    }
+
+    size_type next(array_type & X_block, vector_type & y_block)
+    {
+        assert(X_block.shape().second == m_ncols);
+
+        vector_type row(m_ncols);
+        size_type nrows{0};
+
+        while (nrows < X_block.shape().first)
+        {
+            fill();
+            if (m_labels.empty())
+            {
+                break;
+            }
+
+            // draw a random buffered row and plug the hole with the last one
+            const size_type pick = std::uniform_int_distribution<size_type>(0, m_labels.size() - 1)(m_gen);
+            std::copy(m_rows.cbegin() + pick * m_ncols, m_rows.cbegin() + (pick + 1) * m_ncols, std::begin(row));
+            X_block[X_block.row(nrows)] = row;
+            y_block[nrows] = m_labels[pick];
+            ++nrows;
+
+            std::copy(m_rows.cend() - m_ncols, m_rows.cend(), m_rows.begin() + pick * m_ncols);
+            m_rows.resize(m_rows.size() - m_ncols);
+            m_labels[pick] = m_labels.back();
+            m_labels.pop_back();
+        }
+
+        return nrows;
+    }
+
+private:
+    void fill(void)
+    {
+        std::string line;
+
+        while (m_labels.size() < m_capacity && std::getline(m_is, line))
+        {
+            const size_type at = m_rows.size();
+            value_type label;
+
+            m_rows.resize(at + m_ncols);
+            if (m_parser(line, &m_rows[at], label))
+            {
+                m_labels.push_back(label);
+            }
+            else
+            {
+                m_rows.resize(at);
+            }
+        }
+    }
+
+    std::istream & m_is;
+    const size_type m_ncols;
+    const parser_type m_parser;
+    const size_type m_capacity;
+    std::vector<value_type> m_rows;
+    std::vector<value_type> m_labels;
+    std::mt19937 m_gen;
+};
+
+}  // namespace num
+
+#endif /* MINIBATCH_HPP_ */
@@ -0,0 +1,532 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: model.hpp
+ *
+ * Description:
+ *      Persisted fitted model: event density tables, standardization
+ *      and logistic regression coefficients
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef MODEL_HPP_
+#define MODEL_HPP_
+
+#include "array2d.hpp"
+#include "num.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <valarray>
+#include <vector>
+#include <stdexcept>
+#include <system_error>
+
+namespace num
+{
+
+/*
+ * Binary layout, a sequence of 8-byte words in native byte order, so that
+ * a mapped file can be used in place:
+ *
+ *      "TSFMODEL"
+ *      version, ncols, ntables, nrows
+ *      theta[ncols], mu[ncols], dev[ncols]
+ *      ntables x { column, nentries, keys[nentries], values[nentries],
+ *                  occurrences[nentries], events[nentries] }
+ *
+ * Column 0 is the intercept. Keys of a density table are sorted ascending,
+ * values are events / occurrences. nrows, occurrences and events are the
+ * statistics the model was fitted with, they let it be updated from new
+ * rows only, see IncrementalModel.
+ *
+ * Version 1 files lack nrows, occurrences and events, they can be scored
+ * but not updated.
+ */
+constexpr char MODEL_MAGIC[8] = {'T', 'S', 'F', 'M', 'O', 'D', 'E', 'L'};
+constexpr std::uint64_t MODEL_VERSION = 2;
+
+/// key -> (occurrences, sum of events)
+typedef std::map<double, std::pair<double, double>> event_counts_type;
+typedef std::vector<std::pair<size_type, event_counts_type>> density_counts_type;
+
+inline
+std::vector<std::uint64_t>
+serialize_model(
+    const std::valarray<double> & theta,
+    const std::valarray<double> & mu,
+    const std::valarray<double> & dev,
+    const density_counts_type & tables,
+    size_type nrows
+)
+{
+    assert(theta.size() == mu.size() && theta.size() == dev.size());
+
+    std::vector<std::uint64_t> words;
+
+    auto push_real = [&words](double v)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, &v, sizeof (w));
+        words.push_back(w);
+    };
+
+    words.push_back(0);
+    std::memcpy(&words.back(), MODEL_MAGIC, sizeof (MODEL_MAGIC));
+    words.push_back(MODEL_VERSION);
+    words.push_back(theta.size());
+    words.push_back(tables.size());
+    words.push_back(nrows);
+
+    for (auto v : theta)
+    {
+        push_real(v);
+    }
+    for (auto v : mu)
+    {
+        push_real(v);
+    }
+    for (auto v : dev)
+    {
+        push_real(v);
+    }
+
+    for (const auto & table : tables)
+    {
+        words.push_back(table.first);
+        words.push_back(table.second.size());
+        for (const auto & kv : table.second)
+        {
+            push_real(kv.first);
+        }
+        for (const auto & kv : table.second)
+        {
+            push_real(kv.second.second / kv.second.first);
+        }
+        for (const auto & kv : table.second)
+        {
+            push_real(kv.second.first);
+        }
+        for (const auto & kv : table.second)
+        {
+            push_real(kv.second.second);
+        }
+    }
+
+    return words;
+}
+
+/*
+ * Publishes the model atomically: it is written and synced to a temporary
+ * file next to path, which is then renamed over path. Readers see either
+ * the previous model or the new one, never a partial file, and those
+ * still mapping the previous one keep it until they unmap.
+ */
+inline
+void
+save_model(const std::string & path, const std::vector<std::uint64_t> & words)
+{
+    const std::string tmp_path = path + ".tmp." + std::to_string(::getpid());
+
+    const int fd = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::system_category(), tmp_path);
+    }
+
+    const char * data = reinterpret_cast<const char *>(words.data());
+    size_type left = words.size() * sizeof (std::uint64_t);
+
+    while (left)
+    {
+        const ssize_t written = ::write(fd, data, left);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written < 0)
+        {
+            const int err = errno;
+            ::close(fd);
+            ::unlink(tmp_path.c_str());
+            throw std::system_error(err, std::system_category(), tmp_path);
+        }
+        data += written;
+        left -= written;
+    }
+
+    if (::fsync(fd) != 0 || ::close(fd) != 0)
+    {
+        const int err = errno;
+        ::unlink(tmp_path.c_str());
+        throw std::system_error(err, std::system_category(), tmp_path);
+    }
+
+    if (::rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        const int err = errno;
+        ::unlink(tmp_path.c_str());
+        throw std::system_error(err, std::system_category(), path);
+    }
+}
+
+/*
+ * Read-only view over a serialized model. Does not copy anything, the
+ * underlying memory has to outlive the view.
+ */
+class ModelView
+{
+public:
+    typedef double value_type;
+
+    struct Table
+    {
+        size_type column;
+        size_type size;
+        const value_type * keys;
+        const value_type * values;
+        /// nullptr for version 1 models
+        const value_type * occurrences;
+        const value_type * events;
+
+        /// event density for a key, 0 for keys not seen during training
+        value_type lookup(value_type key) const
+        {
+            const value_type * it = std::lower_bound(keys, keys + size, key);
+            return (it != keys + size && *it == key) ? values[it - keys] : 0.0;
+        }
+    };
+
+    ModelView(const void * data, size_type nbytes);
+
+    size_type ncols(void) const
+    {
+        return m_ncols;
+    }
+
+    std::uint64_t version(void) const
+    {
+        return m_version;
+    }
+
+    /// number of training rows, 0 for version 1 models
+    size_type nrows(void) const
+    {
+        return m_nrows;
+    }
+
+    const value_type * theta(void) const
+    {
+        return m_theta;
+    }
+
+    const value_type * mu(void) const
+    {
+        return m_mu;
+    }
+
+    const value_type * dev(void) const
+    {
+        return m_dev;
+    }
+
+    const std::vector<Table> & tables(void) const
+    {
+        return m_tables;
+    }
+
+    /// X has the intercept in column 0 and raw features in the remaining ones
+    void encode(array2d<value_type> & X) const;
+
+    /// same as encode, for a single row of ncols() values
+    void encode_row(value_type * row) const;
+
+    /// serialized copy of the model with coefficients theta
+    std::vector<std::uint64_t> with_theta(const std::valarray<value_type> & theta) const;
+
+    std::valarray<value_type> margins(const array2d<value_type> & X) const;
+
+private:
+    const std::uint64_t * m_words;
+    size_type m_nwords;
+    std::uint64_t m_version;
+    size_type m_ncols;
+    size_type m_nrows;
+    const value_type * m_theta;
+    const value_type * m_mu;
+    const value_type * m_dev;
+    std::vector<Table> m_tables;
+};
+
+inline
+ModelView::ModelView(const void * data, size_type nbytes)
+:
+    m_words{static_cast<const std::uint64_t *>(data)},
+    m_nwords{0},
+    m_version{0},
+    m_ncols{0},
+    m_nrows{0},
+    m_theta{nullptr},
+    m_mu{nullptr},
+    m_dev{nullptr},
+    m_tables{}
+{
+    static_assert(sizeof (value_type) == sizeof (std::uint64_t), "8-byte reals expected");
+
+    const std::uint64_t * words = static_cast<const std::uint64_t *>(data);
+    const size_type nwords = nbytes / sizeof (std::uint64_t);
+
+    if (nwords < 4 || std::memcmp(words, MODEL_MAGIC, sizeof (MODEL_MAGIC)) != 0)
+    {
+        throw std::runtime_error("not a model file");
+    }
+    if (words[1] != 1 && words[1] != MODEL_VERSION)
+    {
+        throw std::runtime_error("unsupported model version " + std::to_string(words[1]));
+    }
+
+    m_version = words[1];
+    m_ncols = words[2];
+    const size_type ntables = words[3];
+
+    size_type at = 4;
+    if (m_version >= 2)
+    {
+        if (nwords < 5)
+        {
+            throw std::runtime_error("truncated model file");
+        }
+        m_nrows = words[at++];
+    }
+
+    // at never exceeds nwords, so nwords - at cannot wrap around, unlike
+    // at + count for a count read from a corrupted file
+    auto reals = [&](size_type count) -> const value_type *
+    {
+        if (count > nwords - at)
+        {
+            throw std::runtime_error("truncated model file");
+        }
+        const value_type * p = reinterpret_cast<const value_type *>(words + at);
+        at += count;
+        return p;
+    };
+
+    m_theta = reals(m_ncols);
+    m_mu = reals(m_ncols);
+    m_dev = reals(m_ncols);
+
+    for (size_type t{0}; t < ntables; ++t)
+    {
+        if (nwords - at < 2)
+        {
+            throw std::runtime_error("truncated model file");
+        }
+
+        Table table;
+        table.column = words[at++];
+        table.size = words[at++];
+        table.keys = reals(table.size);
+        table.values = reals(table.size);
+        table.occurrences = m_version >= 2 ? reals(table.size) : nullptr;
+        table.events = m_version >= 2 ? reals(table.size) : nullptr;
+
+        if (table.column >= m_ncols)
+        {
+            throw std::runtime_error("density table column out of range");
+        }
+
+        m_tables.push_back(table);
+    }
+
+    m_nwords = at;
+}
+
+inline
+void
+ModelView::encode(array2d<value_type> & X) const
+{
+    assert(X.shape().second == m_ncols);
+
+    for (const auto & table : m_tables)
+    {
+        std::valarray<value_type> col = X[X.column(table.column)];
+        for (auto & x : col)
+        {
+            x = table.lookup(x);
+        }
+        X[X.column(table.column)] = col;
+    }
+
+    for (size_type c{1}; c < m_ncols; ++c)
+    {
+        const std::valarray<value_type> & col = X[X.column(c)];
+        X[X.column(c)] = (col - m_mu[c]) / m_dev[c];
+    }
+}
+
+inline
+void
+ModelView::encode_row(value_type * row) const
+{
+    for (const auto & table : m_tables)
+    {
+        row[table.column] = table.lookup(row[table.column]);
+    }
+
+    for (size_type c{1}; c < m_ncols; ++c)
+    {
+        row[c] = (row[c] - m_mu[c]) / m_dev[c];
+    }
+}
+
+inline
+std::vector<std::uint64_t>
+ModelView::with_theta(const std::valarray<value_type> & theta) const
+{
+    assert(theta.size() == m_ncols);
+
+    std::vector<std::uint64_t> words(m_words, m_words + m_nwords);
+    const size_type at = reinterpret_cast<const std::uint64_t *>(m_theta) - m_words;
+
+    std::memcpy(&words[at], &theta[0], m_ncols * sizeof (value_type));
+
+    return words;
+}
+
+inline
+std::valarray<double>
+ModelView::margins(const array2d<value_type> & X) const
+{
+    assert(X.shape().second == m_ncols);
+
+    const std::valarray<value_type> theta(m_theta, m_ncols);
+    std::valarray<value_type> H(X.shape().first);
+
+    for (size_type r{0}; r < X.shape().first; ++r)
+    {
+        H[r] = (X[X.row(r)] * theta).sum();
+    }
+
+    return H;
+}
+
+/*
+ * File mapped read-only into memory.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string & path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    const void * data(void) const
+    {
+        return m_addr;
+    }
+
+    size_type size(void) const
+    {
+        return m_size;
+    }
+
+private:
+    void * m_addr;
+    size_type m_size;
+};
+
+inline
+MappedFile::MappedFile(const std::string & path)
+:
+    m_addr{nullptr},
+    m_size{0}
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::system_category(), path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        const int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::system_category(), path);
+    }
+    if (st.st_size == 0)
+    {
+        ::close(fd);
+        throw std::runtime_error(path + " is empty");
+    }
+
+    void * addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int err = errno;
+    ::close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        throw std::system_error(err, std::system_category(), path);
+    }
+
+    m_addr = addr;
+    m_size = st.st_size;
+}
+
+inline
+MappedFile::~MappedFile()
+{
+    ::munmap(m_addr, m_size);
+}
+
+/*
+ * Model file mapped into memory and used in place.
+ */
+class MappedModel
+{
+public:
+    explicit MappedModel(const std::string & path)
+    :
+        m_file(path),
+        m_view(m_file.data(), m_file.size())
+    {}
+
+    const ModelView & view(void) const
+    {
+        return m_view;
+    }
+
+private:
+    const MappedFile m_file;
+    const ModelView m_view;
+};
+
+}  // namespace num
+
+#endif /* MODEL_HPP_ */
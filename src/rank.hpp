@@ -0,0 +1,282 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: rank.hpp
+ *
+ * Description:
+ *      Ranking of scores: radix argsort, top-K selection
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef RANK_HPP_
+#define RANK_HPP_
+
+#include "num.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <cassert>
+
+namespace num
+{
+
+template<typename _ValueType>
+struct radix_key;
+
+template<>
+struct radix_key<float>
+{
+    typedef std::uint32_t type;
+};
+
+template<>
+struct radix_key<double>
+{
+    typedef std::uint64_t type;
+};
+
+/*
+ * Maps a floating point value onto an unsigned key, such that ascending
+ * key order is descending value order: positive values get their sign
+ * bit set, negative ones are bit-inverted, then everything is inverted.
+ * -0 is folded onto +0, so that equal values get equal keys.
+ */
+template<typename _ValueType>
+inline
+typename radix_key<_ValueType>::type
+descending_key(_ValueType v)
+{
+    typedef typename radix_key<_ValueType>::type key_type;
+    constexpr key_type SIGN = key_type{1} << (8 * sizeof (key_type) - 1);
+
+    key_type bits;
+    std::memcpy(&bits, &v, sizeof (bits));
+
+    // on the bits, -ffast-math lets the compiler drop a (v == 0) ? 0 : v
+    bits = (bits & ~SIGN) ? bits : 0;
+
+    bits = (bits & SIGN) ? ~bits : (bits | SIGN);
+
+    return ~bits;
+}
+
+namespace detail
+{
+
+constexpr size_type RADIX_BITS = 11;
+constexpr size_type RADIX_SIZE = 1 << RADIX_BITS;
+
+/*
+ * Stable LSD radix sort of (key, index) pairs, 11 bits per pass; passes
+ * in which all keys share the digit are skipped. With nthreads > 1 every
+ * pass builds per-chunk histograms and scatters chunks concurrently,
+ * chunk order keeps the sort stable.
+ */
+template<typename _KeyType, typename _IndexType>
+void
+radix_sort_pairs(
+    std::vector<_KeyType> & keys,
+    std::vector<_IndexType> & index,
+    size_type nthreads)
+{
+    typedef _KeyType key_type;
+    typedef _IndexType index_type;
+    typedef std::array<size_type, RADIX_SIZE> histogram_type;
+
+    const size_type N = keys.size();
+    const size_type NPASSES = (sizeof (key_type) * 8 + RADIX_BITS - 1) / RADIX_BITS;
+    const size_type NCHUNKS = std::max<size_type>(1, std::min(nthreads, N / RADIX_SIZE));
+
+    std::vector<key_type> keys_tmp(N);
+    std::vector<index_type> index_tmp(N);
+
+    auto chunk_begin = [N, NCHUNKS](size_type chunk)
+    {
+        return N * chunk / NCHUNKS;
+    };
+
+    auto in_parallel = [NCHUNKS](const std::function<void (size_type)> & fn)
+    {
+        std::vector<std::thread> threads;
+        for (size_type chunk{1}; chunk < NCHUNKS; ++chunk)
+        {
+            threads.emplace_back(fn, chunk);
+        }
+        fn(0);
+        for (auto & thread : threads)
+        {
+            thread.join();
+        }
+    };
+
+    std::vector<histogram_type> histograms(NCHUNKS);
+
+    for (size_type pass{0}; pass < NPASSES; ++pass)
+    {
+        const size_type shift = pass * RADIX_BITS;
+
+        in_parallel(
+            [&](size_type chunk)
+            {
+                histogram_type & hist = histograms[chunk];
+                hist.fill(0);
+                for (size_type i{chunk_begin(chunk)}; i < chunk_begin(chunk + 1); ++i)
+                {
+                    ++hist[(keys[i] >> shift) & (RADIX_SIZE - 1)];
+                }
+            }
+        );
+
+        // all keys share this digit, nothing to do
+        {
+            const key_type digit = N ? (keys[0] >> shift) & (RADIX_SIZE - 1) : 0;
+            size_type count{0};
+            for (const auto & hist : histograms)
+            {
+                count += hist[digit];
+            }
+            if (count == N)
+            {
+                continue;
+            }
+        }
+
+        // exclusive prefix, digit-major then chunk-major
+        size_type offset{0};
+        for (size_type digit{0}; digit < RADIX_SIZE; ++digit)
+        {
+            for (auto & hist : histograms)
+            {
+                const size_type count = hist[digit];
+                hist[digit] = offset;
+                offset += count;
+            }
+        }
+
+        in_parallel(
+            [&](size_type chunk)
+            {
+                histogram_type & pos = histograms[chunk];
+                for (size_type i{chunk_begin(chunk)}; i < chunk_begin(chunk + 1); ++i)
+                {
+                    const size_type dst = pos[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+                    keys_tmp[dst] = keys[i];
+                    index_tmp[dst] = index[i];
+                }
+            }
+        );
+
+        keys.swap(keys_tmp);
+        index.swap(index_tmp);
+    }
+}
+
+/// ranks are int, so row indices fit 32 bits
+template<typename _ValueType>
+std::vector<int>
+ranks_radix(const _ValueType * scores, size_type n, size_type nthreads)
+{
+    typedef typename radix_key<_ValueType>::type key_type;
+
+    std::vector<key_type> keys(n);
+    std::vector<std::uint32_t> index(n);
+
+    for (size_type i{0}; i < n; ++i)
+    {
+        keys[i] = descending_key(scores[i]);
+        index[i] = i;
+    }
+
+    radix_sort_pairs(keys, index, nthreads);
+
+    std::vector<int> ranks(n);
+    for (size_type pos{0}; pos < n; ++pos)
+    {
+        ranks[index[pos]] = pos + 1;
+    }
+
+    return ranks;
+}
+
+}  // namespace detail
+
+/*
+ * 1-based ranks of scores, highest score gets rank 1, ties are ranked in
+ * index order. A single argsort by radix on the bit patterns of scores.
+ */
+template<typename _ValueType>
+std::vector<int>
+ranks_descending(const _ValueType * scores, size_type n, size_type nthreads = 1)
+{
+    static_assert(std::is_floating_point<_ValueType>::value, "floating point scores expected");
+    assert(n <= (size_type)std::numeric_limits<int>::max());
+
+    return detail::ranks_radix(scores, n, nthreads);
+}
+
+/*
+ * Only the k highest scores are ranked exactly (1...k), by partial
+ * selection and a sort of the selected part. The remaining rows get ranks
+ * k + 1, ..., n in index order.
+ */
+template<typename _ValueType>
+std::vector<int>
+ranks_descending_top_k(const _ValueType * scores, size_type n, size_type k)
+{
+    assert(n <= (size_type)std::numeric_limits<int>::max());
+
+    k = std::min(k, n);
+
+    std::vector<std::uint32_t> index(n);
+    std::iota(index.begin(), index.end(), 0);
+
+    auto greater = [scores](std::uint32_t p, std::uint32_t q)
+    {
+        return scores[p] > scores[q] || (scores[p] == scores[q] && p < q);
+    };
+
+    std::nth_element(index.begin(), index.begin() + k, index.end(), greater);
+    std::sort(index.begin(), index.begin() + k, greater);
+
+    std::vector<int> ranks(n, 0);
+    for (size_type pos{0}; pos < k; ++pos)
+    {
+        ranks[index[pos]] = pos + 1;
+    }
+
+    int next = k + 1;
+    for (auto & rank : ranks)
+    {
+        if (rank == 0)
+        {
+            rank = next++;
+        }
+    }
+
+    return ranks;
+}
+
+}  // namespace num
+
+#endif /* RANK_HPP_ */
@@ -0,0 +1,270 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: scorer.hpp
+ *
+ * Description:
+ *      Batch scoring engine over a fitted model
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef SCORER_HPP_
+#define SCORER_HPP_
+
+#include "model.hpp"
+#include "sigmoid.hpp"
+#include "num.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Scores batches of raw feature rows (model column order without the
+ * intercept, row-major, contiguous) against a ModelView.
+ *
+ * Standardization is folded into the coefficients:
+ *      theta' * x_std = (theta_0 - sum_c theta_c * mu_c / dev_c) + sum_c (theta_c / dev_c) * x_c
+ * so a batch is one gemv plus density table lookups for the encoded
+ * columns. Tables with small integer keys (ids, months, counts) are
+ * expanded into directly indexed arrays of weighted densities, others are
+ * binary searched. Margins are enough for ranking, sigmoid being monotonic;
+ * probabilities are computed only on request. Sparse (L1 fitted) models
+ * are scored over the features with nonzero weights only.
+ *
+ * The scorer keeps pointers to density tables of the model, so the
+ * model memory has to outlive it. Scoring does not allocate and is safe
+ * to call concurrently.
+ */
+class BatchScorer
+{
+public:
+    typedef double value_type;
+
+    explicit BatchScorer(const ModelView & model);
+
+    size_type nfeatures(void) const
+    {
+        return m_weights.size();
+    }
+
+    void margins(const value_type * rows, size_type nrows, value_type * out) const;
+
+    void probabilities(const value_type * rows, size_type nrows, value_type * out) const;
+
+private:
+    struct Lookup
+    {
+        size_type feature;
+        value_type weight;
+        ModelView::Table table;
+        /// weight * density for integer keys base, base + 1, ...; empty if keys do not qualify
+        long base;
+        std::vector<value_type> direct;
+
+        value_type operator()(value_type key) const;
+    };
+
+    /// direct tables are allowed to be this many times larger than the number of keys
+    static constexpr size_type DIRECT_SPARSITY = 8;
+
+    /// features with nonzero weights are gathered when fewer than 1 / SUPPORT_DENSITY of all
+    static constexpr size_type SUPPORT_DENSITY = 2;
+
+    value_type m_bias;
+    /// folded coefficients, 0 for density encoded features
+    std::vector<value_type> m_weights;
+    /// features with nonzero weights, empty if the dense gemv is cheaper
+    std::vector<size_type> m_support;
+    std::vector<Lookup> m_lookups;
+};
+
+inline
+BatchScorer::BatchScorer(const ModelView & model)
+:
+    m_bias{model.theta()[0]},
+    m_weights(model.ncols() - 1),
+    m_support{},
+    m_lookups{}
+{
+    const value_type * theta = model.theta();
+    const value_type * mu = model.mu();
+    const value_type * dev = model.dev();
+
+    for (size_type c{1}; c < model.ncols(); ++c)
+    {
+        m_weights[c - 1] = theta[c] / dev[c];
+        m_bias -= theta[c] * mu[c] / dev[c];
+    }
+
+    for (const auto & table : model.tables())
+    {
+        assert(table.column > 0);
+
+        const size_type feature = table.column - 1;
+
+        Lookup lookup{feature, m_weights[feature], table, 0, {}};
+        m_weights[feature] = 0.0;
+
+        const bool integral = std::all_of(table.keys, table.keys + table.size,
+            [](value_type key)
+            {
+                return key == std::floor(key) && std::fabs(key) < (1L << 30);
+            }
+        );
+        if (integral && table.size)
+        {
+            const long lo = table.keys[0];
+            const long hi = table.keys[table.size - 1];
+
+            if ((size_type)(hi - lo) < DIRECT_SPARSITY * table.size)
+            {
+                lookup.base = lo;
+                lookup.direct.assign(hi - lo + 1, 0.0);
+                for (size_type k{0}; k < table.size; ++k)
+                {
+                    lookup.direct[(long)table.keys[k] - lo] = lookup.weight * table.values[k];
+                }
+            }
+        }
+
+        m_lookups.push_back(std::move(lookup));
+    }
+
+    for (size_type feature{0}; feature < m_weights.size(); ++feature)
+    {
+        if (m_weights[feature] != 0.0)
+        {
+            m_support.push_back(feature);
+        }
+    }
+    if (m_support.size() * SUPPORT_DENSITY >= m_weights.size())
+    {
+        m_support.clear();
+    }
+}
+
+inline
+BatchScorer::value_type
+BatchScorer::Lookup::operator()(value_type key) const
+{
+    if (!direct.empty())
+    {
+        const value_type offset = key - base;
+
+        // anything not landing on an integer slot has not been seen in training
+        if (offset >= 0 && offset < direct.size() && offset == (long)offset)
+        {
+            return direct[(size_type)offset];
+        }
+        return 0.0;
+    }
+
+    return weight * table.lookup(key);
+}
+
+inline
+void
+BatchScorer::margins(const value_type * rows, size_type nrows, value_type * out) const
+{
+    const size_type NFEAT = m_weights.size();
+    const value_type * w = m_weights.data();
+
+    size_type r{0};
+
+    if (!m_support.empty())
+    {
+        for (; r < nrows; ++r)
+        {
+            const value_type * x = rows + r * NFEAT;
+            value_type a{m_bias};
+
+            for (const size_type feature : m_support)
+            {
+                a += x[feature] * w[feature];
+            }
+            out[r] = a;
+        }
+    }
+
+    // gemv, four rows at a time to keep independent accumulators busy
+    for (; r + 4 <= nrows; r += 4)
+    {
+        const value_type * x0 = rows + r * NFEAT;
+        const value_type * x1 = x0 + NFEAT;
+        const value_type * x2 = x1 + NFEAT;
+        const value_type * x3 = x2 + NFEAT;
+
+        value_type a0{m_bias};
+        value_type a1{m_bias};
+        value_type a2{m_bias};
+        value_type a3{m_bias};
+
+        for (size_type c{0}; c < NFEAT; ++c)
+        {
+            a0 += x0[c] * w[c];
+            a1 += x1[c] * w[c];
+            a2 += x2[c] * w[c];
+            a3 += x3[c] * w[c];
+        }
+
+        out[r] = a0;
+        out[r + 1] = a1;
+        out[r + 2] = a2;
+        out[r + 3] = a3;
+    }
+    for (; r < nrows; ++r)
+    {
+        const value_type * x = rows + r * NFEAT;
+        value_type a{m_bias};
+
+        for (size_type c{0}; c < NFEAT; ++c)
+        {
+            a += x[c] * w[c];
+        }
+        out[r] = a;
+    }
+
+    for (const auto & lookup : m_lookups)
+    {
+        const value_type * x = rows + lookup.feature;
+
+        for (r = 0; r < nrows; ++r, x += NFEAT)
+        {
+            out[r] += lookup(*x);
+        }
+    }
+}
+
+inline
+void
+BatchScorer::probabilities(const value_type * rows, size_type nrows, value_type * out) const
+{
+    margins(rows, nrows, out);
+
+    for (size_type r{0}; r < nrows; ++r)
+    {
+        out[r] = sigmoid(out[r]);
+    }
+}
+
+}  // namespace num
+
+#endif /* SCORER_HPP_ */
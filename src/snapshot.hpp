@@ -0,0 +1,218 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: snapshot.hpp
+ *
+ * Description:
+ *      Immutable model snapshots shared by scoring threads, atomic swap
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef SNAPSHOT_HPP_
+#define SNAPSHOT_HPP_
+
+#include "model.hpp"
+#include "scorer.hpp"
+#include "num.hpp"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+namespace num
+{
+
+/*
+ * Everything needed to score raw rows: the serialized model (theta,
+ * density tables, mu and dev) and a BatchScorer over it, with the
+ * encoders and the scaler folded in. Nothing changes after construction
+ * and scoring writes into caller's memory only, so any number of threads
+ * can score against one snapshot at once.
+ */
+class ModelSnapshot
+{
+public:
+    typedef BatchScorer::value_type value_type;
+
+    /// takes a serialized model, see serialize_model
+    explicit ModelSnapshot(std::vector<std::uint64_t> && words, std::uint64_t generation = 0)
+    :
+        m_words(std::move(words)),
+        m_view(m_words.data(), m_words.size() * sizeof (std::uint64_t)),
+        m_scorer(m_view),
+        m_generation{generation}
+    {}
+
+    ModelSnapshot(const ModelSnapshot &) = delete;
+    ModelSnapshot & operator=(const ModelSnapshot &) = delete;
+
+    /// model file, copied into memory
+    static std::shared_ptr<const ModelSnapshot> load(const std::string & path, std::uint64_t generation = 0)
+    {
+        const MappedFile file(path);
+        const std::uint64_t * words = static_cast<const std::uint64_t *>(file.data());
+
+        return std::make_shared<const ModelSnapshot>(
+            std::vector<std::uint64_t>(words, words + file.size() / sizeof (std::uint64_t)), generation);
+    }
+
+    const ModelView & model(void) const
+    {
+        return m_view;
+    }
+
+    /// number of raw features of a row, intercept excluded
+    size_type nfeatures(void) const
+    {
+        return m_scorer.nfeatures();
+    }
+
+    /// distinguishes published snapshots, e.g. a version counter
+    std::uint64_t generation(void) const
+    {
+        return m_generation;
+    }
+
+    void margins(const value_type * rows, size_type nrows, value_type * out) const
+    {
+        m_scorer.margins(rows, nrows, out);
+    }
+
+    void probabilities(const value_type * rows, size_type nrows, value_type * out) const
+    {
+        m_scorer.probabilities(rows, nrows, out);
+    }
+
+private:
+    const std::vector<std::uint64_t> m_words;
+    const ModelView m_view;
+    const BatchScorer m_scorer;
+    const std::uint64_t m_generation;
+};
+
+/*
+ * The current snapshot of a service, read-copy-update style: publish()
+ * swaps in a new snapshot and bumps a generation counter, scoring threads
+ * keep using the snapshot they hold until they pick up the new one.
+ * The previous snapshot is freed by whichever thread drops the last
+ * reference to it.
+ *
+ * The pointer itself is guarded by a mutex, taken by publish(), get()
+ * and SnapshotReader refreshes. Scoring threads should go through a
+ * SnapshotReader, which takes it only once per published snapshot.
+ */
+class SnapshotHandle
+{
+public:
+    explicit SnapshotHandle(std::shared_ptr<const ModelSnapshot> snapshot = nullptr)
+    :
+        m_mutex{},
+        m_snapshot(std::move(snapshot)),
+        m_generation{0}
+    {}
+
+    SnapshotHandle(const SnapshotHandle &) = delete;
+    SnapshotHandle & operator=(const SnapshotHandle &) = delete;
+
+    std::shared_ptr<const ModelSnapshot> get(void) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_snapshot;
+    }
+
+    void publish(std::shared_ptr<const ModelSnapshot> snapshot)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_snapshot.swap(snapshot);
+            m_generation.fetch_add(1, std::memory_order_release);
+        }
+        // the previous snapshot, if this was the last reference, is
+        // freed here, outside the lock
+    }
+
+    /// number of publish() calls so far
+    std::uint64_t generation(void) const
+    {
+        return m_generation.load(std::memory_order_acquire);
+    }
+
+private:
+    friend class SnapshotReader;
+
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const ModelSnapshot> m_snapshot;
+    std::atomic<std::uint64_t> m_generation;
+};
+
+/*
+ * Per-thread view of a SnapshotHandle. get() compares the handle's
+ * generation with the one of the cached snapshot, a single atomic load,
+ * and returns the cached reference when nothing was published meanwhile:
+ * no lock and no reference count traffic shared with other readers. On a
+ * change it copies the new snapshot under the handle's mutex.
+ *
+ * One reader per thread; it keeps the snapshot it returned alive until
+ * the next get() that picks up a newer one.
+ */
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(const SnapshotHandle & handle)
+    :
+        m_handle(handle),
+        m_snapshot{},
+        m_generation{0}
+    {
+        refresh();
+    }
+
+    SnapshotReader(const SnapshotReader &) = delete;
+    SnapshotReader & operator=(const SnapshotReader &) = delete;
+
+    const std::shared_ptr<const ModelSnapshot> & get(void)
+    {
+        if (m_handle.generation() != m_generation)
+        {
+            refresh();
+        }
+        return m_snapshot;
+    }
+
+private:
+    void refresh(void)
+    {
+        std::shared_ptr<const ModelSnapshot> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(m_handle.m_mutex);
+            snapshot = m_handle.m_snapshot;
+            m_generation = m_handle.m_generation.load(std::memory_order_relaxed);
+        }
+        // the previously cached snapshot is released outside the lock
+        m_snapshot.swap(snapshot);
+    }
+
+    const SnapshotHandle & m_handle;
+    std::shared_ptr<const ModelSnapshot> m_snapshot;
+    std::uint64_t m_generation;
+};
+
+}  // namespace num
+
+#endif /* SNAPSHOT_HPP_ */
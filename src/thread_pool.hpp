@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: thread_pool.hpp
+ *
+ * Description:
+ *      Fixed size pool of worker threads
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef THREAD_POOL_HPP_
+#define THREAD_POOL_HPP_
+
+#include "num.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <vector>
+#include <type_traits>
+#include <algorithm>
+
+namespace num
+{
+
+/*
+ * Tasks are run in submission order by nthreads workers. Results and
+ * exceptions are handed back through futures. The destructor finishes
+ * all queued tasks before joining.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_type nthreads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    size_type size(void) const
+    {
+        return m_threads.size();
+    }
+
+    template<typename _Fn>
+    std::future<typename std::result_of<_Fn()>::type>
+    submit(_Fn && fn);
+
+private:
+    void work(void);
+
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void (void)>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop;
+};
+
+inline
+ThreadPool::ThreadPool(size_type nthreads)
+:
+    m_threads{},
+    m_tasks{},
+    m_mutex{},
+    m_cv{},
+    m_stop{false}
+{
+    nthreads = std::max<size_type>(nthreads, 1);
+
+    for (size_type i{0}; i < nthreads; ++i)
+    {
+        m_threads.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+inline
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    for (auto & thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+inline
+void
+ThreadPool::work(void)
+{
+    while (true)
+    {
+        std::function<void (void)> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+            if (m_tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+
+        task();
+    }
+}
+
+template<typename _Fn>
+std::future<typename std::result_of<_Fn()>::type>
+ThreadPool::submit(_Fn && fn)
+{
+    typedef typename std::result_of<_Fn()>::type result_type;
+
+    // std::function needs a copyable target
+    auto task = std::make_shared<std::packaged_task<result_type (void)>>(std::forward<_Fn>(fn));
+    std::future<result_type> result = task->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace([task]() { (*task)(); });
+    }
+    m_cv.notify_one();
+
+    return result;
+}
+
+}  // namespace num
+
+#endif /* THREAD_POOL_HPP_ */
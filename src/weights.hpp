@@ -0,0 +1,183 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: weights.hpp
+ *
+ * Description:
+ *      Compact per-row sample weights
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef WEIGHTS_HPP_
+#define WEIGHTS_HPP_
+
+#include "array2d.hpp"
+#include "dedup.hpp"
+#include "num.hpp"
+
+#include <valarray>
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <algorithm>
+#include <cassert>
+
+namespace num
+{
+
+/*
+ * Per-row weights stored as runs of equal values: a run is the end of
+ * its row range and the weight shared by those rows. Weights of
+ * collapsed repeats (rows ordered by their counts) or of a label-sorted
+ * downsample (1 for positives, then 1 / rate) take a handful of runs.
+ */
+template<typename _WeightType = float>
+class RunLengthWeights
+{
+public:
+    typedef _WeightType weight_type;
+
+    RunLengthWeights()
+    :
+        m_ends{},
+        m_weights{}
+    {}
+
+    /// weight of the next row
+    void push_back(weight_type w)
+    {
+        push_back(w, 1);
+    }
+
+    /// same weight for the next n rows
+    void push_back(weight_type w, size_type n)
+    {
+        if (n == 0)
+        {
+            return;
+        }
+        if (!m_weights.empty() && m_weights.back() == w)
+        {
+            m_ends.back() += n;
+        }
+        else
+        {
+            m_ends.push_back(size() + n);
+            m_weights.push_back(w);
+        }
+    }
+
+    /// number of rows
+    size_type size(void) const
+    {
+        return m_ends.empty() ? 0 : m_ends.back();
+    }
+
+    size_type nruns(void) const
+    {
+        return m_ends.size();
+    }
+
+    double sum(void) const
+    {
+        double result{0.0};
+        for_each_run(
+            [&result](size_type rbegin, size_type rend, weight_type w)
+            {
+                result += (double)w * (rend - rbegin);
+            }
+        );
+        return result;
+    }
+
+    /// calls fn(rbegin, rend, weight) for every run, in row order
+    template<typename _Fn>
+    void for_each_run(_Fn fn) const
+    {
+        size_type rbegin{0};
+        for (size_type run{0}; run < m_ends.size(); ++run)
+        {
+            fn(rbegin, m_ends[run], m_weights[run]);
+            rbegin = m_ends[run];
+        }
+    }
+
+private:
+    std::vector<size_type> m_ends;
+    std::vector<weight_type> m_weights;
+};
+
+/*
+ * Collapses identical records (features and label) wherever they occur
+ * into single rows weighted with the number of occurrences, labels y have
+ * to be 0/1. Rows are grouped by dedup_rows, a unique feature row gives
+ * a positive record weighted with its positive count and a negative one
+ * weighted with its negative count, those of nonzero count. Records are
+ * ordered by their weight, so that equal weights form one run each.
+ * Returns the collapsed matrix, its labels and the weights.
+ */
+template<typename _ValueType, typename _WeightType = float>
+std::tuple<array2d<_ValueType>, std::valarray<_ValueType>, RunLengthWeights<_WeightType>>
+collapse_repeats(const array2d<_ValueType> & X, const std::valarray<_ValueType> & y)
+{
+    typedef _ValueType value_type;
+
+    const UniqueRows<value_type> unique = dedup_rows(X, y);
+    const size_type NCOLS = X.shape().second;
+
+    // (unique row, label) of every record with a nonzero count
+    std::vector<std::pair<size_type, bool>> records;
+    for (size_type u{0}; u < unique.X.shape().first; ++u)
+    {
+        if (unique.pos[u] > 0.0)
+        {
+            records.emplace_back(u, true);
+        }
+        if (unique.neg[u] > 0.0)
+        {
+            records.emplace_back(u, false);
+        }
+    }
+
+    auto count = [&unique](const std::pair<size_type, bool> & record) -> value_type
+    {
+        return record.second ? unique.pos[record.first] : unique.neg[record.first];
+    };
+
+    std::stable_sort(records.begin(), records.end(),
+        [&count](const std::pair<size_type, bool> & p, const std::pair<size_type, bool> & q)
+        {
+            return count(p) < count(q);
+        }
+    );
+
+    array2d<value_type> X_out({records.size(), NCOLS}, 0.0);
+    std::valarray<value_type> y_out(records.size());
+    RunLengthWeights<_WeightType> weights;
+
+    for (size_type r{0}; r < records.size(); ++r)
+    {
+        X_out[X_out.row(r)] = unique.X[unique.X.row(records[r].first)];
+        y_out[r] = records[r].second ? 1.0 : 0.0;
+        weights.push_back(count(records[r]));
+    }
+
+    return std::make_tuple(std::move(X_out), std::move(y_out), std::move(weights));
+}
+
+}  // namespace num
+
+#endif /* WEIGHTS_HPP_ */
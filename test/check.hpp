@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: check.hpp
+ *
+ * Description:
+ *      Minimal checks for the test programs, independent of NDEBUG
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#ifndef CHECK_HPP_
+#define CHECK_HPP_
+
+#include <valarray>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+/// failed checks are reported, the test returns check_status() from main
+inline int & check_failures(void)
+{
+    static int failures{0};
+    return failures;
+}
+
+inline int check_status(void)
+{
+    if (check_failures())
+    {
+        std::cerr << check_failures() << " check(s) failed" << std::endl;
+    }
+    return check_failures() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+            ++check_failures(); \
+        } \
+    } while (0)
+
+/// largest absolute difference of two vectors of the same size
+template<typename _ValueType>
+_ValueType max_abs_diff(const std::valarray<_ValueType> & a, const std::valarray<_ValueType> & b)
+{
+    if (a.size() != b.size())
+    {
+        return INFINITY;
+    }
+    return a.size() ? std::abs(a - b).max() : 0;
+}
+
+#endif /* CHECK_HPP_ */
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_compact.cpp
+ *
+ * Description:
+ *      Compact columnar encodings against the dense matrix they encode
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "compact.hpp"
+#include "logreg.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <random>
+#include <cmath>
+
+int main(void)
+{
+    typedef double real_type;
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+    typedef num::CompactMatrix<real_type>::Encoding Encoding;
+
+    const num::size_type NROWS{20000};
+    const num::size_type NCOLS{5};
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> small(0, 10);
+    std::uniform_int_distribution<int> wide(0, 2999);
+    std::normal_distribution<real_type> normal(0.0, 1.0);
+    std::bernoulli_distribution coin(0.2);
+
+    // intercept, small integers, a standardized code column with a few
+    // thousand levels, a continuous column, labels
+    array_type X({NROWS, NCOLS}, 1.0);
+    vector_type y(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        const vector_type row = {1.0, (real_type)small(gen), (wide(gen) - 1500.0) / 866.0, normal(gen), normal(gen)};
+        X[X.row(r)] = row;
+        y[r] = coin(gen);
+    }
+
+    const num::CompactMatrix<real_type> compact(X);
+
+    CHECK(compact.shape() == X.shape());
+    CHECK(compact.column(0).encoding == Encoding::Dict8);
+    CHECK(compact.column(1).encoding == Encoding::Dict8);
+    CHECK(compact.column(2).encoding == Encoding::Dict16);
+    CHECK(compact.column(3).encoding == Encoding::Float);
+
+    // dictionary columns decode exactly, float ones to the nearest float
+    array_type decoded({NROWS, NCOLS}, 0.0);
+    bool exact{true};
+    bool rounded{true};
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        vector_type row(NCOLS);
+        for (num::size_type c{0}; c < NCOLS; ++c)
+        {
+            const real_type x = X.data()[r * NCOLS + c];
+            const real_type v = compact.at(r, c);
+
+            if (compact.column(c).encoding == Encoding::Float)
+            {
+                rounded = rounded && v == (real_type)(float)x;
+            }
+            else
+            {
+                exact = exact && v == x;
+            }
+            row[c] = v;
+        }
+        decoded[decoded.row(r)] = row;
+    }
+    CHECK(exact);
+    CHECK(rounded);
+
+    CHECK(compact.nbytes() < NROWS * NCOLS * sizeof (real_type) / 2);
+
+    // kernels over codes equal the dense ones over decoded values
+    const vector_type theta = {-1.0, 0.1, 0.5, -0.25, 0.3};
+
+    real_type sigma;
+    vector_type grad(NCOLS);
+    num::logreg_partial_sums(sigma, grad, theta, compact, y);
+
+    real_type sigma_dense;
+    vector_type grad_dense(NCOLS);
+    vector_type tcol(NROWS);
+    num::logreg_partial_sums(sigma_dense, grad_dense, tcol, theta, decoded, y, 0, NROWS);
+
+    CHECK(std::abs(sigma - sigma_dense) < 1e-9 * std::abs(sigma_dense));
+    CHECK(max_abs_diff(grad, grad_dense) < 1e-9 * std::abs(grad_dense).max());
+
+    return check_status();
+}
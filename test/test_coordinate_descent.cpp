@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_coordinate_descent.cpp
+ *
+ * Description:
+ *      Elastic-net solutions against their optimality (KKT) conditions
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "coordinate_descent.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <random>
+#include <cmath>
+
+namespace
+{
+
+typedef double real_type;
+typedef num::array2d<real_type> array_type;
+typedef std::valarray<real_type> vector_type;
+
+/// gradient of the mean log loss alone
+vector_type loss_grad(const array_type & X, const vector_type & y, const vector_type & theta)
+{
+    const num::size_type NROWS = X.shape().first;
+
+    vector_type residual(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        residual[r] = 1.0 / (1.0 + std::exp(-(X[X.row(r)] * theta).sum())) - y[r];
+    }
+
+    vector_type grad(X.shape().second);
+    for (num::size_type c{0}; c < grad.size(); ++c)
+    {
+        grad[c] = (X[X.column(c)] * residual).sum() / NROWS;
+    }
+    return grad;
+}
+
+/*
+ * Largest violation of the optimality conditions: zero gradient for the
+ * intercept, g + l1 * sign(theta) + l2 * theta = 0 for nonzero
+ * coefficients, |g| <= l1 for zero ones.
+ */
+real_type kkt_violation(const array_type & X, const vector_type & y, const vector_type & theta,
+    const num::ElasticNetCfg<real_type> & cfg)
+{
+    const real_type l1 = cfg.lambda() * cfg.l1_ratio();
+    const real_type l2 = cfg.lambda() * (1.0 - cfg.l1_ratio());
+    const vector_type g = loss_grad(X, y, theta);
+
+    real_type worst = std::abs(g[0]);
+    for (num::size_type c{1}; c < theta.size(); ++c)
+    {
+        const real_type violation = theta[c] != 0.0 ?
+            std::abs(g[c] + l1 * (theta[c] > 0.0 ? 1.0 : -1.0) + l2 * theta[c]) :
+            std::max<real_type>(std::abs(g[c]) - l1, 0.0);
+        worst = std::max(worst, violation);
+    }
+    return worst;
+}
+
+num::size_type nonzeros(const vector_type & theta)
+{
+    num::size_type result{0};
+    for (num::size_type c{1}; c < theta.size(); ++c)
+    {
+        result += theta[c] != 0.0;
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(void)
+{
+    const num::size_type NROWS{3000};
+    const num::size_type NCOLS{31};
+
+    std::mt19937 gen(1);
+    std::normal_distribution<real_type> normal(0.0, 1.0);
+    std::uniform_real_distribution<real_type> uniform(0.0, 1.0);
+
+    // three informative features out of thirty
+    vector_type planted(0.0, NCOLS);
+    planted[0] = -1.0;
+    planted[1] = 1.5;
+    planted[2] = -1.0;
+    planted[3] = 0.75;
+
+    array_type X({NROWS, NCOLS}, 1.0);
+    vector_type y(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        vector_type row(1.0, NCOLS);
+        for (num::size_type c{1}; c < NCOLS; ++c)
+        {
+            row[c] = normal(gen);
+        }
+        X[X.row(r)] = row;
+        y[r] = uniform(gen) < 1.0 / (1.0 + std::exp(-(row * planted).sum()));
+    }
+
+    const vector_type theta0(0.0, NCOLS);
+
+    for (const real_type l1_ratio : {1.0, 0.5})
+    {
+        const num::ElasticNetCfg<real_type> cfg = num::ElasticNetCfg<real_type>()
+            .lambda(0.02)
+            .l1_ratio(l1_ratio)
+            .tol(1e-14);
+
+        const vector_type theta = num::elastic_net_fit(X, y, theta0, cfg);
+
+        CHECK(kkt_violation(X, y, theta, cfg) < 1e-6);
+
+        // the informative features and few of the others
+        CHECK(theta[1] > 0.0 && theta[2] < 0.0 && theta[3] > 0.0);
+        CHECK(nonzeros(theta) < 10);
+
+        // screening only saves work, it does not change the solution
+        const vector_type unscreened = num::elastic_net_fit(X, y, theta0, num::ElasticNetCfg<real_type>(cfg).strong_rules(false));
+        CHECK(max_abs_diff(unscreened, theta) < 1e-6);
+
+        // and neither does the path
+        const vector_type direct = num::elastic_net_fit(X, y, theta0, num::ElasticNetCfg<real_type>(cfg).path_length(1));
+        CHECK(max_abs_diff(direct, theta) < 1e-6);
+    }
+
+    // a large enough lambda leaves the intercept only
+    const num::ElasticNetCfg<real_type> strong = num::ElasticNetCfg<real_type>().lambda(1.0).tol(1e-14);
+    const vector_type null_theta = num::elastic_net_fit(X, y, theta0, strong);
+    CHECK(nonzeros(null_theta) == 0);
+    CHECK(kkt_violation(X, y, null_theta, strong) < 1e-6);
+
+    return check_status();
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_csr.cpp
+ *
+ * Description:
+ *      One-hot CSR encoding and the hybrid dense+sparse kernel against
+ *      the dense one-hot equivalent
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "csr.hpp"
+#include "logreg.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <random>
+#include <cmath>
+
+int main(void)
+{
+    typedef double real_type;
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+
+    const num::size_type NROWS{4000};
+    const num::size_type NDENSE{3};
+    const num::size_type NLEVELS_A{5};
+    const num::size_type NLEVELS_B{50};
+
+    std::mt19937 gen(1);
+    std::normal_distribution<real_type> normal(0.0, 1.0);
+    std::uniform_int_distribution<int> level_a(0, NLEVELS_A - 1);
+    std::uniform_int_distribution<int> level_b(0, NLEVELS_B - 1);
+    std::uniform_real_distribution<real_type> uniform(0.0, 1.0);
+
+    // intercept and two continuous features, then two categorical codes
+    array_type raw({NROWS, NDENSE + 2}, 1.0);
+    vector_type y(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        const vector_type row = {1.0, normal(gen), normal(gen), (real_type)level_a(gen), (real_type)level_b(gen)};
+        raw[raw.row(r)] = row;
+        y[r] = uniform(gen) < 1.0 / (1.0 + std::exp(-(row[1] - 0.1 * row[3] + (row[4] < 10 ? 1.0 : -1.0))));
+    }
+
+    const num::OneHotEncoder<real_type> encoder(raw, {NDENSE, NDENSE + 1});
+    const num::csr_matrix<real_type> S = encoder.encode(raw);
+
+    CHECK(encoder.ncols() == NLEVELS_A + NLEVELS_B);
+    CHECK(S.shape() == num::shape_type(NROWS, NLEVELS_A + NLEVELS_B));
+    CHECK(S.nnz() == 2 * NROWS);
+
+    // the same features, dense: indicators spelled out
+    const num::size_type NCOLS = NDENSE + encoder.ncols();
+    array_type X({NROWS, NDENSE}, 0.0);
+    array_type dense({NROWS, NCOLS}, 0.0);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        const vector_type row = raw[raw.row(r)];
+        X[X.row(r)] = vector_type(row[std::slice(0, NDENSE, 1)]);
+
+        vector_type dense_row(0.0, NCOLS);
+        dense_row[std::slice(0, NDENSE, 1)] = vector_type(row[std::slice(0, NDENSE, 1)]);
+        dense_row[NDENSE + (num::size_type)row[NDENSE]] = 1.0;
+        dense_row[NDENSE + NLEVELS_A + (num::size_type)row[NDENSE + 1]] = 1.0;
+        dense[dense.row(r)] = dense_row;
+    }
+
+    bool rows_match{true};
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        for (num::size_type k{S.row_ptr()[r]}; k < S.row_ptr()[r + 1]; ++k)
+        {
+            rows_match = rows_match && S.values()[k] == 1.0 && dense.data()[r * NCOLS + NDENSE + S.col_idx()[k]] == 1.0;
+        }
+    }
+    CHECK(rows_match);
+
+    // categories not seen by the encoder give empty rows
+    array_type unseen({1, NDENSE + 2}, 1.0);
+    const vector_type unseen_row = {1.0, 0.0, 0.0, (real_type)NLEVELS_A, -1.0};
+    unseen[unseen.row(0)] = unseen_row;
+    const num::csr_matrix<real_type> S_unseen = encoder.encode(unseen);
+    CHECK(S_unseen.shape().first == 1 && S_unseen.nnz() == 0);
+
+    const real_type C{0.5};
+    vector_type theta(NCOLS);
+    for (auto & t : theta)
+    {
+        t = 0.3 * normal(gen);
+    }
+
+    real_type cost;
+    vector_type grad(NCOLS);
+    num::logreg_cost_grad(cost, grad, theta, X, S, y, C);
+
+    real_type cost_dense;
+    vector_type grad_dense(NCOLS);
+    vector_type tcol(NROWS);
+    num::logreg_cost_grad(cost_dense, grad_dense, tcol, theta, dense, y, C);
+
+    CHECK(std::abs(cost - cost_dense) < 1e-12);
+    CHECK(max_abs_diff(grad, grad_dense) < 1e-12);
+
+    std::vector<num::size_type> all_rows(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        all_rows[r] = r;
+    }
+
+    const vector_type theta0(0.0, NCOLS);
+    const vector_type fitted = num::fit_hybrid(X, S, y, theta0, C, 100);
+    const vector_type fitted_dense = num::fit_rows(dense, y, all_rows, theta0, C, 100);
+
+    // up to rounding of sums taken in a different order
+    CHECK(max_abs_diff(fitted, fitted_dense) < 1e-6);
+
+    return check_status();
+}
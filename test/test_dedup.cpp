@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_dedup.cpp
+ *
+ * Description:
+ *      Deduplicated rows and their label counts against the records
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "dedup.hpp"
+#include "logreg.hpp"
+#include "fmincg.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <map>
+#include <random>
+#include <functional>
+#include <cmath>
+
+int main(void)
+{
+    typedef double real_type;
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+
+    const num::size_type NROWS{5000};
+    const num::size_type NCOLS{4};
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> level(-2, 2);
+    std::bernoulli_distribution coin(0.3);
+
+    // few levels, so most rows repeat; zeros of both signs
+    array_type X({NROWS, NCOLS}, 1.0);
+    vector_type y(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        vector_type row(1.0, NCOLS);
+        for (num::size_type c{1}; c < NCOLS; ++c)
+        {
+            const int v = level(gen);
+            row[c] = v ? 0.5 * v : std::copysign(0.0, coin(gen) ? -1.0 : 1.0);
+        }
+        X[X.row(r)] = row;
+        y[r] = coin(gen);
+    }
+
+    const num::UniqueRows<real_type> unique = num::dedup_rows(X, y);
+    const num::size_type NUNIQUE = unique.X.shape().first;
+
+    // brute force: rows compared with ==, so that -0 equals +0
+    std::map<std::vector<real_type>, std::pair<real_type, real_type>> expected;
+    std::vector<std::vector<real_type>> first_order;
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        const vector_type row = X[X.row(r)];
+        const std::vector<real_type> key(std::begin(row), std::end(row));
+        if (!expected.count(key))
+        {
+            first_order.push_back(key);
+        }
+        (y[r] > 0 ? expected[key].first : expected[key].second) += 1.0;
+    }
+
+    CHECK(NUNIQUE == expected.size());
+    CHECK(unique.pos.size() == NUNIQUE && unique.neg.size() == NUNIQUE);
+    CHECK((unique.pos + unique.neg).sum() == NROWS);
+
+    bool counts_match{NUNIQUE == first_order.size()};
+    for (num::size_type u{0}; counts_match && u < NUNIQUE; ++u)
+    {
+        const vector_type row = unique.X[unique.X.row(u)];
+        const std::vector<real_type> key(std::begin(row), std::end(row));
+
+        // in the order of first occurrence
+        counts_match = key == first_order[u]
+            && expected[key].first == unique.pos[u]
+            && expected[key].second == unique.neg[u];
+    }
+    CHECK(counts_match);
+
+    // cost and gradient over unique rows equal those over the records
+    const vector_type theta = {0.3, -0.5, 0.25, 1.0};
+    const real_type C{0.5};
+
+    real_type cost;
+    vector_type grad(NCOLS);
+    vector_type tcol(NROWS);
+    num::logreg_cost_grad(cost, grad, tcol, theta, X, y, C);
+
+    real_type sigma_u;
+    vector_type grad_u(NCOLS);
+    vector_type tcol_u(NUNIQUE);
+    num::logreg_counts_partial_sums(sigma_u, grad_u, tcol_u, theta, unique.X, unique.pos, unique.neg);
+    real_type cost_u;
+    num::logreg_cost_grad_finalize(cost_u, grad_u, sigma_u, theta, NROWS, C);
+
+    CHECK(std::abs(cost_u - cost) < 1e-12);
+    CHECK(max_abs_diff(grad_u, grad) < 1e-12);
+
+    // and so does the fit
+    const vector_type theta0(0.0, NCOLS);
+    std::function<std::pair<real_type, vector_type> (vector_type)> cost_fn =
+        [&](const vector_type theta) -> std::pair<real_type, vector_type>
+        {
+            real_type cost;
+            vector_type grad(NCOLS);
+            num::logreg_cost_grad(cost, grad, tcol, theta, X, y, C);
+            return std::make_pair(cost, grad);
+        };
+
+    const vector_type fitted = num::fmincg(cost_fn, theta0, 100, false);
+    const vector_type fitted_u = num::fit_counts(unique.X, unique.pos, unique.neg, theta0, C, 100);
+
+    // up to rounding of sums taken in a different order
+    CHECK(max_abs_diff(fitted_u, fitted) < 1e-6);
+
+    return check_status();
+}
@@ -0,0 +1,179 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_fixed_width.cpp
+ *
+ * Description:
+ *      Fixed-width row kernels against the generic valarray ones
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "logreg.hpp"
+#include "array2d_fixed.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <random>
+#include <cmath>
+
+namespace
+{
+
+typedef double real_type;
+typedef num::array2d<real_type> array_type;
+typedef std::valarray<real_type> vector_type;
+
+std::mt19937 gen(1);
+
+array_type random_X(num::size_type nrows, num::size_type ncols)
+{
+    std::normal_distribution<real_type> normal(0.0, 1.0);
+
+    array_type X({nrows, ncols}, 1.0);
+    for (num::size_type r{0}; r < nrows; ++r)
+    {
+        vector_type row(ncols);
+        row[0] = 1.0;
+        for (num::size_type c{1}; c < ncols; ++c)
+        {
+            row[c] = normal(gen);
+        }
+        X[X.row(r)] = row;
+    }
+    return X;
+}
+
+vector_type random_y(const array_type & X)
+{
+    std::uniform_real_distribution<real_type> uniform(0.0, 1.0);
+
+    vector_type y(X.shape().first);
+    for (num::size_type r{0}; r < X.shape().first; ++r)
+    {
+        y[r] = uniform(gen) < 1.0 / (1.0 + std::exp(-X[X.row(r)].sum() / 4));
+    }
+    return y;
+}
+
+vector_type random_theta(num::size_type ncols)
+{
+    std::normal_distribution<real_type> normal(0.0, 0.3);
+
+    vector_type theta(ncols);
+    for (auto & t : theta)
+    {
+        t = normal(gen);
+    }
+    return theta;
+}
+
+/// fixed-width cost, gradient and partial sums over a row range against the generic ones
+template<num::size_type _NCols>
+void check_width(void)
+{
+    const num::size_type NROWS{1001};
+
+    const array_type X = random_X(NROWS, _NCols);
+    const vector_type y = random_y(X);
+    const vector_type theta = random_theta(_NCols);
+    const num::array2d_fixed<real_type, _NCols> X_fixed(X);
+
+    CHECK(X_fixed.shape() == X.shape());
+    CHECK(X_fixed.STRIDE % X_fixed.LANES == 0 && X_fixed.STRIDE >= _NCols);
+
+    real_type dot_diff{0.0};
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        const real_type dot = num::detail::fixed_dot<_NCols>(X.data() + r * _NCols, &theta[0]);
+        dot_diff = std::max(dot_diff, std::abs(dot - (X[X.row(r)] * theta).sum()));
+    }
+    CHECK(dot_diff < 1e-12);
+
+    vector_type tcol(NROWS);
+
+    real_type cost;
+    vector_type grad(_NCols);
+    num::logreg_cost_grad(cost, grad, tcol, theta, X, y, 0.5);
+
+    real_type cost_fixed;
+    vector_type grad_fixed(_NCols);
+    num::logreg_cost_grad(cost_fixed, grad_fixed, tcol, theta, X_fixed, y, 0.5);
+
+    CHECK(std::abs(cost - cost_fixed) < 1e-12);
+    CHECK(max_abs_diff(grad, grad_fixed) < 1e-12);
+
+    real_type sigma;
+    vector_type part(_NCols);
+    num::logreg_partial_sums(sigma, part, tcol, theta, X, y, 100, 357);
+
+    real_type sigma_fixed;
+    vector_type part_fixed(_NCols);
+    num::logreg_partial_sums(sigma_fixed, part_fixed, tcol, theta, X_fixed, y, 100, 357);
+
+    CHECK(std::abs(sigma - sigma_fixed) < 1e-10);
+    CHECK(max_abs_diff(part, part_fixed) < 1e-10);
+}
+
+}  // namespace
+
+int main(void)
+{
+    // padded and unpadded widths
+    check_width<4>();
+    check_width<5>();
+    check_width<7>();
+    check_width<29>();
+
+    // only the listed widths are dispatched
+    num::size_type seen{0};
+    auto record = [&seen](std::integral_constant<num::size_type, 29>) { seen = 29; };
+    CHECK(num::detail::FixedWidthDispatch<29>::apply(29, record) && seen == 29);
+    CHECK(!num::detail::FixedWidthDispatch<29>::apply(30, record));
+
+    // LogisticRegression takes the fixed path for 29 columns, the result
+    // is that of the generic kernel up to summation order
+    const num::size_type NROWS{2000};
+    array_type X = random_X(NROWS, 29);
+    vector_type y = random_y(X);
+
+    std::vector<num::size_type> all_rows(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        all_rows[r] = r;
+    }
+
+    const vector_type theta0(0.0, 29);
+    const vector_type expected = num::fit_rows(X, y, all_rows, theta0, 1.0, 50);
+    const vector_type expected_H = [&]()
+    {
+        vector_type H(NROWS);
+        for (num::size_type r{0}; r < NROWS; ++r)
+        {
+            H[r] = 1.0 / (1.0 + std::exp(-(vector_type(X[X.row(r)]) * expected).sum()));
+        }
+        return H;
+    }();
+
+    const array_type X_test(X);
+    num::LogisticRegression<real_type> clf(std::move(X), std::move(y), vector_type(theta0), 1.0, 50);
+    const vector_type fitted = clf.fit();
+
+    CHECK(max_abs_diff(fitted, expected) < 1e-6);
+    CHECK(max_abs_diff(clf.predict(X_test, expected, false), expected_H) < 1e-12);
+
+    return check_status();
+}
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_gbdt.cpp
+ *
+ * Description:
+ *      Gradient boosted trees on a problem linear models cannot fit
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "gbdt.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <random>
+#include <cmath>
+
+namespace
+{
+
+typedef double real_type;
+typedef num::array2d<real_type> array_type;
+typedef std::valarray<real_type> vector_type;
+
+/// y is the XOR of two thresholded features, the third one is noise
+void make_xor(array_type & X, vector_type & y, std::mt19937 & gen)
+{
+    std::uniform_real_distribution<real_type> uniform(0.0, 1.0);
+
+    for (num::size_type r{0}; r < X.shape().first; ++r)
+    {
+        const vector_type row = {uniform(gen), uniform(gen), uniform(gen)};
+        X[X.row(r)] = row;
+        y[r] = (row[0] > 0.5) != (row[1] > 0.5);
+    }
+}
+
+real_type accuracy(const vector_type & p, const vector_type & y)
+{
+    real_type hits{0};
+    for (num::size_type r{0}; r < y.size(); ++r)
+    {
+        hits += (p[r] > 0.5) == (y[r] > 0.5);
+    }
+    return hits / y.size();
+}
+
+real_type logloss(const vector_type & p, const vector_type & y)
+{
+    return -(y * std::log(p) + (1.0 - y) * std::log(1.0 - p)).sum() / y.size();
+}
+
+}  // namespace
+
+int main(void)
+{
+    // large enough for histograms built over chunks on several threads
+    const num::size_type NROWS{40000};
+
+    std::mt19937 gen(1);
+
+    array_type X({NROWS, 3}, 0.0);
+    vector_type y(NROWS);
+    make_xor(X, y, gen);
+
+    array_type X_test({NROWS / 4, 3}, 0.0);
+    vector_type y_test(NROWS / 4);
+    make_xor(X_test, y_test, gen);
+
+    const num::GbdtCfg<real_type> cfg = num::GbdtCfg<real_type>()
+        .ntrees(30)
+        .max_depth(3)
+        .learning_rate(0.3)
+        .threads(1);
+
+    num::GradientBoostedTrees<real_type> gbdt(cfg);
+    gbdt.fit(X, y);
+
+    CHECK(gbdt.ntrees() == 30);
+
+    const vector_type margins = gbdt.margins(X_test);
+    const vector_type p = gbdt.predict_proba(X_test);
+
+    CHECK(max_abs_diff(p, vector_type(1.0 / (1.0 + std::exp(-margins)))) < 1e-12);
+    CHECK(accuracy(p, y_test) > 0.98);
+
+    // more trees fit better
+    num::GradientBoostedTrees<real_type> short_gbdt(num::GbdtCfg<real_type>(cfg).ntrees(3));
+    short_gbdt.fit(X, y);
+    CHECK(logloss(gbdt.predict_proba(X), y) < logloss(short_gbdt.predict_proba(X), y));
+
+    // no trees, the log odds of the base rate
+    num::GradientBoostedTrees<real_type> no_trees(num::GbdtCfg<real_type>(cfg).ntrees(0));
+    no_trees.fit(X, y);
+    const real_type rate = y.sum() / NROWS;
+    CHECK(max_abs_diff(no_trees.margins(X_test), vector_type(std::log(rate / (1.0 - rate)), NROWS / 4)) < 1e-12);
+
+    // threads only change the order histogram sums are reduced in
+    num::GradientBoostedTrees<real_type> threaded(num::GbdtCfg<real_type>(cfg).threads(4));
+    threaded.fit(X, y);
+    CHECK(max_abs_diff(threaded.margins(X_test), margins) < 1e-9);
+
+    return check_status();
+}
@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_incremental.cpp
+ *
+ * Description:
+ *      Incremental model updates against refits over all rows
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "incremental.hpp"
+#include "model.hpp"
+#include "logreg.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cmath>
+
+namespace
+{
+
+typedef double real_type;
+typedef num::array2d<real_type> array_type;
+typedef std::valarray<real_type> vector_type;
+
+const num::size_type NCOLS{5};
+const real_type C{0.02};
+const num::size_type MAX_ITER{200};
+
+/// rows [begin, end) of X, y
+std::pair<array_type, vector_type> rows(const array_type & X, const vector_type & y, num::size_type begin, num::size_type end)
+{
+    array_type X_rows({end - begin, NCOLS}, 0.0);
+    for (num::size_type r{begin}; r < end; ++r)
+    {
+        X_rows[X_rows.row(r - begin)] = X[X.row(r)];
+    }
+    return std::make_pair(std::move(X_rows), vector_type(y[std::slice(begin, end - begin, 1)]));
+}
+
+/// model fitted on raw X (intercept in column 0), like do_log_reg does
+std::vector<std::uint64_t> fit(const array_type & X, const vector_type & y)
+{
+    array_type X_std(X);
+    vector_type mu(0.0, NCOLS);
+    vector_type dev(1.0, NCOLS);
+
+    for (num::size_type c{1}; c < NCOLS; ++c)
+    {
+        const vector_type col = X[X.column(c)];
+
+        mu[c] = num::mean<real_type>(col);
+        dev[c] = num::std<real_type>(col);
+        X_std[X_std.column(c)] = (col - mu[c]) / dev[c];
+    }
+
+    const num::LogisticRegression<real_type> classifier(
+        std::move(X_std), vector_type(y), vector_type(0.0, NCOLS), C, MAX_ITER);
+
+    return num::serialize_model(classifier.fit(), mu, dev, num::density_counts_type(), X.shape().first);
+}
+
+/// coefficients over raw features, comparable across standardizations
+vector_type raw_theta(const std::vector<std::uint64_t> & words)
+{
+    const num::ModelView model(words.data(), words.size() * sizeof (std::uint64_t));
+
+    vector_type beta(NCOLS);
+    beta[0] = model.theta()[0];
+    for (num::size_type c{1}; c < NCOLS; ++c)
+    {
+        beta[c] = model.theta()[c] / model.dev()[c];
+        beta[0] -= beta[c] * model.mu()[c];
+    }
+    return beta;
+}
+
+}  // namespace
+
+int main(void)
+{
+    const num::size_type NHIST{4000};
+    const num::size_type NBATCH{4000};
+
+    std::mt19937 gen(1);
+    std::normal_distribution<real_type> normal;
+    std::uniform_real_distribution<real_type> uniform;
+
+    const real_type BETA[NCOLS] = {-2.0, 0.8, -0.5, 0.3, 0.0};
+
+    array_type X = num::ones<real_type>({NHIST + NBATCH, NCOLS});
+    vector_type y(NHIST + NBATCH);
+    for (num::size_type r{0}; r < NHIST + NBATCH; ++r)
+    {
+        vector_type row(1.0, NCOLS);
+        real_type z{BETA[0]};
+        for (num::size_type c{1}; c < NCOLS; ++c)
+        {
+            row[c] = 2.0 + 3.0 * normal(gen);
+            z += BETA[c] * (row[c] - 2.0);
+        }
+        X[X.row(r)] = row;
+        y[r] = uniform(gen) < 1.0 / (1.0 + std::exp(-z));
+    }
+
+    const auto history = rows(X, y, 0, NHIST);
+    const auto batch = rows(X, y, NHIST, NHIST + NBATCH);
+
+    const std::vector<std::uint64_t> fitted = fit(history.first, history.second);
+    const std::vector<std::uint64_t> refitted = fit(X, y);
+    const std::vector<std::uint64_t> batch_only = fit(batch.first, batch.second);
+
+    num::IncrementalModel incremental(num::ModelView(fitted.data(), fitted.size() * sizeof (std::uint64_t)));
+    incremental.update(batch.first, batch.second, C, MAX_ITER);
+
+    CHECK(incremental.nrows() == NHIST + NBATCH);
+
+    const vector_type before = raw_theta(fitted);
+    const vector_type after = raw_theta(incremental.serialize());
+
+    // a batch as large as the history moves the model about as far as a
+    // refit over all rows does
+    const real_type refit_moved = max_abs_diff(raw_theta(refitted), before);
+    const real_type to_refit = max_abs_diff(after, raw_theta(refitted));
+
+    CHECK(to_refit < 0.2 * refit_moved);
+
+    // a model fitted on all rows barely moves when some of them come again,
+    // unlike towards the fit of those rows alone
+    const auto again = rows(X, y, 0, NBATCH / 2);
+    const std::vector<std::uint64_t> again_only = fit(again.first, again.second);
+
+    num::IncrementalModel full(num::ModelView(refitted.data(), refitted.size() * sizeof (std::uint64_t)));
+    full.update(again.first, again.second, C, MAX_ITER);
+
+    const real_type moved = max_abs_diff(raw_theta(full.serialize()), raw_theta(refitted));
+    const real_type apart = max_abs_diff(raw_theta(again_only), raw_theta(refitted));
+
+    CHECK(moved < 0.2 * apart);
+
+    std::cerr << "update from refit: " << to_refit << " (refit moved " << refit_moved << "), update of the full model moved: "
+        << moved << " (fit of the rows alone: " << apart << ")" << std::endl;
+
+    return check_status();
+}
@@ -0,0 +1,198 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_ingest.cpp
+ *
+ * Description:
+ *      Pipelined ingest against the text it reads, failures of its stages
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "ingest.hpp"
+#include "check.hpp"
+
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <stdexcept>
+#include <cstdlib>
+
+namespace
+{
+
+typedef double real_type;
+
+/// serves a string, but cannot be rewound
+class ForwardOnlyBuf : public std::streambuf
+{
+public:
+    explicit ForwardOnlyBuf(std::string text)
+    :
+        m_text(std::move(text))
+    {
+        setg(&m_text[0], &m_text[0], &m_text[0] + m_text.size());
+    }
+
+private:
+    std::string m_text;
+};
+
+real_type strict_xlt(const char * str)
+{
+    if (*str == 'x')
+    {
+        throw std::invalid_argument("bad field");
+    }
+    return std::strtod(str, nullptr);
+}
+
+/// rows r, 2r, 3r, with blank lines and CRLF endings here and there
+std::string make_text(num::size_type nrows)
+{
+    std::string text;
+    for (num::size_type r{0}; r < nrows; ++r)
+    {
+        text += std::to_string(r) + "," + std::to_string(2 * r) + "," + std::to_string(3 * r);
+        text += r % 7 ? "\n" : "\r\n";
+        if (r % 11 == 0)
+        {
+            text += r % 2 ? "\n" : "\r\n";
+        }
+    }
+    // last line without a newline
+    return text + "1,2,3";
+}
+
+bool matches(const num::array2d<real_type> & data, num::size_type nrows)
+{
+    if (data.shape() != num::shape_type(nrows + 1, 3))
+    {
+        return false;
+    }
+    for (num::size_type r{0}; r < nrows; ++r)
+    {
+        for (num::size_type c{0}; c < 3; ++c)
+        {
+            if (data.data()[r * 3 + c] != real_type((c + 1) * r))
+            {
+                return false;
+            }
+        }
+    }
+    return data.data()[nrows * 3] == 1 && data.data()[nrows * 3 + 2] == 3;
+}
+
+template<typename _Fn>
+bool throws_invalid_argument(_Fn fn)
+{
+    try
+    {
+        fn();
+    }
+    catch (const std::invalid_argument &)
+    {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main(void)
+{
+    const num::size_type NROWS{5000};
+    const std::string text = make_text(NROWS);
+
+    std::istringstream empty("");
+    CHECK(num::ingest_matrix(empty, num::IngestCfg<real_type>()).shape() == num::shape_type(0, 0));
+
+    for (const num::size_type parsers : {1, 3, 8})
+    {
+        // small blocks and a shallow pipeline, so that parsers finish out
+        // of order and wait for the encoder
+        const num::IngestCfg<real_type> cfg = num::IngestCfg<real_type>()
+            .block_size(97)
+            .parsers(parsers)
+            .queue_depth(1);
+
+        std::istringstream seekable(text);
+        CHECK(matches(num::ingest_matrix(seekable, cfg), NROWS));
+
+        ForwardOnlyBuf buf(text);
+        std::istream forward_only(&buf);
+        CHECK(forward_only.tellg() == std::istream::pos_type(-1));
+        CHECK(matches(num::ingest_matrix(forward_only, cfg), NROWS));
+
+        // a parser failing halfway, its exception reaches the caller
+        const num::IngestCfg<real_type> strict = num::IngestCfg<real_type>(cfg)
+            .converters({{1, strict_xlt}});
+        const std::string bad = make_text(NROWS / 2) + "\n7,x,9\n" + make_text(NROWS / 2);
+
+        CHECK(throws_invalid_argument(
+            [&]()
+            {
+                std::istringstream is(bad);
+                num::ingest_matrix(is, strict);
+            }
+        ));
+        CHECK(throws_invalid_argument(
+            [&]()
+            {
+                ForwardOnlyBuf bad_buf(bad);
+                std::istream is(&bad_buf);
+                num::ingest_matrix(is, strict);
+            }
+        ));
+
+        // and so does the encoder's
+        CHECK(throws_invalid_argument(
+            [&]()
+            {
+                std::istringstream is(text);
+                num::ingest(is, cfg,
+                    [](const real_type *, num::size_type, num::size_type)
+                    {
+                        throw std::invalid_argument("refused");
+                    }
+                );
+            }
+        ));
+
+        // a short line, an empty and a malformed field in the middle of
+        // a block, in small blocks and in one block holding everything
+        for (const char * broken : {"7,14\n", "7,,21\n", "7,14x,21\n", "7,14,21,\n"})
+        {
+            const std::string ragged = make_text(NROWS / 2) + "\n" + broken + make_text(NROWS / 2);
+
+            for (const num::size_type block_size : {97, 1 << 20})
+            {
+                bool rejected{false};
+                try
+                {
+                    std::istringstream is(ragged);
+                    num::ingest_matrix(is, num::IngestCfg<real_type>(cfg).block_size(block_size));
+                }
+                catch (const std::runtime_error &)
+                {
+                    rejected = true;
+                }
+                CHECK(rejected);
+            }
+        }
+    }
+
+    return check_status();
+}
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_logreg_mp.cpp
+ *
+ * Description:
+ *      Sharded multi-process cost/gradient against the single process one
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "logreg_mp.hpp"
+#include "logreg.hpp"
+#include "fmincg.hpp"
+#include "check.hpp"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <fstream>
+#include <vector>
+
+#include <valarray>
+#include <functional>
+#include <system_error>
+#include <cerrno>
+#include <random>
+#include <utility>
+
+namespace
+{
+
+/// pids of our child processes, the worker processes of a sharded cost
+std::vector<pid_t> child_pids(void)
+{
+    std::ifstream ifs("/proc/self/task/" + std::to_string(::getpid()) + "/children");
+    std::vector<pid_t> pids;
+
+    for (pid_t pid; ifs >> pid;)
+    {
+        pids.push_back(pid);
+    }
+    return pids;
+}
+
+}  // namespace
+
+int main(void)
+{
+    typedef double real_type;
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+
+    const num::size_type NROWS{1001};
+    const num::size_type NCOLS{7};
+    const real_type C{0.5};
+
+    std::mt19937 gen(1);
+    std::normal_distribution<real_type> normal;
+
+    // intercept in column 0, labels from a noisy linear model
+    array_type X = num::ones<real_type>({NROWS, NCOLS});
+    vector_type y(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        vector_type row(1.0, NCOLS);
+        real_type z{-1.0};
+        for (num::size_type c{1}; c < NCOLS; ++c)
+        {
+            row[c] = normal(gen);
+            z += row[c] * (c % 2 ? 0.5 : -0.3);
+        }
+        X[X.row(r)] = row;
+        y[r] = (z + normal(gen) > 0.0) ? 1.0 : 0.0;
+    }
+
+    vector_type theta(NCOLS);
+    for (auto & t : theta)
+    {
+        t = 0.1 * normal(gen);
+    }
+
+    vector_type tcol(NROWS);
+    vector_type grad(NCOLS);
+    real_type cost;
+    num::logreg_cost_grad(cost, grad, tcol, theta, X, y, C);
+
+    // uneven shards, one of them a single row, more shards than rows
+    for (num::size_type nshards : {1, 2, 3, 4, 7, 2000})
+    {
+        num::ShardedLogRegCostGrad<real_type> sharded(X, y, C, nshards);
+
+        // repeated evaluations reuse the workers
+        for (int rep{0}; rep < 3; ++rep)
+        {
+            const std::pair<real_type, vector_type> cost_grad = sharded(theta);
+
+            CHECK(std::abs(cost_grad.first - cost) < 1e-12);
+            CHECK(max_abs_diff(cost_grad.second, grad) < 1e-12);
+        }
+    }
+
+    std::function<std::pair<real_type, vector_type> (const vector_type)> cost_fn =
+        [&](const vector_type theta) -> std::pair<real_type, vector_type>
+        {
+            return num::logreg_cost_grad(theta, X, y, C);
+        };
+    const vector_type fitted = num::fmincg(cost_fn, vector_type(0.0, NCOLS), 50, false);
+
+    num::size_type rows_visited{0};
+    const vector_type fitted_sharded = num::fit_sharded(X, y, vector_type(0.0, NCOLS), C, 50, 3, &rows_visited);
+
+    CHECK(max_abs_diff(fitted_sharded, fitted) < 1e-8);
+    CHECK(rows_visited > 0 && rows_visited % NROWS == 0);
+
+    // a worker killed during a fit makes the next evaluation throw instead
+    // of the coordinator getting killed by SIGPIPE
+    {
+        num::ShardedLogRegCostGrad<real_type> sharded(X, y, C, 4);
+        const std::vector<pid_t> workers = child_pids();
+        CHECK(workers.size() == 3);
+
+        num::size_type nevals{0};
+        std::function<std::pair<real_type, vector_type> (const vector_type)> dying_cost_fn =
+            [&](const vector_type theta) -> std::pair<real_type, vector_type>
+            {
+                if (++nevals == 3 && !workers.empty())
+                {
+                    ::kill(workers.back(), SIGKILL);
+
+                    // dead, but left for the teardown to reap
+                    siginfo_t info;
+                    ::waitid(P_PID, workers.back(), &info, WEXITED | WNOWAIT);
+                }
+                return sharded(theta);
+            };
+
+        int error{0};
+        try
+        {
+            num::fmincg(dying_cost_fn, vector_type(0.0, NCOLS), 50, false);
+        }
+        catch (const std::system_error & ex)
+        {
+            error = ex.code().value();
+        }
+
+        CHECK(nevals == 3);
+        CHECK(error == EPIPE);
+
+        sigset_t pending;
+        ::sigpending(&pending);
+        CHECK(!::sigismember(&pending, SIGPIPE));
+
+        sigset_t blocked;
+        ::pthread_sigmask(SIG_BLOCK, nullptr, &blocked);
+        CHECK(!::sigismember(&blocked, SIGPIPE));
+    }
+    CHECK(::waitpid(-1, nullptr, WNOHANG) < 0 && errno == ECHILD);
+
+    // running out of descriptors half way through the setup, workers
+    // forked so far are reaped and their pipes closed
+    {
+        rlimit saved;
+        ::getrlimit(RLIMIT_NOFILE, &saved);
+
+        const int probe = ::dup(0);
+        ::close(probe);
+
+        rlimit limited = saved;
+        limited.rlim_cur = probe + 12;
+        ::setrlimit(RLIMIT_NOFILE, &limited);
+
+        bool thrown{false};
+        try
+        {
+            num::ShardedLogRegCostGrad<real_type> sharded(X, y, C, 50);
+        }
+        catch (const std::system_error &)
+        {
+            thrown = true;
+        }
+
+        CHECK(thrown);
+        CHECK(::waitpid(-1, nullptr, WNOHANG) < 0 && errno == ECHILD);
+
+        const int after = ::dup(0);
+        CHECK(after == probe);
+        ::close(after);
+
+        ::setrlimit(RLIMIT_NOFILE, &saved);
+    }
+
+    return check_status();
+}
@@ -0,0 +1,172 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_minibatch.cpp
+ *
+ * Description:
+ *      Row sources of the mini-batch solver, streamed against in-memory fits
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "minibatch.hpp"
+#include "logreg.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+namespace
+{
+
+typedef double real_type;
+typedef num::array2d<real_type> array_type;
+typedef std::valarray<real_type> vector_type;
+typedef num::StreamRowSource<real_type> source_type;
+
+const num::size_type NCOLS{4};
+
+/// "label,id,x1,x2", the intercept is added, comment lines are skipped
+bool parse(const std::string & line, real_type * row, real_type & label)
+{
+    if (line.empty() || line[0] == '#')
+    {
+        return false;
+    }
+
+    const char * p = line.c_str();
+    char * next;
+
+    label = std::strtod(p, &next);
+    row[0] = 1.0;
+    for (num::size_type c{1}; c < NCOLS; ++c)
+    {
+        row[c] = std::strtod(next + 1, &next);
+    }
+    return true;
+}
+
+/// ids (column 1) of the rows of one epoch, in the order they came
+std::vector<real_type> epoch_ids(source_type & source, unsigned int seed)
+{
+    array_type X_block({64, NCOLS}, 0.0);
+    vector_type y_block(64);
+    std::vector<real_type> ids;
+
+    source.rewind(seed);
+    for (num::size_type nrows; (nrows = source.next(X_block, y_block)) != 0;)
+    {
+        for (num::size_type r{0}; r < nrows; ++r)
+        {
+            ids.push_back(X_block.data()[r * NCOLS + 1]);
+        }
+    }
+    return ids;
+}
+
+}  // namespace
+
+int main(void)
+{
+    const num::size_type NROWS{3000};
+
+    std::mt19937 gen(1);
+    std::normal_distribution<real_type> normal;
+    std::uniform_real_distribution<real_type> uniform(0.0, 1.0);
+
+    // the same rows as text and in memory; ids are small, so that they
+    // do not dominate the fit
+    std::ostringstream text;
+    array_type X({NROWS, NCOLS}, 1.0);
+    vector_type y(NROWS);
+
+    text << "# label,id,x1,x2\n";
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        const vector_type row = {1.0, (real_type)r / NROWS, normal(gen), normal(gen)};
+        const real_type label = uniform(gen) < 1.0 / (1.0 + std::exp(-(0.5 + row[2] - 2.0 * row[3])));
+
+        X[X.row(r)] = row;
+        y[r] = label;
+
+        text.precision(17);
+        text << label << ',' << row[1] << ',' << row[2] << ',' << row[3] << '\n';
+        if (r == NROWS / 2)
+        {
+            text << "# skipped\n\n";
+        }
+    }
+
+    std::istringstream is(text.str());
+
+    // every row once per epoch, whatever the buffer capacity
+    for (num::size_type capacity : {1, 7, 256, 100000})
+    {
+        source_type source(is, NCOLS, parse, capacity);
+
+        std::vector<real_type> ids = epoch_ids(source, 1);
+        const std::vector<real_type> again = epoch_ids(source, 1);
+
+        CHECK(ids.size() == NROWS);
+        CHECK(ids == again);
+
+        if (capacity == 1)
+        {
+            // nothing to shuffle with, rows come in file order
+            CHECK(std::is_sorted(ids.cbegin(), ids.cend()));
+        }
+        else
+        {
+            CHECK(!std::is_sorted(ids.cbegin(), ids.cend()));
+            CHECK(epoch_ids(source, 2) != ids);
+        }
+
+        std::sort(ids.begin(), ids.end());
+        CHECK(std::adjacent_find(ids.cbegin(), ids.cend()) == ids.cend());
+        CHECK(std::abs(ids.front()) < 1e-15 && std::abs(ids.back() - (NROWS - 1.0) / NROWS) < 1e-15);
+    }
+
+    // a streamed fit gets as close to the optimum as an in-memory one
+    const real_type C{1.0};
+    const vector_type theta0(0.0, NCOLS);
+    const num::MiniBatchCfg<real_type> cfg = num::MiniBatchCfg<real_type>().epochs(20).batch_size(64).learning_rate(0.05);
+
+    auto cost = [&](const vector_type & theta) -> real_type
+    {
+        return num::logreg_cost_grad(theta, X, y, C).first;
+    };
+
+    num::LogisticRegression<real_type> clf(array_type(X), vector_type(y), vector_type(theta0), C, 200);
+    const real_type optimum = cost(clf.fit());
+
+    num::ArrayRowSource<real_type> array_source(X, y);
+    const real_type in_memory = cost(num::minibatch_fit(array_source, theta0, C, cfg));
+
+    source_type stream_source(is, NCOLS, parse, 256);
+    num::size_type rows_visited{0};
+    const real_type streamed = cost(num::minibatch_fit(stream_source, theta0, C, cfg, &rows_visited));
+
+    CHECK(rows_visited == 20 * NROWS);
+    CHECK(streamed - optimum < 1e-3 * optimum);
+    CHECK(in_memory - optimum < 1e-3 * optimum);
+
+    return check_status();
+}
@@ -0,0 +1,186 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_model.cpp
+ *
+ * Description:
+ *      Serialized model read back in memory and from a mapped file
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "model.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace
+{
+
+typedef std::valarray<double> vector_type;
+
+bool same_model(const num::ModelView & view, const vector_type & theta, const vector_type & mu, const vector_type & dev)
+{
+    return view.ncols() == theta.size()
+        && max_abs_diff(vector_type(view.theta(), view.ncols()), theta) == 0
+        && max_abs_diff(vector_type(view.mu(), view.ncols()), mu) == 0
+        && max_abs_diff(vector_type(view.dev(), view.ncols()), dev) == 0;
+}
+
+bool rejected(const std::vector<std::uint64_t> & words, num::size_type nbytes)
+{
+    try
+    {
+        num::ModelView view(words.data(), nbytes);
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main(void)
+{
+    const vector_type theta = {-1.5, 0.25, 2.0, -0.75};
+    const vector_type mu = {0.0, 0.1, 3.0, -2.0};
+    const vector_type dev = {1.0, 0.5, 2.0, 4.0};
+
+    // key -> (occurrences, events)
+    const num::density_counts_type tables = {
+        {1, {{-1.0, {5.0, 1.0}}, {3.0, {20.0, 1.0}}, {7.0, {5.0, 2.0}}}},
+        {3, {{0.0, {10.0, 1.0}}}}
+    };
+
+    const std::vector<std::uint64_t> words = num::serialize_model(theta, mu, dev, tables, 40);
+
+    const num::ModelView view(words.data(), words.size() * sizeof (std::uint64_t));
+
+    CHECK(same_model(view, theta, mu, dev));
+    CHECK(view.version() == num::MODEL_VERSION);
+    CHECK(view.nrows() == 40);
+    CHECK(view.tables().size() == 2);
+    CHECK(view.tables()[0].column == 1 && view.tables()[0].size == 3);
+    CHECK(view.tables()[1].column == 3 && view.tables()[1].size == 1);
+    CHECK(view.tables()[0].occurrences[1] == 20.0 && view.tables()[0].events[2] == 2.0);
+    CHECK(view.tables()[0].lookup(3.0) == 0.05);
+    CHECK(view.tables()[0].lookup(7.0) == 0.4);
+    // keys not seen during training
+    CHECK(view.tables()[0].lookup(5.0) == 0.0);
+    CHECK(view.tables()[0].lookup(8.0) == 0.0);
+
+    // raw rows through the densities and standardization, then margins
+    num::array2d<double> X({2, 4}, 1.0);
+    const vector_type row0 = {1.0, 7.0, 4.0, 0.0};
+    const vector_type row1 = {1.0, 2.0, -1.0, 5.0};
+    X[X.row(0)] = row0;
+    X[X.row(1)] = row1;
+
+    view.encode(X);
+
+    const vector_type encoded0 = {1.0, (0.4 - 0.1) / 0.5, (4.0 - 3.0) / 2.0, (0.1 + 2.0) / 4.0};
+    const vector_type encoded1 = {1.0, (0.0 - 0.1) / 0.5, (-1.0 - 3.0) / 2.0, (0.0 + 2.0) / 4.0};
+    CHECK(max_abs_diff(vector_type(X[X.row(0)]), encoded0) < 1e-15);
+    CHECK(max_abs_diff(vector_type(X[X.row(1)]), encoded1) < 1e-15);
+
+    const vector_type margins = view.margins(X);
+    CHECK(std::abs(margins[0] - (encoded0 * theta).sum()) < 1e-15);
+    CHECK(std::abs(margins[1] - (encoded1 * theta).sum()) < 1e-15);
+
+    // the same through a file
+    char path[] = "/tmp/test_model.XXXXXX";
+    const int fd = ::mkstemp(path);
+    CHECK(fd >= 0);
+    ::close(fd);
+
+    num::save_model(path, words);
+    {
+        const num::MappedModel mapped(path);
+        CHECK(same_model(mapped.view(), theta, mu, dev));
+        CHECK(mapped.view().tables().size() == 2);
+        CHECK(mapped.view().tables()[0].lookup(-1.0) == 0.2);
+    }
+    std::remove(path);
+
+    // every truncation of the file is rejected
+    for (num::size_type nwords{0}; nwords < words.size(); ++nwords)
+    {
+        CHECK(rejected(words, nwords * sizeof (std::uint64_t)));
+    }
+
+    std::vector<std::uint64_t> bad_magic(words);
+    bad_magic[0] ^= 1;
+    CHECK(rejected(bad_magic, bad_magic.size() * sizeof (std::uint64_t)));
+
+    std::vector<std::uint64_t> bad_column(words);
+    bad_column[5 + 3 * theta.size()] = theta.size();
+    CHECK(rejected(bad_column, bad_column.size() * sizeof (std::uint64_t)));
+
+    // counts so large that offsets past them wrap around
+    const std::uint64_t HUGE_COUNTS[] = {~0ULL, ~0ULL - 4, 1ULL << 61, 1ULL << 63};
+    // size words of the two tables, the first one has 3 entries
+    const num::size_type TABLE_SIZE_AT[] = {5 + 3 * theta.size() + 1, 5 + 3 * theta.size() + 2 + 4 * 3 + 1};
+
+    for (const std::uint64_t count : HUGE_COUNTS)
+    {
+        std::vector<std::uint64_t> huge_ncols(words);
+        huge_ncols[2] = count;
+        CHECK(rejected(huge_ncols, huge_ncols.size() * sizeof (std::uint64_t)));
+
+        std::vector<std::uint64_t> huge_ntables(words);
+        huge_ntables[3] = count;
+        CHECK(rejected(huge_ntables, huge_ntables.size() * sizeof (std::uint64_t)));
+
+        for (const num::size_type at : TABLE_SIZE_AT)
+        {
+            std::vector<std::uint64_t> huge_table(words);
+            huge_table[at] = count;
+            CHECK(rejected(huge_table, huge_table.size() * sizeof (std::uint64_t)));
+        }
+    }
+
+    // and a truncated model file on disk
+    {
+        char truncated_path[] = "/tmp/test_model.XXXXXX";
+        const int truncated_fd = ::mkstemp(truncated_path);
+        CHECK(truncated_fd >= 0);
+        ::close(truncated_fd);
+
+        num::save_model(truncated_path, std::vector<std::uint64_t>(words.begin(), words.end() - 1));
+
+        bool thrown{false};
+        try
+        {
+            const num::MappedModel mapped(truncated_path);
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        CHECK(thrown);
+
+        std::remove(truncated_path);
+    }
+
+    return check_status();
+}
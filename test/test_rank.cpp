@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_rank.cpp
+ *
+ * Description:
+ *      Radix ranks and top-K ranks against a comparison sort
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "rank.hpp"
+#include "check.hpp"
+
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+namespace
+{
+
+/// 1-based ranks, highest score first, ties in index order
+template<typename _ValueType>
+std::vector<int> reference_ranks(const std::vector<_ValueType> & scores)
+{
+    std::vector<int> index(scores.size());
+    std::iota(index.begin(), index.end(), 0);
+    std::stable_sort(index.begin(), index.end(),
+        [&scores](int p, int q)
+        {
+            return scores[p] > scores[q];
+        }
+    );
+
+    std::vector<int> ranks(scores.size());
+    for (std::size_t pos{0}; pos < index.size(); ++pos)
+    {
+        ranks[index[pos]] = pos + 1;
+    }
+    return ranks;
+}
+
+/// scores of both signs, many ties, zeros of both signs, extremes;
+/// no denormals, -ffast-math compares them as zeros
+template<typename _ValueType>
+std::vector<_ValueType> make_scores(std::size_t n, std::mt19937 & gen)
+{
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::uniform_int_distribution<int> level(-20, 20);
+    std::normal_distribution<_ValueType> normal(0.0, 1e3);
+
+    std::vector<_ValueType> scores(n);
+    for (auto & score : scores)
+    {
+        switch (kind(gen))
+        {
+        case 0:
+            score = 0.0;
+            break;
+        case 1:
+            score = -0.0;
+            break;
+        case 2:
+            score = level(gen) * 0.125;
+            break;
+        case 3:
+            score = level(gen) < 0 ? std::numeric_limits<_ValueType>::lowest() : std::numeric_limits<_ValueType>::max();
+            break;
+        default:
+            score = normal(gen);
+            break;
+        }
+    }
+    return scores;
+}
+
+template<typename _ValueType>
+void check_ranks(std::mt19937 & gen)
+{
+    for (const std::size_t n : {0, 1, 2, 17, 1000, 100000})
+    {
+        const std::vector<_ValueType> scores = make_scores<_ValueType>(n, gen);
+        const std::vector<int> expected = reference_ranks(scores);
+
+        CHECK(num::ranks_descending(scores.data(), n) == expected);
+        CHECK(num::ranks_descending(scores.data(), n, 4) == expected);
+
+        for (const std::size_t k : {std::size_t(0), std::size_t(1), n / 3, n, n + 5})
+        {
+            const std::vector<int> top = num::ranks_descending_top_k(scores.data(), n, k);
+
+            // the k best exactly, the rest after them in index order
+            const std::size_t kk = std::min(k, n);
+            std::vector<int> rest;
+            bool exact{true};
+            for (std::size_t i{0}; i < n; ++i)
+            {
+                if ((std::size_t)expected[i] <= kk)
+                {
+                    exact = exact && top[i] == expected[i];
+                }
+                else
+                {
+                    rest.push_back(top[i]);
+                }
+            }
+            std::vector<int> in_order(n - kk);
+            std::iota(in_order.begin(), in_order.end(), kk + 1);
+
+            CHECK(exact);
+            CHECK(rest == in_order);
+        }
+    }
+}
+
+}  // namespace
+
+int main(void)
+{
+    std::mt19937 gen(1);
+
+    check_ranks<double>(gen);
+    check_ranks<float>(gen);
+
+    return check_status();
+}
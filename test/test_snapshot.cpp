@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_snapshot.cpp
+ *
+ * Description:
+ *      Snapshot publishing and per-thread snapshot readers
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "snapshot.hpp"
+#include "bench_model.hpp"
+#include "check.hpp"
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+int main(void)
+{
+    std::mt19937 gen(1);
+    const std::vector<std::uint64_t> words = num::synthetic_model(gen);
+
+    auto make = [&words](std::uint64_t generation)
+    {
+        return std::make_shared<const num::ModelSnapshot>(std::vector<std::uint64_t>(words), generation);
+    };
+
+    num::SnapshotHandle handle(make(0));
+    CHECK(handle.generation() == 0);
+
+    num::SnapshotReader reader(handle);
+    const num::ModelSnapshot * first = reader.get().get();
+    CHECK(first == handle.get().get());
+    CHECK(reader.get().get() == first);
+
+    // the reader keeps the snapshot it returned alive until it picks up
+    // the next one
+    const std::weak_ptr<const num::ModelSnapshot> weak_first(reader.get());
+    handle.publish(make(1));
+    CHECK(handle.generation() == 1);
+    CHECK(!weak_first.expired());
+    CHECK(reader.get()->generation() == 1);
+    CHECK(weak_first.expired());
+
+    // readers never go back to an older snapshot, and all see the last one
+    constexpr num::size_type NREADERS{4};
+    constexpr std::uint64_t NPUBLISH{500};
+
+    std::atomic<bool> stop{false};
+    std::atomic<num::size_type> stale_reads{0};
+    std::atomic<num::size_type> final_generation_seen{0};
+    std::vector<std::thread> threads;
+
+    for (num::size_type t{0}; t < NREADERS; ++t)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                num::SnapshotReader reader(handle);
+                std::uint64_t last{0};
+                std::vector<double> row(reader.get()->nfeatures(), 1.0);
+                double margin;
+
+                while (true)
+                {
+                    const bool stopping = stop.load();
+                    const num::ModelSnapshot & snapshot = *reader.get();
+
+                    if (snapshot.generation() < last)
+                    {
+                        ++stale_reads;
+                    }
+                    last = snapshot.generation();
+                    snapshot.margins(row.data(), 1, &margin);
+
+                    if (stopping)
+                    {
+                        break;
+                    }
+                }
+
+                if (last == NPUBLISH)
+                {
+                    ++final_generation_seen;
+                }
+            }
+        );
+    }
+
+    for (std::uint64_t g{2}; g <= NPUBLISH; ++g)
+    {
+        handle.publish(make(g));
+    }
+    stop = true;
+
+    for (auto & thread : threads)
+    {
+        thread.join();
+    }
+
+    CHECK(stale_reads == 0);
+    CHECK(final_generation_seen == NREADERS);
+    CHECK(handle.generation() == NPUBLISH);
+
+    return check_status();
+}
@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * Copyright (c) 2015 Wojciech Migda
+ * All rights reserved
+ * Distributed under the terms of the GNU LGPL v3
+ *******************************************************************************
+ *
+ * Filename: test_weights.cpp
+ *
+ * Description:
+ *      Collapsed repeats against the records they stand for
+ *
+ * Authors:
+ *          Wojciech Migda (wm)
+ *
+ *******************************************************************************
+ * History:
+ * --------
+ * Date         Who  Ticket     Description
+ * ----------   ---  ---------  ------------------------------------------------
+ * 2026-10-18   wm              Initial version
+ *
+ ******************************************************************************/
+
+#include "weights.hpp"
+#include "logreg.hpp"
+#include "check.hpp"
+
+#include <valarray>
+#include <vector>
+#include <random>
+#include <tuple>
+#include <algorithm>
+
+int main(void)
+{
+    typedef double real_type;
+    typedef num::array2d<real_type> array_type;
+    typedef std::valarray<real_type> vector_type;
+
+    const num::size_type NUNIQUE{300};
+    const num::size_type NCOLS{5};
+
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> level(0, 9);
+    std::uniform_int_distribution<int> repeats(1, 4);
+
+    // unique records, some of them repeated, one feature row also with
+    // the other label; all rows shuffled so that no repeat is adjacent
+    // to its original
+    std::vector<vector_type> rows;
+    std::vector<real_type> labels;
+    std::vector<num::size_type> counts;
+    for (num::size_type u{0}; u < NUNIQUE; ++u)
+    {
+        vector_type row(1.0, NCOLS);
+        row[1] = u;
+        for (num::size_type c{2}; c < NCOLS; ++c)
+        {
+            row[c] = level(gen);
+        }
+        rows.push_back(row);
+        labels.push_back(u % 7 == 0);
+        counts.push_back(repeats(gen));
+    }
+    rows.push_back(rows[1]);
+    labels.push_back(1.0 - labels[1]);
+    counts.push_back(2);
+
+    std::vector<num::size_type> records;
+    for (num::size_type u{0}; u < rows.size(); ++u)
+    {
+        records.insert(records.end(), counts[u], u);
+    }
+    std::shuffle(records.begin(), records.end(), gen);
+
+    const num::size_type NROWS = records.size();
+    array_type X({NROWS, NCOLS}, 0.0);
+    vector_type y(NROWS);
+    for (num::size_type r{0}; r < NROWS; ++r)
+    {
+        X[X.row(r)] = rows[records[r]];
+        y[r] = labels[records[r]];
+    }
+
+    const auto collapsed = num::collapse_repeats(X, y);
+    const array_type & X_c = std::get<0>(collapsed);
+    const vector_type & y_c = std::get<1>(collapsed);
+    const num::RunLengthWeights<float> & weights = std::get<2>(collapsed);
+
+    CHECK(X_c.shape().first == rows.size());
+    CHECK(y_c.size() == rows.size());
+    CHECK(weights.size() == rows.size());
+    CHECK(weights.sum() == NROWS);
+    // one run per distinct count
+    CHECK(weights.nruns() == 4);
+
+    // every collapsed row carries the count of its record
+    std::vector<real_type> weight_of(rows.size());
+    weights.for_each_run(
+        [&weight_of](num::size_type rbegin, num::size_type rend, float w)
+        {
+            std::fill(weight_of.begin() + rbegin, weight_of.begin() + rend, w);
+        }
+    );
+    for (num::size_type r{0}; r < X_c.shape().first; ++r)
+    {
+        const vector_type row = X_c[X_c.row(r)];
+
+        num::size_type u{0};
+        while (u < rows.size() && !(max_abs_diff(rows[u], row) == 0.0 && labels[u] == y_c[r]))
+        {
+            ++u;
+        }
+
+        CHECK(u < rows.size() && weight_of[r] == counts[u]);
+    }
+
+    // the weighted cost of collapsed rows is the cost of the records
+    vector_type theta(NCOLS);
+    for (num::size_type c{0}; c < NCOLS; ++c)
+    {
+        theta[c] = 0.1 * c - 0.2;
+    }
+
+    real_type cost;
+    vector_type grad(NCOLS);
+    vector_type tcol(NROWS);
+    num::logreg_cost_grad(cost, grad, tcol, theta, X, y, 0.5);
+
+    real_type cost_c;
+    vector_type grad_c(NCOLS);
+    vector_type tcol_c(X_c.shape().first);
+    num::logreg_weighted_cost_grad(cost_c, grad_c, tcol_c, theta, X_c, y_c, weights, 0.5);
+
+    CHECK(std::abs(cost_c - cost) < 1e-12);
+    CHECK(max_abs_diff(grad_c, grad) < 1e-12);
+
+    return check_status();
+}